@@ -7,8 +7,12 @@ set(llfio_HEADERS
   "include/llfio/ntkernel-error-category/include/config.hpp"
   "include/llfio/ntkernel-error-category/include/ntkernel_category.hpp"
   "include/llfio/revision.hpp"
+  "include/llfio/v2.0/algorithm/copy_file.hpp"
+  "include/llfio/v2.0/algorithm/handle_adapter/adaptive_read.hpp"
+  "include/llfio/v2.0/algorithm/handle_adapter/bounce_buffering.hpp"
   "include/llfio/v2.0/algorithm/handle_adapter/cached_parent.hpp"
   "include/llfio/v2.0/algorithm/handle_adapter/combining.hpp"
+  "include/llfio/v2.0/algorithm/handle_adapter/writeback_pacing.hpp"
   "include/llfio/v2.0/algorithm/handle_adapter/xor.hpp"
   "include/llfio/v2.0/algorithm/shared_fs_mutex/atomic_append.hpp"
   "include/llfio/v2.0/algorithm/shared_fs_mutex/base.hpp"
@@ -17,6 +21,7 @@ set(llfio_HEADERS
   "include/llfio/v2.0/algorithm/shared_fs_mutex/memory_map.hpp"
   "include/llfio/v2.0/algorithm/shared_fs_mutex/safe_byte_ranges.hpp"
   "include/llfio/v2.0/algorithm/trivial_vector.hpp"
+  "include/llfio/v2.0/algorithm/virtual_ring_buffer.hpp"
   "include/llfio/v2.0/async_file_handle.hpp"
   "include/llfio/v2.0/config.hpp"
   "include/llfio/v2.0/detail/impl/posix/import.hpp"
@@ -28,6 +33,7 @@ set(llfio_HEADERS
   "include/llfio/v2.0/handle.hpp"
   "include/llfio/v2.0/io_handle.hpp"
   "include/llfio/v2.0/io_service.hpp"
+  "include/llfio/v2.0/lazy_section_handle.hpp"
   "include/llfio/v2.0/llfio.hpp"
   "include/llfio/v2.0/logging.hpp"
   "include/llfio/v2.0/map_handle.hpp"
@@ -46,8 +52,12 @@ set(llfio_HEADERS
   "include/llfio/version.hpp"
   "include/llfio/ntkernel-error-category/include/detail/ntkernel-table.ipp"
   "include/llfio/ntkernel-error-category/include/detail/ntkernel_category_impl.ipp"
+  "include/llfio/v2.0/detail/impl/bounce_buffering_handle_adapter.ipp"
   "include/llfio/v2.0/detail/impl/cached_parent_handle_adapter.ipp"
   "include/llfio/v2.0/detail/impl/fast_random_file_handle.ipp"
+  "include/llfio/v2.0/detail/impl/file_handle.ipp"
+  "include/llfio/v2.0/detail/impl/lazy_section_handle.ipp"
+  "include/llfio/v2.0/detail/impl/map_handle.ipp"
   "include/llfio/v2.0/detail/impl/path_discovery.ipp"
   "include/llfio/v2.0/detail/impl/posix/async_file_handle.ipp"
   "include/llfio/v2.0/detail/impl/posix/directory_handle.ipp"
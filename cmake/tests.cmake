@@ -9,23 +9,38 @@ set(llfio_TESTS
   "test/tests/section_handle_create_close/kernel_section_handle.cpp.hpp"
   "test/tests/symlink_handle_create_close/kernel_symlink_handle.cpp.hpp"
   "test/tests/async_io.cpp"
+  "test/tests/copy_file.cpp"
   "test/tests/coroutines.cpp"
   "test/tests/current_path.cpp"
   "test/tests/directory_handle_create_close/runner.cpp"
   "test/tests/directory_handle_enumerate/runner.cpp"
   "test/tests/fast_random_file_handle.cpp"
+  "test/tests/file_handle_allocate.cpp"
+  "test/tests/file_handle_clone_extents.cpp"
   "test/tests/file_handle_create_close/runner.cpp"
+  "test/tests/file_handle_deadline_io.cpp"
+  "test/tests/file_handle_extents.cpp"
   "test/tests/file_handle_lock_unlock.cpp"
+  "test/tests/file_handle_prefetch_evict.cpp"
+  "test/tests/handle_adapter_adaptive_read.cpp"
+  "test/tests/handle_adapter_bounce_buffering.cpp"
+  "test/tests/handle_adapter_writeback_pacing.cpp"
   "test/tests/handle_adapter_xor.cpp"
+  "test/tests/io_handle_read_write_all.cpp"
   "test/tests/large_pages.cpp"
+  "test/tests/lazy_section_handle.cpp"
+  "test/tests/map_handle_cache.cpp"
   "test/tests/map_handle_create_close/runner.cpp"
+  "test/tests/map_handle_populate.cpp"
   "test/tests/mapped.cpp"
   "test/tests/path_discovery.cpp"
   "test/tests/path_view.cpp"
   "test/tests/section_handle_create_close/runner.cpp"
   "test/tests/shared_fs_mutex.cpp"
+  "test/tests/stat.cpp"
   "test/tests/symlink_handle_create_close/runner.cpp"
   "test/tests/trivial_vector.cpp"
+  "test/tests/virtual_ring_buffer.cpp"
 )
 # DO NOT EDIT, GENERATED BY SCRIPT
 set(llfio_COMPILE_TESTS
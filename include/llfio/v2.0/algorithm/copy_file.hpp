@@ -0,0 +1,221 @@
+/* Parallel sparse aware file copy
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef LLFIO_ALGORITHM_COPY_FILE_HPP
+#define LLFIO_ALGORITHM_COPY_FILE_HPP
+
+#include "../file_handle.hpp"
+#include "../utils.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! \file copy_file.hpp Provides a parallel sparse aware file copy.
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+namespace algorithm
+{
+  /*! \brief Copies the contents of one file into another using many kernel threads, skipping holes.
+
+  The valid extents of `src` (see `file_handle::extents()`) are split into chunks of `chunk_size`,
+  and `threads` worker threads each repeatedly claim the next chunk, reading it from `src` and writing
+  it to the same offset in `dest` with positional i/o. The holes in `src` are never read, and remain
+  holes in `dest`, which is truncated to zero and then to the length of `src` before copying.
+
+  If either handle requires aligned i/o, which is the case for `caching::only_metadata` and
+  `caching::none`, every read and write is page aligned and whole pages long through the page aligned
+  bounce buffers, and `dest` is truncated to the exact length of `src` afterwards.
+
+  Storage arrays usually need several i/o in flight to reach their bandwidth, so more threads than
+  CPUs can pay off. Each thread allocates one bounce buffer of `chunk_size`.
+
+  \return The bytes of valid extents copied, excluding holes.
+  \param dest The file to copy into, whose contents are replaced.
+  \param src The file to copy from.
+  \param threads The number of threads to use, zero for `std::thread::hardware_concurrency()`.
+  \param chunk_size The bytes of each i/o, rounded up to the page size.
+  \errors `errc::invalid_argument` if `dest` and `src` are the same inode, the first failure of any
+  of the values `read()`, `write()`, `truncate()` and `extents()` can return, `errc::io_error` if the
+  destination accepts no more bytes, any error from creating threads.
+  \mallocs One page allocation of `chunk_size` per thread, plus the list of chunks.
+  */
+  inline result<file_handle::extent_type> copy_file(file_handle &dest, file_handle &src, size_t threads = 0, size_t chunk_size = 4 * 1024 * 1024) noexcept
+  {
+    using extent_type = file_handle::extent_type;
+    // Truncating the destination would destroy the source
+    if(dest.unique_id() == src.unique_id())
+    {
+      return errc::invalid_argument;
+    }
+    const size_t pagesize = utils::page_size();
+    const bool aligned = src.requires_aligned_io() || dest.requires_aligned_io();
+    chunk_size = (std::max)(utils::round_up_to_page_size(chunk_size, pagesize), pagesize);
+    try
+    {
+      OUTCOME_TRY(size, src.maximum_extent());
+      OUTCOME_TRY(exts, src.extents());
+      // Split the extents into chunks, which for aligned i/o begin and end on page boundaries
+      std::vector<std::pair<extent_type, extent_type>> chunks;
+      for(auto &ext : exts)
+      {
+        extent_type begin = ext.first, end = (std::min)(ext.first + ext.second, size);
+        if(aligned)
+        {
+          begin = utils::round_down_to_page_size(begin, pagesize);
+          end = utils::round_up_to_page_size(end, pagesize);
+        }
+        while(begin < end)
+        {
+          const extent_type len = (std::min)(end - begin, static_cast<extent_type>(chunk_size));
+          chunks.emplace_back(begin, len);
+          begin += len;
+        }
+      }
+      OUTCOME_TRYV(dest.truncate(0));
+      OUTCOME_TRYV(dest.truncate(size));
+      if(threads == 0)
+      {
+        threads = (std::max)(std::thread::hardware_concurrency(), 1U);
+      }
+      threads = (std::min)(threads, chunks.size());
+      std::atomic<size_t> next{0};
+      std::atomic<extent_type> copied{0};
+      std::atomic<bool> failed{false};
+      std::mutex failurelock;
+      result<void> failure = success();
+      auto fail = [&](result<void> r) {
+        std::lock_guard<std::mutex> g(failurelock);
+        if(!failed)
+        {
+          failure = std::move(r);
+          failed = true;
+        }
+      };
+      auto worker = [&]() -> result<void> {
+        byte *buffer = utils::page_allocator<byte>().allocate(chunk_size);
+        auto unbufferh = undoer([buffer, chunk_size] { utils::page_allocator<byte>().deallocate(buffer, chunk_size); });
+        (void) unbufferh;
+        for(size_t idx = next++; idx < chunks.size() && !failed; idx = next++)
+        {
+          extent_type offset = chunks[idx].first, togo = chunks[idx].second;
+          while(togo > 0)
+          {
+            OUTCOME_TRY(bytesread, src.read(offset, {{buffer, static_cast<size_t>(togo)}}));
+            if(0 == bytesread)
+            {
+              // The source was truncated concurrently
+              break;
+            }
+            const size_t towrite = aligned ? utils::round_up_to_page_size(bytesread, pagesize) : bytesread;
+            // Writes may be short, so keep going until all of this chunk is written
+            for(size_t done = 0; done < towrite;)
+            {
+              OUTCOME_TRY(written, dest.write(offset + done, {{buffer + done, towrite - done}}));
+              if(0 == written)
+              {
+                return errc::io_error;
+              }
+              done += written;
+            }
+            copied += bytesread;
+            offset += bytesread;
+            togo -= (bytesread < togo) ? bytesread : togo;
+            if(bytesread != towrite)
+            {
+              // Only the final page of the file is partial
+              break;
+            }
+          }
+        }
+        return success();
+      };
+      auto run = [&] {
+        try
+        {
+          auto r = worker();
+          if(!r)
+          {
+            fail(std::move(r));
+          }
+        }
+        catch(...)
+        {
+          fail(error_from_exception());
+        }
+      };
+      std::vector<std::thread> workers;
+      workers.reserve(threads);
+      auto joinh = undoer([&workers] {
+        for(auto &t : workers)
+        {
+          t.join();
+        }
+      });
+      (void) joinh;
+      try
+      {
+        for(size_t n = 1; n < threads; n++)
+        {
+          workers.emplace_back(run);
+        }
+      }
+      catch(...)
+      {
+        // Have the threads already launched stop
+        fail(error_from_exception());
+      }
+      // This thread is a worker too
+      if(threads > 0)
+      {
+        run();
+      }
+      for(auto &t : workers)
+      {
+        t.join();
+      }
+      workers.clear();
+      if(failed)
+      {
+        return std::move(failure).error();
+      }
+      if(aligned)
+      {
+        // Remove the tail of the final page
+        OUTCOME_TRYV(dest.truncate(size));
+      }
+      return copied.load();
+    }
+    catch(...)
+    {
+      return error_from_exception();
+    }
+  }
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
+
+#endif
@@ -0,0 +1,260 @@
+/* A handle which serves reads by syscall or by memory map as appropriate
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef LLFIO_ALGORITHM_HANDLE_ADAPTER_ADAPTIVE_READ_H
+#define LLFIO_ALGORITHM_HANDLE_ADAPTER_ADAPTIVE_READ_H
+
+#include "../../map_handle.hpp"
+
+#include <array>
+#include <list>
+#include <mutex>
+
+//! \file handle_adapter/adaptive_read.hpp Provides `adaptive_read_handle_adapter`.
+
+LLFIO_V2_NAMESPACE_EXPORT_BEGIN
+
+namespace algorithm
+{
+  /*! \brief Adapts any `file_handle` to serve each read either by a read syscall, or from a
+  lazily created read only memory map of the file, whichever ought to be cheaper.
+
+  Small reads of cold data are cheapest done with `preadv()`, as a page fault would read
+  around the faulting page and pollute the cache. Large reads, and reads of data read
+  recently, are cheapest served from a memory map, as then no syscall nor memory copy is
+  needed. This adapter serves a read from the map if it is at least `map_threshold()` bytes,
+  or if it begins in one of the recently read 64Kb blocks of the file which it remembers.
+  Otherwise the read is passed to the adapted handle.
+
+  Reads served from the map return buffers pointing into the map, just as `mapped_file_handle`
+  does, so callers must always use the buffers returned. The map is created on first need,
+  and a new one is made whenever a read extends beyond it because the file has grown, or after
+  `truncate()` to a smaller length. Maps so replaced are kept until `close()`, so buffers
+  returned remain valid until then, no matter what other threads read, at the cost of the
+  address space of each replaced map. Writes pass through to the adapted handle, which is
+  coherent with the map on all supported platforms.
+
+  \warning As with `mapped_file_handle`, if the file is shrunk, by this handle or by a third
+  party, reading a returned buffer beyond the new end of the file will fault. Buffers returned
+  are invalidated by `close()`.
+
+  \todo I have been lazy and used public inheritance from that base i/o handle.
+  I should use protected inheritance to prevent slicing, and expose all the public functions by hand.
+  */
+  template <class T> class adaptive_read_handle_adapter : public T
+  {
+    static_assert(std::is_base_of<file_handle, T>::value, "Type T must be a file_handle for adaptive_read_handle_adapter<T> to map it");
+
+  public:
+    //! The handle type being adapted
+    using adapted_handle_type = T;
+    using extent_type = typename T::extent_type;
+    using size_type = typename T::size_type;
+    using buffers_type = typename T::buffers_type;
+    template <class U> using io_request = typename T::template io_request<U>;
+    template <class U> using io_result = typename T::template io_result<U>;
+
+  protected:
+    static constexpr extent_type _block_size = 65536;
+    size_t _threshold{0};
+    // Not a spinlock, as remapping makes syscalls with it held
+    std::mutex _lock;
+    section_handle _sh;
+    map_handle _mh;
+    // Maps replaced by _mh, kept until close as buffers returned may point into them. A list
+    // as each map points at its section.
+    struct _retired_map_type
+    {
+      section_handle sh;
+      map_handle mh;
+    };
+    std::list<_retired_map_type> _retired;
+    // Recently read block numbers plus one, hashed by block number
+    std::array<extent_type, 64> _recent{};
+    size_t _mapped_reads{0}, _syscall_reads{0};
+
+    // Returns true if the block at offset was read recently, and remembers it as read
+    bool _is_hot(extent_type offset) noexcept
+    {
+      const extent_type block = offset / _block_size;
+      extent_type &slot = _recent[static_cast<size_t>(block % _recent.size())];
+      const bool ret = (slot == block + 1);
+      slot = block + 1;
+      return ret;
+    }
+    // Maps the whole file if the map does not extend to end. Must be called with the lock held.
+    result<void> _map_to(extent_type end) noexcept
+    {
+      if(_mh.is_valid() && _mh.length() >= end)
+      {
+        return success();
+      }
+      OUTCOME_TRY(length, adapted_handle_type::maximum_extent());
+      if(length == 0 || (_mh.is_valid() && _mh.length() >= length))
+      {
+        // Not portable to map an empty file, and the map already covers all there is
+        return success();
+      }
+      OUTCOME_TRY(sh, section_handle::section(*this, length, section_handle::flag::read));
+      OUTCOME_TRY(mh, map_handle::map(sh, static_cast<size_type>(length), 0, section_handle::flag::read));
+      OUTCOME_TRYV(_retire_map());
+      _sh = std::move(sh);
+      _mh = std::move(mh);
+      _mh.set_section(&_sh);
+      return success();
+    }
+    // Keeps the current map until close, if there is one. Must be called with the lock held.
+    result<void> _retire_map() noexcept
+    {
+      if(!_mh.is_valid())
+      {
+        return success();
+      }
+      try
+      {
+        _retired.push_back(_retired_map_type{std::move(_sh), std::move(_mh)});
+        _retired.back().mh.set_section(&_retired.back().sh);
+        return success();
+      }
+      catch(...)
+      {
+        return error_from_exception();
+      }
+    }
+    result<void> _close_map() noexcept
+    {
+      for(auto &i : _retired)
+      {
+        OUTCOME_TRYV(i.mh.close());
+        OUTCOME_TRYV(i.sh.close());
+      }
+      _retired.clear();
+      if(_mh.is_valid())
+      {
+        OUTCOME_TRYV(_mh.close());
+      }
+      if(_sh.is_valid())
+      {
+        OUTCOME_TRYV(_sh.close());
+      }
+      return success();
+    }
+
+  public:
+    adaptive_read_handle_adapter() = default;
+    adaptive_read_handle_adapter(const adaptive_read_handle_adapter &) = delete;
+    adaptive_read_handle_adapter(adaptive_read_handle_adapter &&o) noexcept  // NOLINT
+        : adapted_handle_type(std::move(o))
+        , _threshold(o._threshold)
+        , _sh(std::move(o._sh))
+        , _mh(std::move(o._mh))
+        , _retired(std::move(o._retired))
+        , _recent(o._recent)
+        , _mapped_reads(o._mapped_reads)
+        , _syscall_reads(o._syscall_reads)
+    {
+      _sh.set_backing(this);
+      _mh.set_section(&_sh);
+      for(auto &i : _retired)
+      {
+        i.sh.set_backing(this);
+      }
+    }
+    adaptive_read_handle_adapter &operator=(const adaptive_read_handle_adapter &) = delete;
+    adaptive_read_handle_adapter &operator=(adaptive_read_handle_adapter &&o) noexcept
+    {
+      this->~adaptive_read_handle_adapter();
+      new(this) adaptive_read_handle_adapter(std::move(o));
+      return *this;
+    }
+    //! Adapts a handle to serve reads of at least `map_threshold` bytes, or of recently read blocks, from a map.
+    explicit adaptive_read_handle_adapter(adapted_handle_type &&o, size_t map_threshold = 65536)
+        : adapted_handle_type(std::move(o))
+        , _threshold(map_threshold)
+    {
+    }
+
+    //! The size of read at and above which reads are served from the map.
+    size_t map_threshold() const noexcept { return _threshold; }
+    //! The map currently in use, which may be invalid if none has been needed yet.
+    const map_handle &map() const noexcept { return _mh; }
+    //! The number of reads served from the map.
+    size_t mapped_reads() const noexcept { return _mapped_reads; }
+    //! The number of reads passed to the adapted handle.
+    size_t syscall_reads() const noexcept { return _syscall_reads; }
+
+    //! \brief Closes the map, then the adapted handle.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> close() noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        OUTCOME_TRYV(_close_map());
+      }
+      return adapted_handle_type::close();
+    }
+    //! \brief Truncates as per the adapted handle, replacing the map on the next mapped read if the file is shrinking.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> truncate(extent_type newsize) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      std::lock_guard<decltype(_lock)> g(_lock);
+      if(_mh.is_valid() && newsize < _mh.length())
+      {
+        OUTCOME_TRYV(_retire_map());
+      }
+      return adapted_handle_type::truncate(newsize);
+    }
+
+    using adapted_handle_type::read;
+    //! \brief Reads from the map or from the adapted handle, depending on the size of the read and how recently the data was read.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<buffers_type> read(io_request<buffers_type> reqs, deadline d = deadline()) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      extent_type total = 0;
+      for(const auto &b : reqs.buffers)
+      {
+        total += b.size();
+      }
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        const bool hot = _is_hot(reqs.offset);
+        if(total > 0 && (total >= _threshold || hot))
+        {
+          OUTCOME_TRYV(_map_to(reqs.offset + total));
+          if(_mh.is_valid() && reqs.offset < _mh.length())
+          {
+            ++_mapped_reads;
+            return _mh.read(reqs, d);
+          }
+        }
+        ++_syscall_reads;
+      }
+      return adapted_handle_type::read(reqs, d);
+    }
+  };
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
+
+#endif
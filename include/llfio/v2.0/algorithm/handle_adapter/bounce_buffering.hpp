@@ -0,0 +1,384 @@
+/* A handle which bounces unaligned i/o through aligned buffers
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef LLFIO_ALGORITHM_HANDLE_ADAPTER_BOUNCE_BUFFERING_H
+#define LLFIO_ALGORITHM_HANDLE_ADAPTER_BOUNCE_BUFFERING_H
+
+#include "../../file_handle.hpp"
+#include "../../utils.hpp"
+
+#ifdef __has_include
+#if __has_include("../../quickcpplib/include/spinlock.hpp")
+#include "../../quickcpplib/include/spinlock.hpp"
+#else
+#include "quickcpplib/include/spinlock.hpp"
+#endif
+#elif __PCPP_ALWAYS_TRUE__
+#include "quickcpplib/include/spinlock.hpp"
+#else
+#include "../../quickcpplib/include/spinlock.hpp"
+#endif
+
+#include <array>
+#include <mutex>  // for lock_guard
+
+//! \file handle_adapter/bounce_buffering.hpp Provides `bounce_buffering_handle_adapter`.
+
+LLFIO_V2_NAMESPACE_EXPORT_BEGIN
+
+namespace algorithm
+{
+  namespace detail
+  {
+    /* Returns the memory and file offset alignments required for uncached i/o on the handle.
+    On Linux 6.1 or later this comes from statx(STATX_DIOALIGN), otherwise it is the page size
+    which all the common devices and filing systems accept.
+    */
+    LLFIO_HEADERS_ONLY_FUNC_SPEC result<std::pair<size_t, size_t>> direct_io_alignment(const file_handle &h) noexcept;
+  }  // namespace detail
+
+  /*! \brief Adapts any `file_handle` opened with `caching::none` or `caching::only_metadata` to
+  accept i/o of any alignment.
+
+  Uncached i/o requires the memory, offset and length of every buffer to be aligned to what the
+  device requires, else the i/o fails with `EINVAL`. This adapter passes i/o which is already
+  aligned straight through. Unaligned i/o is rounded out to the required alignment and bounced
+  through a page allocated buffer, in chunks of at most `chunk_size()` bytes. Writes which only
+  partially cover their first or last block read those blocks first, and if they extend the
+  file, the file is truncated back to the end of the write afterwards. Bounce buffers are
+  kept in a small pool for reuse.
+
+  The alignment is queried using `statx(STATX_DIOALIGN)` on Linux 6.1 or later, and is the page
+  size otherwise. Handles which do not require aligned i/o are passed straight through.
+
+  \warning The read-modify-write of partial blocks is not atomic. Concurrent unaligned writes
+  to the same block through different handles, or different threads, can lose one another's
+  data. Use `lock()` or aligned writes if this matters.
+
+  \todo I have been lazy and used public inheritance from that base i/o handle.
+  I should use protected inheritance to prevent slicing, and expose all the public functions by hand.
+  */
+  template <class T> class bounce_buffering_handle_adapter : public T
+  {
+    static_assert(std::is_base_of<file_handle, T>::value, "Type T must be a file_handle for bounce_buffering_handle_adapter<T> to bounce its i/o");
+
+  public:
+    //! The handle type being adapted
+    using adapted_handle_type = T;
+    using extent_type = typename T::extent_type;
+    using size_type = typename T::size_type;
+    using buffer_type = typename T::buffer_type;
+    using const_buffer_type = typename T::const_buffer_type;
+    using buffers_type = typename T::buffers_type;
+    using const_buffers_type = typename T::const_buffers_type;
+    template <class U> using io_request = typename T::template io_request<U>;
+    template <class U> using io_result = typename T::template io_result<U>;
+
+  protected:
+    size_t _memory_alignment{1}, _offset_alignment{1}, _chunk_size{0};
+    QUICKCPPLIB_NAMESPACE::configurable_spinlock::spinlock<bool> _lock;
+    std::array<byte *, 4> _pool{};
+
+    void _init(size_t chunk_size) noexcept
+    {
+      if(this->requires_aligned_io())
+      {
+        auto r = detail::direct_io_alignment(*this);
+        if(r)
+        {
+          _memory_alignment = r.value().first;
+          _offset_alignment = r.value().second;
+        }
+        else
+        {
+          _memory_alignment = _offset_alignment = utils::page_size();
+        }
+      }
+      // The chunk must be a whole number of blocks, and page allocation is in whole pages
+      _chunk_size = utils::round_up_to_page_size((std::max)(chunk_size, _offset_alignment), (std::max)(utils::page_size(), _offset_alignment));
+    }
+    void _free_pool() noexcept
+    {
+      for(auto &i : _pool)
+      {
+        if(i != nullptr)
+        {
+          utils::page_allocator<byte>().deallocate(i, _chunk_size);
+          i = nullptr;
+        }
+      }
+    }
+    result<byte *> _acquire() noexcept
+    {
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        for(auto &i : _pool)
+        {
+          if(i != nullptr)
+          {
+            byte *ret = i;
+            i = nullptr;
+            return ret;
+          }
+        }
+      }
+      try
+      {
+        return utils::page_allocator<byte>().allocate(_chunk_size);
+      }
+      catch(...)
+      {
+        return error_from_exception();
+      }
+    }
+    void _release(byte *buffer) noexcept
+    {
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        for(auto &i : _pool)
+        {
+          if(i == nullptr)
+          {
+            i = buffer;
+            return;
+          }
+        }
+      }
+      utils::page_allocator<byte>().deallocate(buffer, _chunk_size);
+    }
+    template <class BuffersType> bool _is_aligned(const io_request<BuffersType> &reqs) const noexcept
+    {
+      if(_offset_alignment <= 1 && _memory_alignment <= 1)
+      {
+        return true;
+      }
+      if((reqs.offset & (_offset_alignment - 1)) != 0)
+      {
+        return false;
+      }
+      for(const auto &b : reqs.buffers)
+      {
+        if((reinterpret_cast<uintptr_t>(b.data()) & (_memory_alignment - 1)) != 0 || (b.size() & (_offset_alignment - 1)) != 0)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    // Copies between the bounce buffer and the caller's buffers, starting at logical offset pos into the latter
+    template <class BuffersType, class F> static void _copy(BuffersType buffers, size_t pos, size_t bytes, F &&f) noexcept
+    {
+      for(size_t n = 0; n < buffers.size() && bytes > 0; n++)
+      {
+        if(pos >= buffers[n].size())
+        {
+          pos -= buffers[n].size();
+          continue;
+        }
+        const size_t len = (std::min)(buffers[n].size() - pos, bytes);
+        f(buffers[n].data() + pos, len);
+        pos = 0;
+        bytes -= len;
+      }
+    }
+    // Trims the caller's buffers to the bytes transferred
+    template <class BuffersType> static BuffersType _trim(BuffersType buffers, size_t bytes) noexcept
+    {
+      for(size_t n = 0; n < buffers.size(); n++)
+      {
+        if(buffers[n].size() >= bytes)
+        {
+          buffers[n] = {buffers[n].data(), bytes};
+          return {buffers.data(), n + 1};
+        }
+        bytes -= buffers[n].size();
+      }
+      return buffers;
+    }
+    // Reads the block at offset into buffer, zero filling whatever is past the end of the file
+    result<void> _read_block(byte *buffer, extent_type offset, deadline d) noexcept
+    {
+      buffer_type b(buffer, _offset_alignment);
+      OUTCOME_TRY(filled, adapted_handle_type::read({{&b, 1}, offset}, d));
+      const size_t bytes = filled.empty() ? 0 : filled[0].size();
+      if(bytes < _offset_alignment)
+      {
+        memset(buffer + bytes, 0, _offset_alignment - bytes);
+      }
+      return success();
+    }
+
+  public:
+    bounce_buffering_handle_adapter() = default;
+    bounce_buffering_handle_adapter(const bounce_buffering_handle_adapter &) = delete;
+    bounce_buffering_handle_adapter(bounce_buffering_handle_adapter &&o) noexcept  // NOLINT
+        : adapted_handle_type(std::move(o))
+        , _memory_alignment(o._memory_alignment)
+        , _offset_alignment(o._offset_alignment)
+        , _chunk_size(o._chunk_size)
+        , _pool(o._pool)
+    {
+      o._pool = {};
+    }
+    bounce_buffering_handle_adapter &operator=(const bounce_buffering_handle_adapter &) = delete;
+    bounce_buffering_handle_adapter &operator=(bounce_buffering_handle_adapter &&o) noexcept
+    {
+      this->~bounce_buffering_handle_adapter();
+      new(this) bounce_buffering_handle_adapter(std::move(o));
+      return *this;
+    }
+    //! Adapts a handle to bounce unaligned i/o through buffers of `chunk_size` bytes.
+    explicit bounce_buffering_handle_adapter(adapted_handle_type &&o, size_t chunk_size = 1024 * 1024)
+        : adapted_handle_type(std::move(o))
+    {
+      _init(chunk_size);
+    }
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~bounce_buffering_handle_adapter() override { _free_pool(); }
+
+    //! The alignment of memory required for uncached i/o, or one if the handle does not require aligned i/o.
+    size_t memory_alignment() const noexcept { return _memory_alignment; }
+    //! The alignment of file offsets and lengths required for uncached i/o, or one if the handle does not require aligned i/o.
+    size_t offset_alignment() const noexcept { return _offset_alignment; }
+    //! The maximum bytes bounced per i/o.
+    size_t chunk_size() const noexcept { return _chunk_size; }
+
+    using adapted_handle_type::read;
+    using adapted_handle_type::write;
+    //! \brief Reads as per the adapted handle, bouncing the i/o if it is not suitably aligned.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<buffers_type> read(io_request<buffers_type> reqs, deadline d = deadline()) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      if(_is_aligned(reqs))
+      {
+        return adapted_handle_type::read(reqs, d);
+      }
+      OUTCOME_TRY(buffer, _acquire());
+      auto unbuffer = undoer([this, buffer] { _release(buffer); });
+      (void) unbuffer;
+      extent_type total = 0;
+      for(const auto &b : reqs.buffers)
+      {
+        total += b.size();
+      }
+      const extent_type end = reqs.offset + total;
+      extent_type pos = reqs.offset;
+      while(pos < end)
+      {
+        const extent_type cs = pos & ~static_cast<extent_type>(_offset_alignment - 1);
+        const extent_type ce = (std::min)((end + _offset_alignment - 1) & ~static_cast<extent_type>(_offset_alignment - 1), cs + _chunk_size);
+        const size_t skip = static_cast<size_t>(pos - cs);
+        buffer_type b(buffer, static_cast<size_type>(ce - cs));
+        OUTCOME_TRY(filled, adapted_handle_type::read({{&b, 1}, cs, reqs.priority}, d));
+        const size_t bytes = filled.empty() ? 0 : filled[0].size();
+        if(bytes <= skip)
+        {
+          break;
+        }
+        const size_t avail = (std::min)(bytes - skip, static_cast<size_t>((std::min)(ce, end) - pos));
+        const byte *src = filled[0].data() + skip;
+        _copy(reqs.buffers, static_cast<size_t>(pos - reqs.offset), avail, [&src](byte *dest, size_t len) {
+          memcpy(dest, src, len);
+          src += len;
+        });
+        pos += avail;
+        if(cs + bytes < ce)
+        {
+          // End of file
+          break;
+        }
+      }
+      return {_trim(reqs.buffers, static_cast<size_t>(pos - reqs.offset))};
+    }
+    //! \brief Writes as per the adapted handle, bouncing the i/o if it is not suitably aligned.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<const_buffers_type> write(io_request<const_buffers_type> reqs, deadline d = deadline()) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      if(_is_aligned(reqs))
+      {
+        return adapted_handle_type::write(reqs, d);
+      }
+      OUTCOME_TRY(buffer, _acquire());
+      auto unbuffer = undoer([this, buffer] { _release(buffer); });
+      (void) unbuffer;
+      extent_type total = 0;
+      for(const auto &b : reqs.buffers)
+      {
+        total += b.size();
+      }
+      const extent_type end = reqs.offset + total;
+      const extent_type alignedend = (end + _offset_alignment - 1) & ~static_cast<extent_type>(_offset_alignment - 1);
+      extent_type size = 0;
+      if(alignedend != end)
+      {
+        OUTCOME_TRY(_size, this->maximum_extent());
+        size = _size;
+      }
+      extent_type pos = reqs.offset;
+      while(pos < end)
+      {
+        const extent_type cs = pos & ~static_cast<extent_type>(_offset_alignment - 1);
+        const extent_type ce = (std::min)(alignedend, cs + _chunk_size);
+        const size_t skip = static_cast<size_t>(pos - cs);
+        const size_t bytes = static_cast<size_t>((std::min)(ce, end) - pos);
+        // Read modify write any partially covered blocks
+        if(skip > 0)
+        {
+          OUTCOME_TRYV(_read_block(buffer, cs, d));
+        }
+        if(pos + bytes < ce && (skip == 0 || ce - cs > _offset_alignment))
+        {
+          OUTCOME_TRYV(_read_block(buffer + (ce - cs) - _offset_alignment, ce - _offset_alignment, d));
+        }
+        byte *dest = buffer + skip;
+        _copy(reqs.buffers, static_cast<size_t>(pos - reqs.offset), bytes, [&dest](const byte *src, size_t len) {
+          memcpy(dest, src, len);
+          dest += len;
+        });
+        const_buffer_type b(buffer, static_cast<size_type>(ce - cs));
+        OUTCOME_TRY(written, adapted_handle_type::write({{&b, 1}, cs, reqs.priority}, d));
+        if(written.empty() || written[0].size() < ce - cs)
+        {
+          return errc::io_error;
+        }
+        pos += bytes;
+      }
+      if(alignedend != end && alignedend > size)
+      {
+        // Remove the padding written past the end of the file
+        OUTCOME_TRYV(this->truncate((std::max)(size, end)));
+      }
+      return {reqs.buffers};
+    }
+  };
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
+
+#if LLFIO_HEADERS_ONLY == 1 && !defined(DOXYGEN_SHOULD_SKIP_THIS)
+#define LLFIO_INCLUDED_BY_HEADER 1
+#include "../../detail/impl/bounce_buffering_handle_adapter.ipp"
+#undef LLFIO_INCLUDED_BY_HEADER
+#endif
+
+#endif
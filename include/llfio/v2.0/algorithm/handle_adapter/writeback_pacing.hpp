@@ -0,0 +1,257 @@
+/* A handle which paces writeback of the data written through it
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef LLFIO_ALGORITHM_HANDLE_ADAPTER_WRITEBACK_PACING_H
+#define LLFIO_ALGORITHM_HANDLE_ADAPTER_WRITEBACK_PACING_H
+
+#include "../../file_handle.hpp"
+
+#ifdef __has_include
+#if __has_include("../../quickcpplib/include/spinlock.hpp")
+#include "../../quickcpplib/include/spinlock.hpp"
+#else
+#include "quickcpplib/include/spinlock.hpp"
+#endif
+#elif __PCPP_ALWAYS_TRUE__
+#include "quickcpplib/include/spinlock.hpp"
+#else
+#include "../../quickcpplib/include/spinlock.hpp"
+#endif
+
+#include <atomic>
+#include <mutex>  // for lock_guard
+
+#ifdef __linux__
+#include <fcntl.h>  // for sync_file_range
+#endif
+
+//! \file handle_adapter/writeback_pacing.hpp Provides `writeback_pacing_handle_adapter`.
+
+LLFIO_V2_NAMESPACE_EXPORT_BEGIN
+
+namespace algorithm
+{
+  /*! \brief Adapts any `file_handle` to start writeback of the data written through it every
+  `window` bytes, rather than leaving it all to be flushed at once.
+
+  Without this, dirty pages accumulate in the kernel page cache until either the kernel's
+  dirty thresholds are hit, at which point the writing thread is throttled, or a `barrier()` is
+  issued, which must then wait for all of them to reach storage. For write heavy workloads,
+  either can produce stalls of hundreds of milliseconds.
+
+  Every time `window` bytes have been written through this adapter, the range of the file
+  covering them is submitted for writeback with `sync_file_range(SYNC_FILE_RANGE_WRITE)`, which
+  queues the i/o and returns without waiting for it. A later `barrier()` then only has to
+  wait for whatever was written since. If `throttle` is set, the writing thread also waits for
+  the writeback of the previous window to complete, bounding the dirty data of this handle to
+  around two windows at the cost of write latency.
+
+  Writeback pacing is only implemented on Linux. On other platforms this adapter passes writes
+  straight through. Errors from paced writeback are not reported by `write()`, they are
+  reported by the next `barrier()` as they would have been anyway.
+
+  The dirty range tracked is the span covering all writes since the last writeback was started,
+  so random writes scattered across a large file will have the whole span scanned for dirty
+  pages. Writes to mapped views of the file are not seen by this adapter.
+
+  \todo I have been lazy and used public inheritance from that base i/o handle.
+  I should use protected inheritance to prevent slicing, and expose all the public functions by hand.
+  */
+  template <class T> class writeback_pacing_handle_adapter : public T
+  {
+    static_assert(std::is_base_of<file_handle, T>::value, "Type T must be a file_handle for writeback_pacing_handle_adapter<T> to pace its writeback");
+
+  public:
+    //! The handle type being adapted
+    using adapted_handle_type = T;
+    using extent_type = typename T::extent_type;
+    using size_type = typename T::size_type;
+    using const_buffer_type = typename T::const_buffer_type;
+    using const_buffers_type = typename T::const_buffers_type;
+    template <class U> using io_request = typename T::template io_request<U>;
+    template <class U> using io_result = typename T::template io_result<U>;
+
+  protected:
+    struct _range_type
+    {
+      extent_type begin{static_cast<extent_type>(-1)}, end{0};
+      bool empty() const noexcept { return begin >= end; }
+    };
+    // Read without _lock by write() and the observers, so atomic
+    std::atomic<extent_type> _window{0};
+    std::atomic<bool> _throttle{false};
+    QUICKCPPLIB_NAMESPACE::configurable_spinlock::spinlock<bool> _lock;
+    _range_type _dirty, _previous;
+    extent_type _dirty_bytes{0};
+    std::atomic<size_t> _writebacks{0};
+
+    // Starts writeback of the range, optionally waiting for it to complete
+    void _writeback(_range_type range, bool wait) noexcept
+    {
+#ifdef __linux__
+      // Not barrier(), which falls back onto a blocking fdatasync() if this fails. Failure is
+      // ignored, as the kernel will write the range back anyway and the next barrier() reports
+      // any i/o error.
+      unsigned flags = SYNC_FILE_RANGE_WRITE;
+      if(wait)
+      {
+        flags |= SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WAIT_AFTER;
+      }
+      (void) ::sync_file_range(this->native_handle().fd, range.begin, range.end - range.begin, flags);
+#else
+      (void) range;
+      (void) wait;
+#endif
+    }
+    void _written(extent_type offset, extent_type bytes) noexcept
+    {
+      _range_type kick, previous;
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        if(offset < _dirty.begin)
+        {
+          _dirty.begin = offset;
+        }
+        if(offset + bytes > _dirty.end)
+        {
+          _dirty.end = offset + bytes;
+        }
+        _dirty_bytes += bytes;
+        if(_dirty_bytes < _window.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+        kick = _dirty;
+        previous = _previous;
+        _previous = _dirty;
+        _dirty = _range_type();
+        _dirty_bytes = 0;
+        _writebacks.fetch_add(1, std::memory_order_relaxed);
+      }
+      // Start the new window writing before waiting on the old one, so the device is never idle
+      _writeback(kick, false);
+      if(_throttle.load(std::memory_order_relaxed) && !previous.empty())
+      {
+        _writeback(previous, true);
+      }
+    }
+
+  public:
+    writeback_pacing_handle_adapter() = default;
+    writeback_pacing_handle_adapter(const writeback_pacing_handle_adapter &) = delete;
+    writeback_pacing_handle_adapter(writeback_pacing_handle_adapter &&o) noexcept  // NOLINT
+        : adapted_handle_type(std::move(o))
+        , _window(o._window.load(std::memory_order_relaxed))
+        , _throttle(o._throttle.load(std::memory_order_relaxed))
+        , _dirty(o._dirty)
+        , _previous(o._previous)
+        , _dirty_bytes(o._dirty_bytes)
+        , _writebacks(o._writebacks.load(std::memory_order_relaxed))
+    {
+    }
+    writeback_pacing_handle_adapter &operator=(const writeback_pacing_handle_adapter &) = delete;
+    writeback_pacing_handle_adapter &operator=(writeback_pacing_handle_adapter &&o) noexcept
+    {
+      this->~writeback_pacing_handle_adapter();
+      new(this) writeback_pacing_handle_adapter(std::move(o));
+      return *this;
+    }
+    /*! Adapts a handle to start writeback every `window` bytes written, and if `throttle` is
+    set, to wait for the writeback of the previous window. A `window` of zero disables pacing.
+    */
+    explicit writeback_pacing_handle_adapter(adapted_handle_type &&o, extent_type window = 8 * 1024 * 1024, bool throttle = false)
+        : adapted_handle_type(std::move(o))
+        , _window(window)
+        , _throttle(throttle)
+    {
+    }
+
+    //! The bytes written between each writeback, zero if pacing is disabled.
+    extent_type writeback_window() const noexcept { return _window.load(std::memory_order_relaxed); }
+    //! True if writers wait for the writeback of the previous window.
+    bool writeback_throttled() const noexcept { return _throttle.load(std::memory_order_relaxed); }
+    //! Sets the bytes written between each writeback, zero to disable, and whether to throttle writers.
+    void set_writeback_pacing(extent_type window, bool throttle = false) noexcept
+    {
+      std::lock_guard<decltype(_lock)> g(_lock);
+      _window.store(window, std::memory_order_relaxed);
+      _throttle.store(throttle, std::memory_order_relaxed);
+    }
+    //! The number of times writeback has been started by this adapter.
+    size_t writebacks() const noexcept { return _writebacks.load(std::memory_order_relaxed); }
+
+    using adapted_handle_type::write;
+    //! \brief Writes as per the adapted handle, starting writeback if a window's worth of data has been written.
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<const_buffers_type> write(io_request<const_buffers_type> reqs, deadline d = deadline()) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      OUTCOME_TRY(written, adapted_handle_type::write(reqs, d));
+      if(_window.load(std::memory_order_relaxed) > 0)
+      {
+        extent_type bytes = 0;
+        for(const auto &b : written)
+        {
+          bytes += b.size();
+        }
+        if(bytes > 0)
+        {
+          _written(reqs.offset, bytes);
+        }
+      }
+      return {written};
+    }
+    /*! \brief Barriers as per the adapted handle. A barrier of the whole file forgets the ranges
+    being tracked, as there is nothing left for pacing to do.
+    */
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<const_buffers_type> barrier(io_request<const_buffers_type> reqs = io_request<const_buffers_type>(), bool wait_for_device = false, bool and_metadata = false, deadline d = deadline()) noexcept override
+    {
+      LLFIO_LOG_FUNCTION_CALL(this);
+      OUTCOME_TRY(ret, adapted_handle_type::barrier(reqs, wait_for_device, and_metadata, d));
+      if(reqs.buffers.empty())
+      {
+        std::lock_guard<decltype(_lock)> g(_lock);
+        _dirty = _range_type();
+        _previous = _range_type();
+        _dirty_bytes = 0;
+      }
+      return {ret};
+    }
+  };
+
+  /*! \brief Constructs a `T` adapted to pace writeback every `window` bytes written.
+
+  This function works via the `construct<T>()` free function framework for which your `handle`
+  implementation must have registered its construction details.
+  */
+  template <class T, class... Args> inline result<writeback_pacing_handle_adapter<T>> pace_writeback(typename T::extent_type window, bool throttle, Args &&... args) noexcept
+  {
+    construct<T> constructor{std::forward<Args>(args)...};
+    OUTCOME_TRY(h, constructor());
+    return writeback_pacing_handle_adapter<T>(std::move(h), window, throttle);
+  }
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
+
+#endif
@@ -0,0 +1,364 @@
+/* A ring buffer whose storage is mapped twice back to back
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef LLFIO_ALGORITHM_VIRTUAL_RING_BUFFER_HPP
+#define LLFIO_ALGORITHM_VIRTUAL_RING_BUFFER_HPP
+
+#include "../map_handle.hpp"
+#include "../path_discovery.hpp"
+#include "../utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // for yield
+
+//! \file virtual_ring_buffer.hpp Provides a ring buffer whose contents are always contiguous.
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+namespace algorithm
+{
+  namespace detail
+  {
+    // Lives in the first granule of the section, so all users of the section share it
+    struct virtual_ring_buffer_header
+    {
+      uint64_t magic;
+      uint64_t capacity;
+      alignas(64) std::atomic<uint64_t> reserved;   // end of space claimed by producers
+      alignas(64) std::atomic<uint64_t> committed;  // end of space published to the consumer
+      alignas(64) std::atomic<uint64_t> consumed;   // end of space released by the consumer
+    };
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> must have the layout of uint64_t to be shared between processes");
+#if _HAS_CXX17 || __cplusplus >= 201703L
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "std::atomic<uint64_t> must be lock free to be shared between processes");
+#else
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "std::atomic<uint64_t> must be lock free to be shared between processes");
+#endif
+    static constexpr uint64_t virtual_ring_buffer_magic = 0x474e52204f49464cULL;  // "LFIO RNG"
+
+    // Windows can only map at offsets and addresses which are multiples of 64Kb
+    inline map_handle::size_type virtual_ring_buffer_granularity() noexcept { return utils::round_up_to_page_size(static_cast<map_handle::size_type>(65536), utils::page_size()); }
+  }  // namespace detail
+
+  /*! \class basic_virtual_ring_buffer
+  \brief A ring buffer whose storage is mapped twice back to back in address space, so that
+  every reservation for writing and all data available for reading are always one
+  contiguous span, even across the wrap point.
+
+  The storage is a `section_handle` whose first 64Kb holds the cursors, followed by the
+  data. The data is mapped twice, immediately after one another, using `map_handle::map()`
+  at fixed addresses within a reservation of address space. Because the cursors live in the
+  section, any number of `basic_virtual_ring_buffer` instances in any number of processes
+  may share the same backing file, so long as there is only one consumer at a time.
+
+  Producers call `reserve()` for contiguous space to write into directly, then `commit()`
+  to publish it. The consumer calls `readable()` for all published data as one span, and
+  `consume()` to release data it has finished with. No memory is ever copied by the ring
+  buffer.
+
+  If `multiple_producers` is false, there must only be a single producer at a time (SPSC),
+  and reserve and commit are wait free. If true, reservations are claimed with a compare
+  and swap, and `commit()` waits for all earlier reservations to be committed so the consumer
+  sees data in reservation order (MPSC).
+
+  \note On Windows, views cannot be placed within a reservation of address space, so the
+  reservation is released first and there is a small window where another thread may take
+  the address. This is retried a few times before giving up.
+  */
+  template <bool multiple_producers> class basic_virtual_ring_buffer
+  {
+  public:
+    using size_type = map_handle::size_type;
+    using extent_type = map_handle::extent_type;
+    using buffer_type = map_handle::buffer_type;
+
+  private:
+    section_handle _sh;
+    map_handle _headerh, _firsth, _secondh;
+    detail::virtual_ring_buffer_header *_header{nullptr};
+    byte *_data{nullptr};
+    size_type _capacity{0};
+
+    explicit basic_virtual_ring_buffer(section_handle &&sh) noexcept
+        : _sh(std::move(sh))
+    {
+    }
+
+    result<void> _map(size_type capacity, bool initialise) noexcept
+    {
+      const size_type granularity = detail::virtual_ring_buffer_granularity();
+      for(size_t attempt = 0;; attempt++)
+      {
+        OUTCOME_TRY(reservation, map_handle::map(granularity + 2 * capacity, false, section_handle::flag::none));
+        byte *addr = reservation.address();
+#ifdef _WIN32
+        OUTCOME_TRYV(reservation.close());
+#endif
+        auto place = [&]() -> result<void> {
+          OUTCOME_TRY(headerh, map_handle::map(addr, _sh, granularity, 0));
+          OUTCOME_TRY(firsth, map_handle::map(addr + granularity, _sh, capacity, granularity));
+          OUTCOME_TRY(secondh, map_handle::map(addr + granularity + capacity, _sh, capacity, granularity));
+          _headerh = std::move(headerh);
+          _firsth = std::move(firsth);
+          _secondh = std::move(secondh);
+          return success();
+        };
+        auto r = place();
+        if(r)
+        {
+#ifndef _WIN32
+          // The views now cover all of the reservation
+          (void) reservation.release();
+#endif
+          break;
+        }
+#ifdef _WIN32
+        if(attempt < 16)
+        {
+          continue;
+        }
+#endif
+        return std::move(r).error();
+      }
+      _header = reinterpret_cast<detail::virtual_ring_buffer_header *>(_headerh.address());
+      _data = _firsth.address();
+      _capacity = capacity;
+      if(initialise)
+      {
+        new(_header) detail::virtual_ring_buffer_header;
+        _header->capacity = capacity;
+        _header->reserved.store(0, std::memory_order_relaxed);
+        _header->committed.store(0, std::memory_order_relaxed);
+        _header->consumed.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _header->magic = detail::virtual_ring_buffer_magic;
+      }
+      else if(_header->magic != detail::virtual_ring_buffer_magic || _header->capacity != capacity)
+      {
+        return errc::invalid_argument;
+      }
+      return success();
+    }
+
+  public:
+    //! Default constructor
+    basic_virtual_ring_buffer() = default;
+    //! Move constructor
+    basic_virtual_ring_buffer(basic_virtual_ring_buffer &&o) noexcept
+        : _sh(std::move(o._sh))
+        , _headerh(std::move(o._headerh))
+        , _firsth(std::move(o._firsth))
+        , _secondh(std::move(o._secondh))
+        , _header(o._header)
+        , _data(o._data)
+        , _capacity(o._capacity)
+    {
+      _headerh.set_section(&_sh);
+      _firsth.set_section(&_sh);
+      _secondh.set_section(&_sh);
+      o._header = nullptr;
+      o._data = nullptr;
+      o._capacity = 0;
+    }
+    //! No copy construction
+    basic_virtual_ring_buffer(const basic_virtual_ring_buffer &) = delete;
+    //! Move assignment
+    basic_virtual_ring_buffer &operator=(basic_virtual_ring_buffer &&o) noexcept
+    {
+      this->~basic_virtual_ring_buffer();
+      new(this) basic_virtual_ring_buffer(std::move(o));
+      return *this;
+    }
+    //! No copy assignment
+    basic_virtual_ring_buffer &operator=(const basic_virtual_ring_buffer &) = delete;
+    ~basic_virtual_ring_buffer() = default;
+
+    /*! \brief Create a ring buffer private to this process.
+    \param capacity The bytes of data the ring buffer can hold, rounded up to a multiple of 64Kb.
+    \param dirh Where to create the anonymous inode backing the ring buffer.
+
+    \errors Any of the values `section_handle::section()` and `map_handle::map()` can return.
+    */
+    static result<basic_virtual_ring_buffer> ring_buffer(size_type capacity, const path_handle &dirh = path_discovery::memory_backed_temporary_files_directory()) noexcept
+    {
+      const size_type granularity = detail::virtual_ring_buffer_granularity();
+      capacity = utils::round_up_to_page_size(capacity, granularity);
+      if(capacity == 0)
+      {
+        return errc::invalid_argument;
+      }
+      OUTCOME_TRY(sh, section_handle::section(granularity + capacity, dirh, section_handle::flag::readwrite));
+      result<basic_virtual_ring_buffer> ret(basic_virtual_ring_buffer(std::move(sh)));
+      OUTCOME_TRYV(ret.value()._map(capacity, true));
+      return ret;
+    }
+    /*! \brief Create or attach to a ring buffer stored in `backing`, which may be shared with other processes.
+    \param backing A writable file which must outlive the ring buffer. If empty, it is sized for and initialised
+    with a new ring buffer of `capacity`, otherwise the ring buffer already in it is used.
+    \param capacity The bytes of data the ring buffer can hold, rounded up to a multiple of 64Kb. Ignored
+    if the ring buffer already exists.
+
+    \warning Initialisation is not atomic with respect to other processes attaching, so the ring buffer should
+    be created by one process before any others attach to it.
+
+    \errors Any of the values `section_handle::section()` and `map_handle::map()` can return.
+    `errc::invalid_argument` if `backing` contains something other than a ring buffer.
+    */
+    static result<basic_virtual_ring_buffer> ring_buffer(file_handle &backing, size_type capacity = 0) noexcept
+    {
+      const size_type granularity = detail::virtual_ring_buffer_granularity();
+      OUTCOME_TRY(length, backing.maximum_extent());
+      const bool initialise = (length == 0);
+      if(initialise)
+      {
+        capacity = utils::round_up_to_page_size(capacity, granularity);
+        if(capacity == 0)
+        {
+          return errc::invalid_argument;
+        }
+        OUTCOME_TRYV(backing.truncate(granularity + capacity));
+      }
+      else
+      {
+        if(length <= granularity)
+        {
+          return errc::invalid_argument;
+        }
+        capacity = static_cast<size_type>(length - granularity);
+      }
+      OUTCOME_TRY(sh, section_handle::section(backing, granularity + capacity, section_handle::flag::readwrite));
+      result<basic_virtual_ring_buffer> ret(basic_virtual_ring_buffer(std::move(sh)));
+      OUTCOME_TRYV(ret.value()._map(capacity, initialise));
+      return ret;
+    }
+
+    //! True if this ring buffer is valid.
+    bool is_valid() const noexcept { return _header != nullptr; }
+    //! The section storing this ring buffer.
+    const section_handle &section() const noexcept { return _sh; }
+    //! The bytes of data this ring buffer can hold.
+    size_type capacity() const noexcept { return _capacity; }
+    //! The bytes committed but not yet consumed.
+    size_type size() const noexcept { return static_cast<size_type>(_header->committed.load(std::memory_order_acquire) - _header->consumed.load(std::memory_order_acquire)); }
+
+    /*! \brief Reserves `bytes` of contiguous space for writing into, which must be later passed to `commit()`.
+
+    \errors `errc::resource_unavailable_try_again` if there is insufficient free space, or
+    `errc::argument_out_of_domain` if `bytes` exceeds the capacity.
+    \mallocs None.
+    */
+    result<buffer_type> reserve(size_type bytes) noexcept
+    {
+      if(bytes > _capacity)
+      {
+        return errc::argument_out_of_domain;
+      }
+      uint64_t head = _header->reserved.load(std::memory_order_relaxed);
+      if(bytes == 0)
+      {
+        return buffer_type{_data + head % _capacity, 0};
+      }
+      for(;;)
+      {
+        const uint64_t tail = _header->consumed.load(std::memory_order_acquire);
+        if(_capacity - (head - tail) < bytes)
+        {
+          return errc::resource_unavailable_try_again;
+        }
+        if(!multiple_producers)
+        {
+          _header->reserved.store(head + bytes, std::memory_order_relaxed);
+          break;
+        }
+        if(_header->reserved.compare_exchange_weak(head, head + bytes, std::memory_order_relaxed, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      return buffer_type{_data + head % _capacity, bytes};
+    }
+    /*! \brief Publishes to the consumer a reservation returned by `reserve()`. With multiple producers, this
+    waits until all earlier reservations have been committed.
+
+    \mallocs None.
+    */
+    void commit(buffer_type reservation) noexcept
+    {
+      if(reservation.size() == 0)
+      {
+        return;
+      }
+      const auto offset = static_cast<uint64_t>(reservation.data() - _data);
+      uint64_t committed = _header->committed.load(std::memory_order_acquire);
+      if(multiple_producers)
+      {
+        // All reservations in flight lie within one capacity of committed, so offsets are unique among them
+        while(committed % _capacity != offset)
+        {
+          std::this_thread::yield();
+          committed = _header->committed.load(std::memory_order_acquire);
+        }
+      }
+      _header->committed.store(committed + reservation.size(), std::memory_order_release);
+    }
+
+    //! Returns all committed data not yet consumed as one contiguous span, which may cross the wrap point.
+    buffer_type readable() const noexcept
+    {
+      const uint64_t committed = _header->committed.load(std::memory_order_acquire);
+      const uint64_t consumed = _header->consumed.load(std::memory_order_relaxed);
+      return {_data + consumed % _capacity, static_cast<size_type>(committed - consumed)};
+    }
+    //! Releases `bytes` from the front of `readable()` for reuse by producers. `bytes` must not exceed `size()`.
+    void consume(size_type bytes) noexcept
+    {
+      const uint64_t consumed = _header->consumed.load(std::memory_order_relaxed);
+      assert(bytes <= _header->committed.load(std::memory_order_acquire) - consumed);
+      _header->consumed.store(consumed + bytes, std::memory_order_release);
+    }
+
+    //! Unmaps the ring buffer, and closes its section.
+    result<void> close() noexcept
+    {
+      OUTCOME_TRYV(_secondh.close());
+      OUTCOME_TRYV(_firsth.close());
+      OUTCOME_TRYV(_headerh.close());
+      OUTCOME_TRYV(_sh.close());
+      _header = nullptr;
+      _data = nullptr;
+      _capacity = 0;
+      return success();
+    }
+  };
+
+  //! A double mapped ring buffer for a single producer and a single consumer
+  using spsc_virtual_ring_buffer = basic_virtual_ring_buffer<false>;
+  //! A double mapped ring buffer for multiple producers and a single consumer
+  using mpsc_virtual_ring_buffer = basic_virtual_ring_buffer<true>;
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
+
+#endif
@@ -79,6 +79,7 @@ public:
   using const_buffer_type = io_handle::const_buffer_type;
   using buffers_type = io_handle::buffers_type;
   using const_buffers_type = io_handle::const_buffers_type;
+  using io_priority = io_handle::io_priority;
   template <class T> using io_request = io_handle::io_request<T>;
   template <class T> using io_result = io_handle::io_result<T>;
 
@@ -246,7 +247,9 @@ protected:
     fsync_sync,
     dsync_sync,
     fsync_async,
-    dsync_async
+    dsync_async,
+    write_and_fsync,
+    write_and_dsync
   };
   struct _erased_completion_handler;
   // Holds state for an i/o in progress. Will be subclassed with platform specific state and how to implement completion.
@@ -255,7 +258,12 @@ protected:
     friend class io_service;
     async_file_handle *parent;
     operation_t operation;
+    io_priority priority;
     bool must_deallocate_self;
+    bool inline_completion;  // never dispatch the completion to the i/o service's completion pool
+    bool cancel_requested;   // cancel() has been called
+    int cache_bucket;        // if must_deallocate_self, the i/o service cache size class, or -1 to free()
+    io_service *cache_owner;
     size_t items;
     shared_size_type items_to_go;
     union result_storage {
@@ -270,7 +278,12 @@ protected:
     constexpr _erased_io_state_type(async_file_handle *_parent, operation_t _operation, bool _must_deallocate_self, size_t _items)
         : parent(_parent)
         , operation(_operation)
+        , priority(io_priority::normal)
         , must_deallocate_self(_must_deallocate_self)
+        , inline_completion(false)
+        , cancel_requested(false)
+        , cache_bucket(-1)
+        , cache_owner(nullptr)
         , items(_items)
         , items_to_go(0)
     {
@@ -288,6 +301,17 @@ protected:
 
     //! Retrieves a pointer to the copy of the completion handler held inside the i/o state.
     virtual _erased_completion_handler *erased_completion_handler() noexcept = 0;
+    /*! \brief Requests cancellation of any of this i/o still in flight, without blocking.
+
+    The completion handler is still invoked exactly once, by the i/o service as usual. If any part of the
+    i/o was cancelled, it receives `errc::operation_canceled`, otherwise it receives the outcome of the i/o,
+    which may have completed before the cancellation could take effect. Calling this after the completion
+    handler has been invoked does nothing. Must be called from the thread which runs the i/o service.
+
+    \errors Any of the values POSIX aio_cancel() can return, or `errc::resource_unavailable_try_again`
+    if no io_uring submission queue entries were available for the cancellation.
+    */
+    virtual result<void> cancel() noexcept = 0;
     /* Called when an i/o is completed by the system, figures out whether to call invoke_completion.
 
     For Windows:
@@ -299,6 +323,11 @@ protected:
       - errcode: errno code
       - bytes_transferred: return from aio_return(), usually bytes transferred
       - internal_state: address of pointer to struct aiocb in io_service's _aiocbsv
+
+    For Linux io_uring:
+      - errcode: negated CQE res if negative
+      - bytes_transferred: CQE res if not negative
+      - internal_state: address of pointer to struct aiocb taken from the CQE user_data
     */
     virtual void _system_io_completion(long errcode, long bytes_transferred, void *internal_state) noexcept = 0;
 
@@ -313,11 +342,20 @@ protected:
     template <class U> void operator()(U *_ptr) const
     {
       bool must_deallocate_self = _ptr->must_deallocate_self;
+      int cache_bucket = _ptr->cache_bucket;
+      io_service *cache_owner = _ptr->cache_owner;
       _ptr->~U();
       if(must_deallocate_self)
       {
         auto *ptr = reinterpret_cast<char *>(_ptr);
-        ::free(ptr);  // NOLINT
+        if(cache_owner != nullptr)
+        {
+          cache_owner->_deallocate_io_state(ptr, cache_bucket);
+        }
+        else
+        {
+          ::free(ptr);  // NOLINT
+        }
       }
     }
   };
@@ -373,8 +411,9 @@ public:
   barrier after a sudden power loss event. Slow.
   \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
   \errors As for `barrier()`, plus `ENOMEM`.
-  \mallocs If mem is not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-  erased completion handler of unknown type and state per buffers input.
+  \mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+  i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+  unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
   */
   LLFIO_MAKE_FREE_FUNCTION
   template <class CompletionRoutine>                                                                                            //
@@ -428,8 +467,9 @@ public:
   Note that buffers returned may not be buffers input, see documentation for `read()`.
   \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
   \errors As for `read()`, plus `ENOMEM`.
-  \mallocs If mem is not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-  erased completion handler of unknown type and state per buffers input.
+  \mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+  i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+  unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
   */
   LLFIO_MAKE_FREE_FUNCTION
   template <class CompletionRoutine>                                                                                      //
@@ -453,7 +493,7 @@ public:
       void operator()(_erased_io_state_type *state) final { completion(state->parent, std::move(state->result.read)); }
       void *address() noexcept final { return &completion; }
     } ch{std::forward<CompletionRoutine>(completion)};
-    return _begin_io(mem, operation_t::read, io_request<const_buffers_type>({reinterpret_cast<const_buffer_type *>(reqs.buffers.data()), reqs.buffers.size()}, reqs.offset), std::move(ch));
+    return _begin_io(mem, operation_t::read, io_request<const_buffers_type>({reinterpret_cast<const_buffer_type *>(reqs.buffers.data()), reqs.buffers.size()}, reqs.offset, reqs.priority), std::move(ch));
   }
 
   /*! \brief Schedule a write to occur asynchronously.
@@ -471,8 +511,9 @@ public:
   Note that buffers returned may not be buffers input, see documentation for `write()`.
   \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
   \errors As for `write()`, plus `ENOMEM`.
-  \mallocs If mem in not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-  erased completion handler of unknown type and state per buffers input.
+  \mallocs If mem in not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+  i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+  unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
   */
   LLFIO_MAKE_FREE_FUNCTION
   template <class CompletionRoutine>                                                                                            //
@@ -499,6 +540,54 @@ public:
     return _begin_io(mem, operation_t::write, reqs, std::move(ch));
   }
 
+  /*! \brief Schedule a write followed by a barrier to occur asynchronously as a single unit.
+
+  This is equivalent to calling `async_barrier()` from the completion of `async_write()`, but
+  without a second round trip through the i/o service. Under io_uring the write SQEs are linked to a
+  following fsync SQE with `IOSQE_IO_LINK`, so the barrier is only issued by the kernel if every
+  write fully succeeded. Under POSIX AIO the writes are submitted with `lio_listio()` immediately
+  followed by `aio_fsync()`, which POSIX requires to complete all i/o queued on the file descriptor
+  before it. Either way there is exactly one completion, which receives the buffers written, or the
+  first error from either the writes or the barrier. If under io_uring a write is short, the barrier
+  is never issued and the completion receives `errc::io_error`.
+
+  \return Either an io_state_ptr to the i/o in progress, or an error code.
+  \param reqs A scatter-gather and offset request.
+  \param completion A callable to call upon i/o completion. Spec is `void(async_file_handle *, io_result<const_buffers_type> &&)`.
+  Note that buffers returned may not be buffers input, see documentation for `write()`.
+  \param and_metadata True if you want the barrier to also sync the metadata for retrieving the
+  writes after a sudden power loss event (`fsync()` rather than `fdatasync()` semantics). Slow.
+  \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
+  \errors As for `write()` and `barrier()`, plus `ENOMEM`. Not supported on Microsoft Windows, which
+  does not support asynchronously executed barriers.
+  \mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+  i/o of no more than 16 buffers with a completion handler of no more than 256 bytes.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  template <class CompletionRoutine>                                                                                            //
+  LLFIO_REQUIRES(detail::is_invocable_r<void, CompletionRoutine, async_file_handle *, io_result<const_buffers_type> &>::value)  //
+  result<io_state_ptr> async_write_and_barrier(io_request<const_buffers_type> reqs, CompletionRoutine &&completion, bool and_metadata = false, span<char> mem = {}) noexcept
+  {
+    LLFIO_LOG_FUNCTION_CALL(this);
+    struct completion_handler : _erased_completion_handler
+    {
+      CompletionRoutine completion;
+      explicit completion_handler(CompletionRoutine c)
+          : completion(std::move(c))
+      {
+      }
+      size_t bytes() const noexcept final { return sizeof(*this); }
+      void move(_erased_completion_handler *_dest) final
+      {
+        auto *dest = reinterpret_cast<void *>(_dest);
+        new(dest) completion_handler(std::move(*this));
+      }
+      void operator()(_erased_io_state_type *state) final { completion(state->parent, std::move(state->result.write)); }
+      void *address() noexcept final { return &completion; }
+    } ch{std::forward<CompletionRoutine>(completion)};
+    return _begin_io(mem, and_metadata ? operation_t::write_and_fsync : operation_t::write_and_dsync, reqs, std::move(ch));
+  }
+
   using file_handle::read;
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC io_result<buffers_type> read(io_request<buffers_type> reqs, deadline d = deadline()) noexcept override;
   using file_handle::write;
@@ -707,8 +796,9 @@ has acknowledged the data is physically written. Slow.
 barrier after a sudden power loss event. Slow.
 \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
 \errors As for `barrier()`, plus `ENOMEM`.
-\mallocs If mem is not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-erased completion handler of unknown type and state per buffers input.
+\mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
 */
 template <class CompletionRoutine> inline result<async_file_handle::io_state_ptr> async_barrier(async_file_handle &self, async_file_handle::io_request<async_file_handle::const_buffers_type> reqs, CompletionRoutine &&completion, bool wait_for_device = false, bool and_metadata = false, span<char> mem = {}) noexcept
 {
@@ -729,8 +819,9 @@ and hence you ought to handle both situations.
 Note that buffers returned may not be buffers input, see documentation for `read()`.
 \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
 \errors As for `read()`, plus `ENOMEM`.
-\mallocs If mem is not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-erased completion handler of unknown type and state per buffers input.
+\mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
 */
 template <class CompletionRoutine> inline result<async_file_handle::io_state_ptr> async_read(async_file_handle &self, async_file_handle::io_request<async_file_handle::buffers_type> reqs, CompletionRoutine &&completion, span<char> mem = {}) noexcept
 {
@@ -752,13 +843,42 @@ and hence you ought to handle both situations.
 Note that buffers returned may not be buffers input, see documentation for `write()`.
 \param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
 \errors As for `write()`, plus `ENOMEM`.
-\mallocs If mem in not set, one calloc, one free. The allocation is unavoidable due to the need to store a type
-erased completion handler of unknown type and state per buffers input.
+\mallocs If mem in not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+i/o of no more than 16 buffers with a completion handler of no more than 256 bytes. The allocation is
+unavoidable due to the need to store a type erased completion handler of unknown type and state per buffers input.
 */
 template <class CompletionRoutine> inline result<async_file_handle::io_state_ptr> async_write(async_file_handle &self, async_file_handle::io_request<async_file_handle::const_buffers_type> reqs, CompletionRoutine &&completion, span<char> mem = {}) noexcept
 {
   return self.async_write(std::forward<decltype(reqs)>(reqs), std::forward<decltype(completion)>(completion), std::forward<decltype(mem)>(mem));
 }
+/*! \brief Schedule a write followed by a barrier to occur asynchronously as a single unit.
+
+This is equivalent to calling `async_barrier()` from the completion of `async_write()`, but
+without a second round trip through the i/o service. Under io_uring the write SQEs are linked to a
+following fsync SQE with `IOSQE_IO_LINK`, so the barrier is only issued by the kernel if every
+write fully succeeded. Under POSIX AIO the writes are submitted with `lio_listio()` immediately
+followed by `aio_fsync()`, which POSIX requires to complete all i/o queued on the file descriptor
+before it. Either way there is exactly one completion, which receives the buffers written, or the
+first error from either the writes or the barrier. If under io_uring a write is short, the barrier
+is never issued and the completion receives `errc::io_error`.
+
+\return Either an io_state_ptr to the i/o in progress, or an error code.
+\param self The object whose member function to call.
+\param reqs A scatter-gather and offset request.
+\param completion A callable to call upon i/o completion. Spec is `void(async_file_handle *, io_result<const_buffers_type> &&)`.
+Note that buffers returned may not be buffers input, see documentation for `write()`.
+\param and_metadata True if you want the barrier to also sync the metadata for retrieving the
+writes after a sudden power loss event (`fsync()` rather than `fdatasync()` semantics). Slow.
+\param mem Optional span of memory to use to avoid using `calloc()`. Note span MUST be all bits zero on entry.
+\errors As for `write()` and `barrier()`, plus `ENOMEM`. Not supported on Microsoft Windows, which
+does not support asynchronously executed barriers.
+\mallocs If mem is not set, one calloc, one free, unless the i/o service can recycle storage from a previous
+i/o of no more than 16 buffers with a completion handler of no more than 256 bytes.
+*/
+template <class CompletionRoutine> inline result<async_file_handle::io_state_ptr> async_write_and_barrier(async_file_handle &self, async_file_handle::io_request<async_file_handle::const_buffers_type> reqs, CompletionRoutine &&completion, bool and_metadata = false, span<char> mem = {}) noexcept
+{
+  return self.async_write_and_barrier(std::forward<decltype(reqs)>(reqs), std::forward<decltype(completion)>(completion), std::forward<decltype(and_metadata)>(and_metadata), std::forward<decltype(mem)>(mem));
+}
 #if LLFIO_HAVE_COROUTINES || defined(DOXYGEN_IS_IN_THE_HOUSE)
 /*! \brief Schedule a read to occur asynchronously.
 
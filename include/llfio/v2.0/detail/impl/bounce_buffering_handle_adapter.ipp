@@ -0,0 +1,63 @@
+/* A handle which bounces unaligned i/o through aligned buffers
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../../algorithm/handle_adapter/bounce_buffering.hpp"
+#include "../../stat.hpp"
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+namespace algorithm
+{
+  namespace detail
+  {
+    LLFIO_HEADERS_ONLY_FUNC_SPEC result<std::pair<size_t, size_t>> direct_io_alignment(const file_handle &h) noexcept
+    {
+      const size_t pagesize = utils::page_size();
+#if defined(__linux__) && defined(SYS_statx)
+      LLFIO_V2_NAMESPACE::detail::statx_t stx{};
+      if(-1 == LLFIO_V2_NAMESPACE::detail::do_statx(h.native_handle().fd, "", 0x1000 /*AT_EMPTY_PATH*/, LLFIO_V2_NAMESPACE::detail::statx_dioalign, stx))
+      {
+        if(ENOSYS != errno && EINVAL != errno)
+        {
+          return posix_error();
+        }
+      }
+      else if((stx.stx_mask & LLFIO_V2_NAMESPACE::detail::statx_dioalign) != 0)
+      {
+        if(stx.stx_dio_mem_align == 0 || stx.stx_dio_offset_align == 0)
+        {
+          // The filing system does not support direct i/o to this file
+          return errc::operation_not_supported;
+        }
+        return std::pair<size_t, size_t>(stx.stx_dio_mem_align, stx.stx_dio_offset_align);
+      }
+#else
+      (void) h;
+#endif
+      return std::pair<size_t, size_t>(pagesize, pagesize);
+    }
+  }  // namespace detail
+}  // namespace algorithm
+
+LLFIO_V2_NAMESPACE_END
@@ -0,0 +1,156 @@
+/* Platform independent parts of file_handle
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../../file_handle.hpp"
+#include "../../utils.hpp"
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+result<file_handle::extent_type> file_handle::clone_extents_to(file_handle &dest, file_handle::extent_type offset, file_handle::extent_type bytes, file_handle::extent_type dest_offset) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  if(offset + bytes < offset || dest_offset + bytes < dest_offset)
+  {
+    return errc::value_too_large;
+  }
+  OUTCOME_TRY(size, maximum_extent());
+  if(offset >= size)
+  {
+    return 0;
+  }
+  if(bytes > size - offset)
+  {
+    bytes = size - offset;
+  }
+  if(0 == bytes)
+  {
+    return 0;
+  }
+  if(unique_id() == dest.unique_id() && offset < dest_offset + bytes && dest_offset < offset + bytes)
+  {
+    return errc::invalid_argument;
+  }
+  dest.invalidate_extents_cache();
+  if(detail::file_handle_clone_range(*this, dest, offset, bytes, dest_offset))
+  {
+    return bytes;
+  }
+  try
+  {
+    // Extend the destination first, so any trailing hole is preserved
+    OUTCOME_TRY(destsize, dest.maximum_extent());
+    if(destsize < dest_offset + bytes)
+    {
+      OUTCOME_TRYV(dest.truncate(dest_offset + bytes));
+    }
+    // Holes in the source need only be zeroed where the destination may already have data
+    auto punch = [&](extent_type from, extent_type len) -> result<void> {
+      const extent_type to = dest_offset + (from - offset);
+      if(to < destsize)
+      {
+        OUTCOME_TRYV(dest.zero(to, (std::min)(len, destsize - to)));
+      }
+      return success();
+    };
+    byte *buffer = nullptr;
+    const size_t blocksize = utils::file_buffer_default_size();
+    auto unbufferh = undoer([&buffer, blocksize] {
+      if(buffer != nullptr)
+      {
+        utils::page_allocator<byte>().deallocate(buffer, blocksize);
+      }
+    });
+    (void) unbufferh;
+    bool use_copy_range = true;
+    auto copy = [&](extent_type from, extent_type len) -> result<void> {
+      extent_type to = dest_offset + (from - offset);
+      if(use_copy_range)
+      {
+        OUTCOME_TRY(copied, detail::file_handle_copy_range(*this, dest, from, to, len, use_copy_range));
+        if(use_copy_range)
+        {
+          // Either all of it was copied, or the source was truncated concurrently
+          return success();
+        }
+        from += copied;
+        to += copied;
+        len -= copied;
+      }
+      while(len > 0)
+      {
+        if(buffer == nullptr)
+        {
+          buffer = utils::page_allocator<byte>().allocate(blocksize);
+        }
+        const size_type toread = (len < blocksize) ? static_cast<size_type>(len) : blocksize;
+        OUTCOME_TRY(read_, read(from, {{buffer, toread}}));
+        if(0 == read_)
+        {
+          // The source was truncated concurrently
+          return success();
+        }
+        OUTCOME_TRY(written, dest.write(to, {{buffer, read_}}));
+        if(0 == written)
+        {
+          return errc::io_error;
+        }
+        from += written;
+        to += written;
+        len -= written;
+      }
+      return success();
+    };
+    OUTCOME_TRY(exts, extents());
+    const extent_type end = offset + bytes;
+    extent_type pos = offset;
+    for(auto &ext : exts)
+    {
+      if(ext.first >= end)
+      {
+        break;
+      }
+      const extent_type datastart = (std::max)(ext.first, pos), dataend = (std::min)(ext.first + ext.second, end);
+      if(datastart >= dataend)
+      {
+        continue;
+      }
+      if(datastart > pos)
+      {
+        OUTCOME_TRYV(punch(pos, datastart - pos));
+      }
+      OUTCOME_TRYV(copy(datastart, dataend - datastart));
+      pos = dataend;
+    }
+    if(pos < end)
+    {
+      OUTCOME_TRYV(punch(pos, end - pos));
+    }
+    return bytes;
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+}
+
+LLFIO_V2_NAMESPACE_END
@@ -0,0 +1,426 @@
+/* A section whose pages are filled on first touch by a user supplied function
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../../lazy_section_handle.hpp"
+#include "../../utils.hpp"
+
+#ifdef __linux__
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+namespace detail
+{
+  struct lazy_section_handle_state
+  {
+    lazy_section_handle::fill_function_type fill;
+    size_t granularity{0};
+    std::atomic<size_t> fills{0};
+#ifdef __linux__
+    struct registration_t
+    {
+      byte *addr;
+      size_t bytes;
+      handle::extent_type offset;
+    };
+    int fd{-1};  // the section's inode, borrowed
+    int uffd{-1}, wakefd{-1};
+    std::atomic<bool> have_zeropage{true};
+    std::mutex lock;
+    std::vector<registration_t> maps;
+    std::vector<byte, utils::page_allocator<byte>> buffer;
+    std::thread handler;
+
+    ~lazy_section_handle_state()
+    {
+      if(handler.joinable())
+      {
+        uint64_t v = 1;
+        (void) ::write(wakefd, &v, sizeof(v));
+        handler.join();
+      }
+      // Closing the userfaultfd unregisters all maps, and wakes anything blocked on them
+      if(uffd != -1)
+      {
+        ::close(uffd);
+      }
+      if(wakefd != -1)
+      {
+        ::close(wakefd);
+      }
+    }
+
+    // Resolves [dest, dest + bytes) by copying from src, or with zero pages if src is null
+    void resolve(byte *dest, const byte *src, size_t bytes) noexcept
+    {
+      const size_t pagesize = utils::page_size();
+      size_t done = 0;
+      while(done < bytes)
+      {
+        long ret;
+        __s64 resolved;
+        if(src == nullptr && have_zeropage.load(std::memory_order_relaxed))
+        {
+          uffdio_zeropage z{};
+          z.range.start = reinterpret_cast<uintptr_t>(dest + done);
+          z.range.len = bytes - done;
+          z.mode = UFFDIO_ZEROPAGE_MODE_DONTWAKE;
+          ret = ::ioctl(uffd, UFFDIO_ZEROPAGE, &z);
+          resolved = z.zeropage;
+        }
+        else
+        {
+          if(src == nullptr)
+          {
+            memset(buffer.data(), 0, bytes);
+            src = buffer.data();
+          }
+          uffdio_copy c{};
+          c.dst = reinterpret_cast<uintptr_t>(dest + done);
+          c.src = reinterpret_cast<uintptr_t>(src + done);
+          c.len = bytes - done;
+          c.mode = UFFDIO_COPY_MODE_DONTWAKE;
+          ret = ::ioctl(uffd, UFFDIO_COPY, &c);
+          resolved = c.copy;
+        }
+        if(ret == 0)
+        {
+          return;
+        }
+        if(resolved > 0)
+        {
+          done += static_cast<size_t>(resolved);
+        }
+        else if(EEXIST == errno)
+        {
+          // Some other map already faulted this page in
+          done += pagesize;
+        }
+        else if(EAGAIN != errno)
+        {
+          // The map has gone away
+          return;
+        }
+      }
+    }
+
+    // Writes [from, to) of the block at blockbegin in the buffer into the section's inode
+    void write_inode(handle::extent_type from, handle::extent_type to, handle::extent_type blockbegin) noexcept
+    {
+      while(from < to)
+      {
+        auto written = ::pwrite(fd, buffer.data() + (from - blockbegin), static_cast<size_t>(to - from), static_cast<off_t>(from));
+        if(written <= 0)
+        {
+          if(written < 0 && EINTR == errno)
+          {
+            continue;
+          }
+          // Those pages will be filled again by whichever map faults on them
+          return;
+        }
+        from += static_cast<handle::extent_type>(written);
+      }
+    }
+
+    void fault(byte *addr) noexcept
+    {
+      const size_t pagesize = utils::page_size();
+      addr = utils::round_down_to_page_size(addr, pagesize);
+      registration_t r{nullptr, 0, 0};
+      {
+        std::lock_guard<std::mutex> g(lock);
+        for(auto &i : maps)
+        {
+          if(addr >= i.addr && addr < i.addr + i.bytes)
+          {
+            r = i;
+            break;
+          }
+        }
+      }
+      byte *dest = addr;
+      size_t bytes = pagesize;
+      if(r.addr != nullptr)
+      {
+        // Fill the whole granularity aligned block containing the faulting page, clamped to the section
+        const handle::extent_type offset = r.offset + (addr - r.addr);
+        const handle::extent_type begin = offset / granularity * granularity;
+        handle::extent_type end = begin + granularity;
+        // If the length of the section is unknown, don't write past the end of this map
+        handle::extent_type length = r.offset + r.bytes;
+        struct stat s
+        {
+        };
+        if(-1 != ::fstat(fd, &s))
+        {
+          length = static_cast<handle::extent_type>(s.st_size);
+        }
+        end = (std::min)(end, utils::round_up_to_page_size(length, pagesize));
+        if(end > offset)
+        {
+          const size_t blockbytes = static_cast<size_t>(end - begin);
+          size_t filled = 0;
+          try
+          {
+            filled = fill(begin, {buffer.data(), blockbytes});
+          }
+          catch(...)
+          {
+            filled = 0;
+          }
+          fills.fetch_add(1, std::memory_order_relaxed);
+          if(filled > blockbytes)
+          {
+            filled = blockbytes;
+          }
+          memset(buffer.data() + filled, 0, blockbytes - filled);
+          // Only the part of the block within this map can be resolved through it
+          const handle::extent_type mapbegin = (std::max)(begin, r.offset), mapend = (std::min)(end, static_cast<handle::extent_type>(r.offset + r.bytes));
+          dest = r.addr + (mapbegin - r.offset);
+          bytes = static_cast<size_t>(mapend - mapbegin);
+          resolve(dest, (filled > 0) ? buffer.data() + (mapbegin - begin) : nullptr, bytes);
+          // The rest is written straight into the inode, so no other map faults on it and fills it again
+          write_inode(begin, mapbegin, begin);
+          write_inode(mapend, (std::min)(end, length), begin);
+        }
+        else
+        {
+          resolve(dest, nullptr, bytes);
+        }
+      }
+      else
+      {
+        // Not a map we know about, so unblock it with zeros
+        resolve(dest, nullptr, bytes);
+      }
+      uffdio_range range{reinterpret_cast<uintptr_t>(dest), bytes};
+      (void) ::ioctl(uffd, UFFDIO_WAKE, &range);
+    }
+
+    void run() noexcept
+    {
+      for(;;)
+      {
+        pollfd fds[2] = {{uffd, POLLIN, 0}, {wakefd, POLLIN, 0}};
+        if(-1 == ::poll(fds, 2, -1))
+        {
+          if(EINTR == errno)
+          {
+            continue;
+          }
+          return;
+        }
+        if(fds[1].revents != 0)
+        {
+          return;
+        }
+        uffd_msg msg{};
+        if(sizeof(msg) != ::read(uffd, &msg, sizeof(msg)))
+        {
+          continue;
+        }
+        if(msg.event == UFFD_EVENT_PAGEFAULT)
+        {
+          fault(reinterpret_cast<byte *>(static_cast<uintptr_t>(msg.arg.pagefault.address)));
+        }
+      }
+    }
+#endif
+  };
+
+  void lazy_section_handle_state_deleter::operator()(lazy_section_handle_state *p) const noexcept { delete p; }
+}  // namespace detail
+
+lazy_section_handle::~lazy_section_handle()
+{
+  if(_v)
+  {
+    auto ret = lazy_section_handle::close();
+    if(ret.has_error())
+    {
+      LLFIO_LOG_FATAL(nullptr, "lazy_section_handle::~lazy_section_handle() close failed");
+      abort();
+    }
+  }
+}
+
+result<void> lazy_section_handle::close() noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  // Stop the handler thread before the inode it fills goes away
+  _state.reset();
+  return section_handle::close();
+}
+
+lazy_section_handle::size_type lazy_section_handle::fill_granularity() const noexcept
+{
+  return _state ? _state->granularity : 0;
+}
+
+size_t lazy_section_handle::fills() const noexcept
+{
+  return _state ? _state->fills.load(std::memory_order_relaxed) : 0;
+}
+
+result<lazy_section_handle> lazy_section_handle::_lazy(extent_type bytes, fill_function_type &&fill, size_type granularity, flag _flag) noexcept
+{
+#ifdef __linux__
+  try
+  {
+    const size_t pagesize = utils::page_size();
+    granularity = (granularity == 0) ? pagesize : utils::round_up_to_page_size(granularity, pagesize);
+    // userfaultfd can only fill shared maps of shmem, so the inode must be on tmpfs
+    OUTCOME_TRY(sh, section_handle::section(bytes, path_discovery::memory_backed_temporary_files_directory(), _flag));
+    result<lazy_section_handle> ret(lazy_section_handle(std::move(sh)));
+    ret.value()._state.reset(new detail::lazy_section_handle_state);
+    auto &state = *ret.value()._state;
+    state.fill = std::move(fill);
+    state.granularity = granularity;
+    state.fd = ret.value()._v.fd;
+    state.buffer.resize(granularity);
+    // Try for kernel mode faults too, and fall back to user mode only if not permitted
+    state.uffd = static_cast<int>(::syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK));
+    if(-1 == state.uffd && EPERM == errno)
+    {
+      state.uffd = static_cast<int>(::syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | 1 /*UFFD_USER_MODE_ONLY*/));
+    }
+    if(-1 == state.uffd)
+    {
+      return posix_error();
+    }
+    uffdio_api api{};
+    api.api = UFFD_API;
+    if(-1 == ::ioctl(state.uffd, UFFDIO_API, &api))
+    {
+      return posix_error();
+    }
+    state.wakefd = ::eventfd(0, EFD_CLOEXEC);
+    if(-1 == state.wakefd)
+    {
+      return posix_error();
+    }
+    state.handler = std::thread([&state] { state.run(); });
+    LLFIO_LOG_FUNCTION_CALL(&ret);
+    return ret;
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+#else
+  (void) bytes;
+  (void) fill;
+  (void) granularity;
+  (void) _flag;
+  return errc::operation_not_supported;
+#endif
+}
+
+result<void> lazy_section_handle::_can_map() const noexcept
+{
+#ifdef __linux__
+  if(!_state)
+  {
+    // This section was moved from or closed, so the map cannot be registered, and its
+    // unfilled pages would silently read as zero
+    return errc::bad_file_descriptor;
+  }
+#endif
+  return success();
+}
+
+result<void> lazy_section_handle::_on_map(byte *addr, size_t bytes, extent_type offset) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+#ifdef __linux__
+  OUTCOME_TRYV(_can_map());
+  bytes = utils::round_up_to_page_size(bytes, utils::page_size());
+  uffdio_register reg{};
+  reg.range.start = reinterpret_cast<uintptr_t>(addr);
+  reg.range.len = bytes;
+  reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+  if(-1 == ::ioctl(_state->uffd, UFFDIO_REGISTER, &reg))
+  {
+    return posix_error();
+  }
+  if((reg.ioctls & (1ULL << _UFFDIO_COPY)) == 0)
+  {
+    return errc::operation_not_supported;
+  }
+  if((reg.ioctls & (1ULL << _UFFDIO_ZEROPAGE)) == 0)
+  {
+    _state->have_zeropage.store(false, std::memory_order_relaxed);
+  }
+  try
+  {
+    std::lock_guard<std::mutex> g(_state->lock);
+    auto &maps = _state->maps;
+    // Any overlapping registrations are of maps since released, or unmapped other than by map_handle
+    maps.erase(std::remove_if(maps.begin(), maps.end(), [&](const detail::lazy_section_handle_state::registration_t &i) { return i.addr < addr + bytes && addr < i.addr + i.bytes; }), maps.end());
+    maps.push_back({addr, bytes, offset});
+    return success();
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+#else
+  (void) addr;
+  (void) bytes;
+  (void) offset;
+  return success();
+#endif
+}
+
+void lazy_section_handle::_on_unmap(byte *addr, size_t bytes) noexcept
+{
+#ifdef __linux__
+  if(_state)
+  {
+    bytes = utils::round_up_to_page_size(bytes, utils::page_size());
+    std::lock_guard<std::mutex> g(_state->lock);
+    auto &maps = _state->maps;
+    maps.erase(std::remove_if(maps.begin(), maps.end(), [&](const detail::lazy_section_handle_state::registration_t &i) { return i.addr < addr + bytes && addr < i.addr + i.bytes; }), maps.end());
+  }
+#else
+  (void) addr;
+  (void) bytes;
+#endif
+}
+
+LLFIO_V2_NAMESPACE_END
@@ -0,0 +1,170 @@
+/* Platform independent parts of map_handle
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../../map_handle.hpp"
+
+#ifdef __has_include
+#if __has_include("../../quickcpplib/include/signal_guard.hpp")
+#include "../../quickcpplib/include/signal_guard.hpp"
+#else
+#include "quickcpplib/include/signal_guard.hpp"
+#endif
+#else
+#include "quickcpplib/include/signal_guard.hpp"
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+LLFIO_V2_NAMESPACE_BEGIN
+
+result<map_handle::populate_statistics> map_handle::_populate(span<buffer_type> regions, bool for_write, size_t threads, populate_progress_type &&progress) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(0);
+  static constexpr size_type chunk_size = 64 * 1024 * 1024;
+  const size_t pagesize = utils::page_size();
+  try
+  {
+    populate_statistics stats;
+    // Split the regions into page aligned chunks
+    std::vector<buffer_type> chunks;
+    for(auto &region : regions)
+    {
+      byte *begin = utils::round_down_to_page_size(region.data(), pagesize), *end = utils::round_up_to_page_size(region.data() + region.size(), pagesize);
+      for(byte *i = begin; i < end; i += chunk_size)
+      {
+        chunks.emplace_back(i, (std::min)(chunk_size, static_cast<size_type>(end - i)));
+      }
+      stats.bytes_total += end - begin;
+    }
+    if(threads == 0)
+    {
+      threads = (std::max)(std::thread::hardware_concurrency(), 1U);
+    }
+    threads = (std::max)((std::min)(threads, chunks.size()), static_cast<size_t>(1));
+    stats.threads = threads;
+
+    std::atomic<size_t> next{0};
+    std::mutex lock;  // serialises stats, progress and ret
+    result<void> ret = success();
+    const auto began = std::chrono::steady_clock::now();
+    auto worker = [&]() noexcept {
+      for(;;)
+      {
+        const size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+        if(idx >= chunks.size())
+        {
+          return;
+        }
+        const buffer_type chunk = chunks[idx];
+        auto r = detail::map_handle_populate(chunk, for_write);
+        if(r && !r.value())
+        {
+          // Touch every page instead, trapping pages which are not mapped or not accessible
+          if(QUICKCPPLIB_NAMESPACE::signal_guard::signal_guard(QUICKCPPLIB_NAMESPACE::signal_guard::signalc_set::undefined_memory_access,
+                                                               [&] {
+                                                                 for(size_t n = 0; n < chunk.size(); n += pagesize)
+                                                                 {
+                                                                   if(for_write)
+                                                                   {
+                                                                     reinterpret_cast<std::atomic<unsigned char> *>(chunk.data() + n)->fetch_or(0, std::memory_order_relaxed);
+                                                                   }
+                                                                   else
+                                                                   {
+                                                                     (void) *reinterpret_cast<volatile char *>(chunk.data() + n);
+                                                                   }
+                                                                 }
+                                                                 return false;
+                                                               },
+                                                               [&](const QUICKCPPLIB_NAMESPACE::signal_guard::raised_signal_info *info) {
+                                                                 auto *causingaddr = (byte *) info->addr;
+                                                                 if(causingaddr < chunk.data() || causingaddr >= chunk.data() + chunk.size())
+                                                                 {
+                                                                   // Not caused by this chunk
+                                                                   thrd_raise_signal(info->signo, info->raw_info, info->raw_context);
+                                                                   abort();
+                                                                 }
+                                                                 return true;
+                                                               }))
+          {
+            r = errc::bad_address;
+          }
+        }
+        std::lock_guard<std::mutex> g(lock);
+        if(!r)
+        {
+          if(ret)
+          {
+            ret = std::move(r).error();
+          }
+          // Stop everybody else
+          next.store(chunks.size(), std::memory_order_relaxed);
+          return;
+        }
+        stats.bytes_populated += chunk.size();
+        stats.elapsed = std::chrono::steady_clock::now() - began;
+        if(progress)
+        {
+          try
+          {
+            progress(stats);
+          }
+          catch(...)
+          {
+          }
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    try
+    {
+      workers.reserve(threads - 1);
+      for(size_t n = 1; n < threads; n++)
+      {
+        workers.emplace_back(worker);
+      }
+    }
+    catch(...)
+    {
+      // Populate with the threads we have
+      std::lock_guard<std::mutex> g(lock);
+      stats.threads = workers.size() + 1;
+    }
+    worker();
+    for(auto &t : workers)
+    {
+      t.join();
+    }
+    OUTCOME_TRYV(ret);
+    stats.elapsed = std::chrono::steady_clock::now() - began;
+    return stats;
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+}
+
+LLFIO_V2_NAMESPACE_END
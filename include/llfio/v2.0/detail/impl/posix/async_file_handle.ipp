@@ -25,10 +25,14 @@ Distributed under the Boost Software License, Version 1.0.
 #include "../../../handle.hpp"
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <unistd.h>
 #if LLFIO_USE_POSIX_AIO
 #include <aio.h>
 #endif
+#if LLFIO_USE_IO_URING
+#include <linux/io_uring.h>
+#endif
 
 LLFIO_V2_NAMESPACE_BEGIN
 
@@ -37,7 +41,8 @@ async_file_handle::io_result<async_file_handle::const_buffers_type> async_file_h
   LLFIO_LOG_FUNCTION_CALL(this);
   optional<io_result<const_buffers_type>> ret;
   OUTCOME_TRY(io_state, async_barrier(reqs, [&ret](async_file_handle *, io_result<const_buffers_type> &&result) { ret = std::move(result); }, wait_for_device, and_metadata));
-  (void) io_state;
+  // ret is not thread safe, so never have the completion pool complete this
+  io_state->inline_completion = true;
 
   // While i/o is not done pump i/o completion
   while(!ret)
@@ -91,10 +96,23 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
 #else
 #error todo
 #endif
+      io_service *service = this->parent->service();
+      service->_io_retired(this->priority);
       auto &result = this->result.write;
       if(result)
       {
-        if(errcode)
+        if(this->cancel_requested && (ECANCELED == errcode || EINTR == errcode))
+        {
+          // io_uring may fail an in progress read with EINTR when it is cancelled
+          result = errc::operation_canceled;
+        }
+        else if(ECANCELED == errcode)
+        {
+          // Nothing was cancelled, rather io_uring broke the link of a write and barrier because a
+          // write failed or was short. The barrier was never issued, so the data is not durable.
+          result = errc::io_error;
+        }
+        else if(errcode)
         {
           result = posix_error(static_cast<int>(errcode));
         }
@@ -111,44 +129,108 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
             LLFIO_LOG_FATAL(0, "file_handle::io_state::operator() called with invalid index");
             std::terminate();
           }
-          result.value()[idx] = {result.value()[idx].data(), (size_type) bytes_transferred};
+          // A write and barrier has one more item than buffers
+          if(idx < result.value().size())
+          {
+            result.value()[idx] = {result.value()[idx].data(), (size_type) bytes_transferred};
+          }
         }
       }
-      this->parent->service()->_work_done();
+      // If this is the last item, have the completion pool execute the completion handler if there is one.
+      // The pool hands the i/o state back to run_until() for items_to_go and the work count to be retired.
+      if(1 == this->items_to_go && !this->inline_completion && service->_dispatch_completion(this))
+      {
+        return;
+      }
+      service->_work_done();
       // Are we done?
       if(!--this->items_to_go)
       {
         (*completion)(this);
       }
     }
-    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~state_type() final
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> cancel() noexcept final
     {
-      // Do we need to cancel pending i/o?
-      if(this->items_to_go)
+      if(!this->items_to_go)
+      {
+        return success();
+      }
+      this->cancel_requested = true;
+      io_service *service = this->parent->service();
+      // i/o held back by the two level queue was never seen by the kernel, so complete it here
+      auto &deferred = service->_deferred_background;
+      for(size_t n = 0; n < this->items && this->items_to_go; n++)
       {
+        auto it = std::find_if(deferred.begin(), deferred.end(), [&](const io_service::_deferred_io_type &i) { return i.aiocb == aiocbs + n; });
+        if(it != deferred.end())
+        {
+          struct aiocb *aiocb = it->aiocb;
+          deferred.erase(it);
+          // Completion retires the i/o as if it had been issued
+          service->_io_issued(this->priority, 1);
+          this->_system_io_completion(ECANCELED, 0, &aiocb);
+        }
+      }
+      if(!this->items_to_go)
+      {
+        return success();
+      }
+#if LLFIO_USE_IO_URING
+      if(service->_io_uring_iopoll())
+      {
+        // An iopoll io_uring rejects IORING_OP_ASYNC_CANCEL, but its direct i/o completes quickly anyway
+        return success();
+      }
+      if(service->using_io_uring())
+      {
+        // Completed i/o is not found by the kernel, and that acknowledgement is ignored like any other
+        OUTCOME_TRYV(service->_io_uring_reserve(static_cast<unsigned>(this->items)));
         for(size_t n = 0; n < this->items; n++)
         {
-#if LLFIO_USE_POSIX_AIO
-          int ret = aio_cancel(this->parent->native_handle().fd, aiocbs + n);
-          (void) ret;
-#if 0
-          if(ret<0 || ret==AIO_NOTCANCELED)
-          {
-            std::cout << "Failed to cancel " << (aiocbs+n) << std::endl;
-          }
-          else if(ret==AIO_CANCELED)
-          {
-            std::cout << "Cancelled " << (aiocbs+n) << std::endl;
-          }
-          else if(ret==AIO_ALLDONE)
-          {
-            std::cout << "Already done " << (aiocbs+n) << std::endl;
-          }
+          auto *sqe = static_cast<struct io_uring_sqe *>(service->_io_uring_get_sqe());
+          sqe->opcode = IORING_OP_ASYNC_CANCEL;
+          sqe->fd = -1;
+          sqe->addr = reinterpret_cast<uintptr_t>(aiocbs + n);
+          sqe->user_data = 0;
+        }
+        service->_io_uring_commit();
+        return success();
+      }
 #endif
+#if LLFIO_USE_POSIX_AIO
+      // i/o in a batch not yet submitted was never seen by the kernel, so complete it here
+      auto &batched = service->_batched_aiocbs;
+      for(size_t n = 0; n < this->items && this->items_to_go; n++)
+      {
+        auto it = std::find(batched.begin(), batched.end(), aiocbs + n);
+        if(it != batched.end())
+        {
+          struct aiocb *aiocb = *it;
+          batched.erase(it);
+          this->_system_io_completion(ECANCELED, 0, &aiocb);
+        }
+      }
+      for(size_t n = 0; n < this->items && this->items_to_go; n++)
+      {
+        // Cancelled i/o will be reaped by io_service::run_until() with ECANCELED, i/o which
+        // the kernel could not cancel simply completes as normal
+        if(-1 == aio_cancel(this->parent->native_handle().fd, aiocbs + n))
+        {
+          return posix_error();
+        }
+      }
+      return success();
 #else
 #error todo
 #endif
-        }
+    }
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~state_type() final
+    {
+      // Do we need to cancel pending i/o?
+      if(this->items_to_go)
+      {
+        // Best effort: if the cancellation cannot be issued, we simply wait for the i/o to complete
+        (void) cancel();
         // Pump the i/o service until all pending i/o is completed
         while(this->items_to_go)
         {
@@ -171,13 +253,27 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
       completion->~_erased_completion_handler();
     }
   } * state;
+  // Submission is single threaded, so i/o initiated from anywhere else, e.g. a completion pool thread, would race
+  if(pthread_self() != service()->_threadh)
+  {
+    return errc::operation_not_supported;
+  }
+#if LLFIO_USE_IO_URING
+  // An iopoll io_uring fails anything but direct reads and writes with EINVAL, so refuse up front
+  if(service()->_io_uring_iopoll() && operation != operation_t::read && operation != operation_t::write)
+  {
+    return errc::operation_not_supported;
+  }
+#endif
   extent_type offset = reqs.offset;
-  size_t statelen = sizeof(state_type) + (reqs.buffers.size() - 1) * sizeof(struct aiocb) + completion.bytes();
+  // A write and barrier needs one more aiocb for the barrier
+  const bool and_barrier = (operation == operation_t::write_and_fsync || operation == operation_t::write_and_dsync);
+  size_t items(reqs.buffers.size() + (and_barrier ? 1 : 0));
+  size_t statelen = sizeof(state_type) + (items - 1) * sizeof(struct aiocb) + completion.bytes();
   if(!mem.empty() && statelen > mem.size())
   {
     return errc::not_enough_memory;
   }
-  size_t items(reqs.buffers.size());
 #if LLFIO_USE_POSIX_AIO && defined(AIO_LISTIO_MAX)
   // If this i/o could never be done atomically, reject
   if(items > AIO_LISTIO_MAX)
@@ -201,21 +297,46 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
     }
   }
 #endif
+#endif
+#if LLFIO_USE_IO_URING
+  if(service()->using_io_uring())
+  {
+    // Make sure there is room in the submission queue for every buffer before we commit to anything
+    OUTCOME_TRYV(service()->_io_uring_reserve(static_cast<unsigned>(items)));
+  }
 #endif
   bool must_deallocate_self = false;
+  int cache_bucket = -1;
   if(mem.empty())
   {
-    void *_mem = ::calloc(1, statelen);  // NOLINT
+    // Size the allocation for the largest number of buffers in its size class so the i/o service can recycle it
+    size_t allocbytes = statelen;
+    cache_bucket = io_service::_io_state_bucket(items);
+    if(cache_bucket >= 0 && completion.bytes() <= io_service::_io_state_cache_type::completion_bytes)
+    {
+      allocbytes = sizeof(state_type) + ((static_cast<size_t>(1) << cache_bucket) - 1) * sizeof(struct aiocb) + io_service::_io_state_cache_type::completion_bytes;
+    }
+    else
+    {
+      cache_bucket = -1;
+    }
+    void *_mem = service()->_allocate_io_state(cache_bucket, allocbytes);
     if(!_mem)
     {
       return errc::not_enough_memory;
     }
-    mem = {static_cast<char *>(_mem), statelen};
+    mem = {static_cast<char *>(_mem), allocbytes};
     must_deallocate_self = true;
   }
   io_state_ptr _state(reinterpret_cast<state_type *>(mem.data()));
   new((state = reinterpret_cast<state_type *>(mem.data()))) state_type(this, operation, must_deallocate_self, items);
-  state->completion = reinterpret_cast<_erased_completion_handler *>(reinterpret_cast<uintptr_t>(state) + sizeof(state_type) + (reqs.buffers.size() - 1) * sizeof(struct aiocb));
+  state->priority = reqs.priority;
+  if(must_deallocate_self)
+  {
+    state->cache_bucket = cache_bucket;
+    state->cache_owner = service();
+  }
+  state->completion = reinterpret_cast<_erased_completion_handler *>(reinterpret_cast<uintptr_t>(state) + sizeof(state_type) + (items - 1) * sizeof(struct aiocb));
   completion.move(state->completion);
 
   // Noexcept move the buffers from req into result
@@ -224,21 +345,26 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
   for(size_t n = 0; n < items; n++)
   {
 #if LLFIO_USE_POSIX_AIO
-#ifndef NDEBUG
-    if(_v.requires_aligned_io())
-    {
-      assert((offset & 511) == 0);
-      assert(((uintptr_t) out[n].data() & 511) == 0);
-      assert((out[n].size() & 511) == 0);
-    }
-#endif
     struct aiocb *aiocb = state->aiocbs + n;
     aiocb->aio_fildes = _v.fd;
-    aiocb->aio_offset = offset;
-    aiocb->aio_buf = reinterpret_cast<void *>(const_cast<byte *>(out[n].data()));
-    aiocb->aio_nbytes = out[n].size();
+    aiocb->aio_reqprio = aio_reqprio_from(reqs.priority);
     aiocb->aio_sigevent.sigev_notify = SIGEV_NONE;
     aiocb->aio_sigevent.sigev_value.sival_ptr = reinterpret_cast<void *>(state);
+    if(n < out.size())
+    {
+#ifndef NDEBUG
+      if(_v.requires_aligned_io())
+      {
+        assert((offset & 511) == 0);
+        assert(((uintptr_t) out[n].data() & 511) == 0);
+        assert((out[n].size() & 511) == 0);
+      }
+#endif
+      aiocb->aio_offset = offset;
+      aiocb->aio_buf = reinterpret_cast<void *>(const_cast<byte *>(out[n].data()));
+      aiocb->aio_nbytes = out[n].size();
+      offset += out[n].size();
+    }
     switch(operation)
     {
     case operation_t::read:
@@ -255,14 +381,89 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
     case operation_t::dsync_sync:
       aiocb->aio_lio_opcode = LIO_NOP;
       break;
+    case operation_t::write_and_fsync:
+    case operation_t::write_and_dsync:
+      aiocb->aio_lio_opcode = (n < out.size()) ? LIO_WRITE : LIO_NOP;
+      break;
     }
 #else
 #error todo
 #endif
-    offset += out[n].size();
     ++state->items_to_go;
   }
+  // Background reads and writes may need to wait for foreground i/o to complete
+  const bool deferred = (operation == operation_t::read || operation == operation_t::write) && service()->_must_defer(reqs.priority, items);
   int ret = 0;
+  if(deferred)
+  {
+    // io_service::_submit_deferred() issues these once the background queue depth permits
+    for(size_t n = 0; n < items; n++)
+    {
+      service()->_deferred_background.push_back({state->aiocbs + n, out.data() + n});
+    }
+  }
+  else
+#if LLFIO_USE_IO_URING
+  if(service()->using_io_uring())
+  {
+    // One SQE per buffer, each identified by its aiocb in the i/o state. These are not submitted
+    // to the kernel until the next io_service::run_until(), which batches all pending SQEs into
+    // a single io_uring_enter().
+    for(size_t n = 0; n < items; n++)
+    {
+      struct aiocb *aiocb = state->aiocbs + n;
+      auto *sqe = static_cast<struct io_uring_sqe *>(service()->_io_uring_get_sqe());
+      sqe->fd = _v.fd;
+      sqe->ioprio = static_cast<decltype(sqe->ioprio)>(linux_ioprio(reqs.priority));
+      sqe->user_data = reinterpret_cast<uintptr_t>(aiocb);
+      switch(operation)
+      {
+      case operation_t::read:
+      case operation_t::write:
+        // buffer_type is layout compatible with struct iovec
+        sqe->opcode = (operation == operation_t::read) ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uintptr_t>(out.data() + n);
+        sqe->len = 1;
+        sqe->off = aiocb->aio_offset;
+        break;
+      case operation_t::fsync_async:
+      case operation_t::fsync_sync:
+        sqe->opcode = IORING_OP_FSYNC;
+        break;
+      case operation_t::dsync_async:
+      case operation_t::dsync_sync:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+      case operation_t::write_and_fsync:
+      case operation_t::write_and_dsync:
+        if(n < out.size())
+        {
+          // Link each write to the next SQE, so the fsync is only issued once every write has
+          // fully succeeded. If any write fails or is short, the rest complete with ECANCELED,
+          // which _system_io_completion() reports as errc::io_error.
+          sqe->opcode = IORING_OP_WRITEV;
+          sqe->flags |= IOSQE_IO_LINK;
+          sqe->addr = reinterpret_cast<uintptr_t>(out.data() + n);
+          sqe->len = 1;
+          sqe->off = aiocb->aio_offset;
+        }
+        else
+        {
+          sqe->opcode = IORING_OP_FSYNC;
+          if(operation == operation_t::write_and_dsync)
+          {
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+          }
+        }
+        break;
+      }
+    }
+    // With IORING_SETUP_SQPOLL the kernel picks these up as soon as they are published
+    service()->_io_uring_commit();
+  }
+  else
+#endif
 #if LLFIO_USE_POSIX_AIO
   if(service()->using_kqueues())
   {
@@ -272,6 +473,14 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
 #error todo
 #endif
   }
+  else if(service()->_batching > 0 && (operation == operation_t::read || operation == operation_t::write))
+  {
+    // Defer these i/o's until the batch is submitted
+    for(size_t n = 0; n < items; n++)
+    {
+      service()->_batched_aiocbs.push_back(state->aiocbs + n);
+    }
+  }
   else
   {
     // Add these i/o's to the quick aio_suspend list
@@ -302,6 +511,30 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
 #endif
       }
       break;
+    case operation_t::write_and_fsync:
+    case operation_t::write_and_dsync:
+      // POSIX requires aio_fsync() to complete all i/o queued on the fd before it, so this chains the barrier after the writes
+      ret = (items > 1) ? lio_listio(LIO_NOWAIT, thislist, items - 1, nullptr) : 0;
+      if(ret >= 0)
+      {
+#if defined(__FreeBSD__) || defined(__APPLE__)  // neither of these have fdatasync()
+        ret = aio_fsync(O_SYNC, state->aiocbs + items - 1);
+#else
+        ret = aio_fsync((operation == operation_t::write_and_dsync) ? O_DSYNC : O_SYNC, state->aiocbs + items - 1);
+#endif
+        if(ret < 0)
+        {
+          // The writes are already in flight, so fail only the barrier
+          int errcode = errno;
+          service()->_work_enqueued(items);
+          service()->_io_issued(reqs.priority, items);
+          state->_system_io_completion(errcode, 0, &service()->_aiocbsv[service()->_aiocbsv.size() - 1]);
+          auto &v = service()->_aiocbsv;
+          v.erase(std::remove(v.begin(), v.end(), nullptr), v.end());
+          return success(std::move(_state));
+        }
+      }
+      break;
     }
   }
 #else
@@ -316,6 +549,10 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
     return success(std::move(_state));
   }
   service()->_work_enqueued(items);
+  if(!deferred)
+  {
+    service()->_io_issued(reqs.priority, items);
+  }
   return success(std::move(_state));
 }
 
@@ -329,7 +566,8 @@ async_file_handle::io_result<async_file_handle::buffers_type> async_file_handle:
   LLFIO_LOG_FUNCTION_CALL(this);
   optional<io_result<buffers_type>> ret;
   OUTCOME_TRY(io_state, async_read(reqs, [&ret](async_file_handle *, io_result<buffers_type> &&result) { ret = std::move(result); }));
-  (void) io_state;
+  // ret is not thread safe, so never have the completion pool complete this
+  io_state->inline_completion = true;
 
   // While i/o is not done pump i/o completion
   while(!ret)
@@ -356,7 +594,8 @@ async_file_handle::io_result<async_file_handle::const_buffers_type> async_file_h
   LLFIO_LOG_FUNCTION_CALL(this);
   optional<io_result<const_buffers_type>> ret;
   OUTCOME_TRY(io_state, async_write(reqs, [&ret](async_file_handle *, io_result<const_buffers_type> &&result) { ret = std::move(result); }));
-  (void) io_state;
+  // ret is not thread safe, so never have the completion pool complete this
+  io_state->inline_completion = true;
 
   // While i/o is not done pump i/o completion
   while(!ret)
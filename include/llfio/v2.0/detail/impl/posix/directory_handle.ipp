@@ -228,6 +228,34 @@ result<directory_handle::buffers_type> directory_handle::read(io_request<buffers
   path_view_type::c_str zglob(req.glob);
   if(!req.glob.empty() && !req.glob.contains_glob())
   {
+#if defined(__linux__) && defined(SYS_statx)
+    {
+      detail::statx_t stx{};
+      if(-1 != detail::do_statx(_v.fd, zglob.buffer, AT_SYMLINK_NOFOLLOW, detail::statx_mask_from(stat_t::want::all), stx))
+      {
+        stat_t::want filled(stat_t::want::none);
+        req.buffers[0].stat = stat_t(nullptr);
+        detail::fill_from_statx(req.buffers[0].stat, stx, stat_t::want::all, filled);
+        req.buffers._resize(1);
+        req.buffers._metadata = filled;
+        req.buffers._done = true;
+        return std::move(req.buffers);
+      }
+      // As for stat_t::fill(), fall back onto fstatat(), which handles all the corner cases,
+      // unless it would certainly fail the same way
+      switch(errno)
+      {
+      case ENOENT:
+      case ENOTDIR:
+      case EACCES:
+      case ELOOP:
+      case ENAMETOOLONG:
+        return posix_error();
+      default:
+        break;
+      }
+    }
+#endif
     struct stat s
     {
     };
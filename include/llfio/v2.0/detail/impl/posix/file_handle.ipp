@@ -26,6 +26,12 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include "import.hpp"
 
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
 LLFIO_V2_NAMESPACE_BEGIN
 
 result<file_handle> file_handle::file(const path_handle &base, file_handle::path_view_type path, file_handle::mode _mode, file_handle::creation _creation, file_handle::caching _caching, file_handle::flag flags) noexcept
@@ -349,6 +355,7 @@ result<file_handle::extent_type> file_handle::maximum_extent() const noexcept
 result<file_handle::extent_type> file_handle::truncate(file_handle::extent_type newsize) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
   if(ftruncate(_v.fd, newsize) < 0)
   {
     return posix_error();
@@ -365,8 +372,123 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
   LLFIO_LOG_FUNCTION_CALL(this);
   try
   {
+    if(_extents_cache != nullptr && _extents_cache->valid)
+    {
+      return _extents_cache->extents;
+    }
+    auto cached = [this](std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>> &out) {
+      if(_extents_cache != nullptr)
+      {
+        _extents_cache->extents = out;
+        _extents_cache->valid = true;
+      }
+    };
     std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>> out;
     out.reserve(64);
+#ifdef __linux__
+    {
+      // FIEMAP fetches hundreds of extents per syscall, each batch being an atomic snapshot
+      OUTCOME_TRY(size, file_handle::maximum_extent());
+      static constexpr uint32_t batch = 512;
+      // Use uint64_t storage for alignment
+      std::vector<uint64_t> buffer((sizeof(struct fiemap) + batch * sizeof(struct fiemap_extent) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+      auto *fm = reinterpret_cast<struct fiemap *>(buffer.data());
+      extent_type next = 0;
+      bool supported = true;
+      while(next < size)
+      {
+        memset(fm, 0, sizeof(struct fiemap));
+        fm->fm_start = next;
+        fm->fm_length = FIEMAP_MAX_OFFSET - next;
+        fm->fm_extent_count = batch;
+        if(-1 == ioctl(_v.fd, _IOWR('f', 11, struct fiemap) /*FS_IOC_FIEMAP*/, fm))
+        {
+          // Not all filing systems implement FIEMAP
+          if(EOPNOTSUPP == errno || ENOTTY == errno || EINVAL == errno)
+          {
+            supported = false;
+            out.clear();
+            break;
+          }
+          return posix_error();
+        }
+        if(0 == fm->fm_mapped_extents)
+        {
+          break;
+        }
+        auto add = [&out](extent_type start, extent_type end) {
+          if(end > start)
+          {
+            // Logically contiguous extents may be physically discontiguous, but are one extent to us
+            if(!out.empty() && out.back().first + out.back().second == start)
+            {
+              out.back().second += end - start;
+            }
+            else
+            {
+              out.emplace_back(start, end - start);
+            }
+          }
+        };
+        bool last = false;
+        for(uint32_t n = 0; n < fm->fm_mapped_extents; n++)
+        {
+          const struct fiemap_extent &fe = fm->fm_extents[n];
+          const extent_type start = fe.fe_logical, end = std::min(static_cast<extent_type>(fe.fe_logical + fe.fe_length), size);
+#ifdef SEEK_DATA
+          if((fe.fe_flags & FIEMAP_EXTENT_UNWRITTEN) != 0)
+          {
+            // Unwritten (preallocated) extents read as zeros, so they are holes, as SEEK_DATA
+            // reports them. Data written into them may not yet have been converted by
+            // writeback, which SEEK_DATA finds in the page cache, so ask it.
+            for(extent_type pos = start; pos < end;)
+            {
+              const auto datastart = lseek64(_v.fd, pos, SEEK_DATA);
+              if(-1 == datastart)
+              {
+                if(ENXIO == errno)
+                {
+                  break;
+                }
+                // Can't tell, so assume it all holds data
+                add(pos, end);
+                break;
+              }
+              if(static_cast<extent_type>(datastart) >= end)
+              {
+                break;
+              }
+              const auto dataend = lseek64(_v.fd, datastart, SEEK_HOLE);
+              if(-1 == dataend)
+              {
+                add(datastart, end);
+                break;
+              }
+              add(datastart, std::min(static_cast<extent_type>(dataend), end));
+              pos = dataend;
+            }
+          }
+          else
+#endif
+          {
+            // Delayed allocation extents are data not yet written back
+            add(start, end);
+          }
+          last = last || ((fe.fe_flags & FIEMAP_EXTENT_LAST) != 0);
+          next = fe.fe_logical + fe.fe_length;
+        }
+        if(last)
+        {
+          break;
+        }
+      }
+      if(supported)
+      {
+        cached(out);
+        return out;
+      }
+    }
+#endif
     extent_type start = 0, end = 0;
     for(;;)
     {
@@ -415,6 +537,7 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
         {
           OUTCOME_TRY(size, file_handle::maximum_extent());
           out.emplace_back(0, size);
+          cached(out);
           return out;
         }
       }
@@ -437,6 +560,7 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
   }
   return outfixed;
 #endif
+    cached(out);
     return out;
   }
   catch(...)
@@ -445,30 +569,19 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
   }
 }
 
-result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offset, file_handle::extent_type bytes, deadline d) noexcept
+// Writes zeros over a range of a file through a page allocated buffer
+inline result<file_handle::extent_type> write_zeros(file_handle &h, file_handle::extent_type offset, file_handle::extent_type bytes, deadline d) noexcept
 {
-  LLFIO_LOG_FUNCTION_CALL(this);
-#if defined(__linux__)
-  if(-1 == fallocate(_v.fd, 0x02 /*FALLOC_FL_PUNCH_HOLE*/ | 0x01 /*FALLOC_FL_KEEP_SIZE*/, offset, bytes))
-  {
-    // The filing system may not support trim
-    if(EOPNOTSUPP != errno)
-    {
-      return posix_error();
-    }
-  }
-#endif
-  // Fall back onto a write of zeros
   if(bytes < utils::page_size())
   {
     auto *buffer = static_cast<byte *>(alloca(bytes));
     memset(buffer, 0, bytes);
-    OUTCOME_TRY(written, write(offset, {{buffer, bytes}}, d));
+    OUTCOME_TRY(written, h.write(offset, {{buffer, bytes}}, d));
     return written;
   }
   try
   {
-    extent_type ret = 0;
+    file_handle::extent_type ret = 0;
     auto blocksize = utils::file_buffer_default_size();
     byte *buffer = utils::page_allocator<byte>().allocate(blocksize);
     auto unbufferh = undoer([buffer, blocksize] { utils::page_allocator<byte>().deallocate(buffer, blocksize); });
@@ -476,7 +589,7 @@ result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offs
     while(bytes > 0)
     {
       auto towrite = (bytes < blocksize) ? bytes : blocksize;
-      OUTCOME_TRY(written, write(offset, {{buffer, towrite}}, d));
+      OUTCOME_TRY(written, h.write(offset, {{buffer, towrite}}, d));
       offset += written;
       bytes -= written;
       ret += written;
@@ -489,4 +602,238 @@ result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offs
   }
 }
 
+result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offset, file_handle::extent_type bytes, deadline d) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+#if defined(__linux__)
+  if(-1 != fallocate(_v.fd, 0x02 /*FALLOC_FL_PUNCH_HOLE*/ | 0x01 /*FALLOC_FL_KEEP_SIZE*/, offset, bytes))
+  {
+    return bytes;
+  }
+  // The filing system may not support trim
+  if(EOPNOTSUPP != errno)
+  {
+    return posix_error();
+  }
+#endif
+  // Fall back onto a write of zeros
+  return write_zeros(*this, offset, bytes, d);
+}
+
+result<file_handle::extent_type> file_handle::preallocate(file_handle::extent_type offset, file_handle::extent_type bytes, bool keep_size) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+#if defined(__linux__)
+  if(-1 == fallocate(_v.fd, keep_size ? 0x01 /*FALLOC_FL_KEEP_SIZE*/ : 0, offset, bytes))
+  {
+    return posix_error();
+  }
+#elif defined(__APPLE__)
+  (void) offset;
+  (void) bytes;
+  (void) keep_size;
+  return errc::operation_not_supported;
+#else
+  if(keep_size)
+  {
+    return errc::operation_not_supported;
+  }
+  // Unlike every other POSIX function, this returns the error rather than setting errno
+  int errcode = posix_fallocate(_v.fd, offset, bytes);
+  if(errcode != 0)
+  {
+    return posix_error(errcode);
+  }
+#endif
+  return bytes;
+}
+
+result<file_handle::extent_type> file_handle::zero_range(file_handle::extent_type offset, file_handle::extent_type bytes, deadline d) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+#if defined(__linux__)
+  if(-1 != fallocate(_v.fd, 0x10 /*FALLOC_FL_ZERO_RANGE*/ | 0x01 /*FALLOC_FL_KEEP_SIZE*/, offset, bytes))
+  {
+    return bytes;
+  }
+  if(EOPNOTSUPP != errno)
+  {
+    return posix_error();
+  }
+#endif
+  // Never write past the end of the file, as that would change its maximum extent
+  OUTCOME_TRY(size, maximum_extent());
+  if(offset >= size)
+  {
+    return bytes;
+  }
+  OUTCOME_TRYV(write_zeros(*this, offset, std::min(bytes, size - offset), d));
+  return bytes;
+}
+
+result<void> file_handle::collapse_range(file_handle::extent_type offset, file_handle::extent_type bytes) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+#if defined(__linux__)
+  if(-1 == fallocate(_v.fd, 0x08 /*FALLOC_FL_COLLAPSE_RANGE*/, offset, bytes))
+  {
+    return posix_error();
+  }
+  return success();
+#else
+  (void) offset;
+  (void) bytes;
+  return errc::operation_not_supported;
+#endif
+}
+
+result<void> file_handle::insert_range(file_handle::extent_type offset, file_handle::extent_type bytes) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+#if defined(__linux__)
+  if(-1 == fallocate(_v.fd, 0x20 /*FALLOC_FL_INSERT_RANGE*/, offset, bytes))
+  {
+    return posix_error();
+  }
+  return success();
+#else
+  (void) offset;
+  (void) bytes;
+  return errc::operation_not_supported;
+#endif
+}
+
+result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> file_handle::prefetch(span<std::pair<file_handle::extent_type, file_handle::extent_type>> extents) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+#if defined(POSIX_FADV_WILLNEED)
+  for(auto &extent : extents)
+  {
+    // Unlike every other POSIX function, this returns the error rather than setting errno
+    int errcode = ::posix_fadvise(_v.fd, extent.first, extent.second, POSIX_FADV_WILLNEED);
+    if(errcode != 0)
+    {
+      return posix_error(errcode);
+    }
+  }
+  return extents;
+#elif defined(__APPLE__)
+  for(auto &extent : extents)
+  {
+    // F_RDADVISE takes an int count, so large extents must be advised in pieces
+    for(extent_type offset = extent.first, bytes = extent.second; bytes > 0;)
+    {
+      struct radvisory ra;
+      ra.ra_offset = offset;
+      ra.ra_count = static_cast<int>((std::min)(bytes, static_cast<extent_type>(1U << 30U)));
+      if(-1 == ::fcntl(_v.fd, F_RDADVISE, &ra))
+      {
+        return posix_error();
+      }
+      offset += ra.ra_count;
+      bytes -= ra.ra_count;
+    }
+  }
+  return extents;
+#else
+  return span<std::pair<extent_type, extent_type>>();
+#endif
+}
+
+result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> file_handle::evict(span<std::pair<file_handle::extent_type, file_handle::extent_type>> extents) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+#if defined(POSIX_FADV_DONTNEED)
+  for(auto &extent : extents)
+  {
+    int errcode = ::posix_fadvise(_v.fd, extent.first, extent.second, POSIX_FADV_DONTNEED);
+    if(errcode != 0)
+    {
+      return posix_error(errcode);
+    }
+  }
+  return extents;
+#else
+  return span<std::pair<extent_type, extent_type>>();
+#endif
+}
+
+namespace detail
+{
+  // Clones the whole of a range within the kernel, returning false if it cannot
+  inline bool file_handle_clone_range(file_handle &src, file_handle &dest, file_handle::extent_type offset, file_handle::extent_type bytes, file_handle::extent_type dest_offset) noexcept
+  {
+#ifdef __linux__
+    // Reflink the whole range, which shares the source's extents including its holes. The
+    // kernel headers defining this are not reliably installed, so it is spelled out.
+    struct file_clone_range_t
+    {
+      int64_t src_fd;
+      uint64_t src_offset;
+      uint64_t src_length;
+      uint64_t dest_offset;
+    } fcr{src.native_handle().fd, offset, bytes, dest_offset};
+    // Any failure means this pair of files cannot be reflinked, so copy instead
+    return 0 == ioctl(dest.native_handle().fd, _IOW(0x94, 13, file_clone_range_t) /*FICLONERANGE*/, &fcr);
+#else
+    (void) src;
+    (void) dest;
+    (void) offset;
+    (void) bytes;
+    (void) dest_offset;
+    return false;
+#endif
+  }
+
+  // Copies a range within the kernel, returning the bytes copied. Clears `supported` if the
+  // kernel cannot copy between this pair of files.
+  inline result<file_handle::extent_type> file_handle_copy_range(file_handle &src, file_handle &dest, file_handle::extent_type from, file_handle::extent_type to, file_handle::extent_type len, bool &supported) noexcept
+  {
+    file_handle::extent_type done = 0;
+#if defined(__linux__) && defined(SYS_copy_file_range)
+    while(len > 0)
+    {
+      int64_t in = from, out = to;
+      auto copied = syscall(SYS_copy_file_range, src.native_handle().fd, &in, dest.native_handle().fd, &out, static_cast<size_t>(len), 0);
+      if(copied < 0)
+      {
+        if(EINTR == errno)
+        {
+          continue;
+        }
+        // The kernel or this pair of filing systems can't, so fall back onto reads and writes
+        if(ENOSYS == errno || EXDEV == errno || EOPNOTSUPP == errno || EINVAL == errno)
+        {
+          supported = false;
+          return done;
+        }
+        return posix_error();
+      }
+      if(0 == copied)
+      {
+        // The source was truncated concurrently
+        break;
+      }
+      from += copied;
+      to += copied;
+      len -= copied;
+      done += copied;
+    }
+#else
+    (void) src;
+    (void) dest;
+    (void) from;
+    (void) to;
+    (void) len;
+    supported = false;
+#endif
+    return done;
+  }
+}  // namespace detail
+
 LLFIO_V2_NAMESPACE_END
@@ -23,14 +23,26 @@ Distributed under the Boost Software License, Version 1.0.
 */
 
 #include "../../../io_handle.hpp"
+#include "../../../utils.hpp"
 
 #include <climits>  // for IOV_MAX
 #include <fcntl.h>
 #include <sys/uio.h>  // for preadv etc
 #include <unistd.h>
-#if LLFIO_USE_POSIX_AIO
+#if !defined(LLFIO_USE_POSIX_AIO) || LLFIO_USE_POSIX_AIO
 #include <aio.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>  // for ioprio_set
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>  // for posix_memalign
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 LLFIO_V2_NAMESPACE_BEGIN
 
@@ -64,12 +76,521 @@ size_t io_handle::max_buffers() const noexcept
   return v;
 }
 
+#ifdef __linux__
+/* The Linux ioprio value for an i/o priority, or zero to leave it unchanged. The kernel
+headers defining the ioprio macros are not reliably installed, so these are spelled out.
+*/
+constexpr inline int linux_ioprio(io_handle::io_priority priority) noexcept
+{
+  // IOPRIO_CLASS_SHIFT is 13, IOPRIO_CLASS_BE is 2, IOPRIO_CLASS_IDLE is 3
+  return (priority == io_handle::io_priority::high) ? ((2 << 13) | 0) : (priority == io_handle::io_priority::background) ? (3 << 13) : 0;
+}
+
+// Sets the calling thread's i/o priority for the lifetime of this object, if it is not normal
+class linux_ioprio_scope
+{
+  int _old{-1};
+
+public:
+  explicit linux_ioprio_scope(io_handle::io_priority priority) noexcept
+  {
+    const int value = linux_ioprio(priority);
+    if(value != 0)
+    {
+      // IOPRIO_WHO_PROCESS is 1, and a who of zero is the calling thread
+      const int old = static_cast<int>(syscall(SYS_ioprio_get, 1, 0));
+      // Failure is not an error, as the priority is only ever a hint
+      if(old >= 0 && old != value && syscall(SYS_ioprio_set, 1, 0, value) >= 0)
+      {
+        _old = old;
+      }
+    }
+  }
+  linux_ioprio_scope(const linux_ioprio_scope &) = delete;
+  linux_ioprio_scope &operator=(const linux_ioprio_scope &) = delete;
+  ~linux_ioprio_scope()
+  {
+    if(_old != -1)
+    {
+      (void) syscall(SYS_ioprio_set, 1, 0, _old);
+    }
+  }
+};
+#endif
+
+#if !defined(LLFIO_USE_POSIX_AIO) || LLFIO_USE_POSIX_AIO
+// The aio_reqprio for an i/o priority. This can only lower the priority below the process' priority.
+constexpr inline int aio_reqprio_from(io_handle::io_priority priority) noexcept
+{
+#ifdef AIO_PRIO_DELTA_MAX
+  return (priority == io_handle::io_priority::background) ? AIO_PRIO_DELTA_MAX : 0;
+#else
+  (void) priority;
+  return 0;
+#endif
+}
+#endif
+
+#if !defined(LLFIO_USE_POSIX_AIO) || LLFIO_USE_POSIX_AIO
+namespace detail
+{
+  // The aiocbs of one deadline i/o, and the buffer they transfer to or from
+  struct deadline_aio_state
+  {
+    std::array<struct aiocb, 64> aiocbs{};
+    std::array<bool, 64> returned{};  // aio_return() has been called
+    size_t submitted{0};
+    void *bounce{nullptr};
+    deadline_aio_state() = default;
+    deadline_aio_state(const deadline_aio_state &) = delete;
+    deadline_aio_state &operator=(const deadline_aio_state &) = delete;
+    ~deadline_aio_state() { ::free(bounce); }  // NOLINT
+    // True if every aiocb has finished, reaping those which have
+    bool reap() noexcept
+    {
+      bool done = true;
+      for(size_t n = 0; n < submitted; n++)
+      {
+        if(!returned[n])
+        {
+          if(EINPROGRESS == aio_error(&aiocbs[n]))
+          {
+            done = false;
+            continue;
+          }
+          (void) aio_return(&aiocbs[n]);
+          returned[n] = true;
+        }
+      }
+      return done;
+    }
+  };
+
+  /* Takes ownership of deadline i/o which could not be cancelled when its deadline passed,
+  so the caller can return. A thread waits for the i/o to finish, then frees it, and exits
+  once there is nothing left to wait for.
+  */
+  class deadline_aio_reaper
+  {
+    std::mutex _lock;
+    std::vector<deadline_aio_state *> _abandoned;
+    bool _running{false};
+
+    void _run() noexcept
+    {
+      std::vector<const struct aiocb *> pending;
+      for(;;)
+      {
+        pending.clear();
+        {
+          std::lock_guard<std::mutex> g(_lock);
+          for(auto it = _abandoned.begin(); it != _abandoned.end();)
+          {
+            if((*it)->reap())
+            {
+              delete *it;
+              it = _abandoned.erase(it);
+              continue;
+            }
+            for(size_t n = 0; n < (*it)->submitted; n++)
+            {
+              if(!(*it)->returned[n])
+              {
+                try
+                {
+                  pending.push_back(&(*it)->aiocbs[n]);
+                }
+                catch(...)
+                {
+                }
+              }
+            }
+            ++it;
+          }
+          if(_abandoned.empty())
+          {
+            _running = false;
+            return;
+          }
+        }
+        // Wake periodically to pick up newly abandoned i/o
+        struct timespec ts
+        {
+        };
+        ts.tv_sec = 0;
+        ts.tv_nsec = 100000000;
+        (void) aio_suspend(pending.data(), static_cast<int>(pending.size()), &ts);
+      }
+    }
+
+  public:
+    static deadline_aio_reaper &instance() noexcept
+    {
+      // Never destroyed, as its thread may still be running during static deinitialisation
+      static deadline_aio_reaper *v = new deadline_aio_reaper;  // NOLINT
+      return *v;
+    }
+    // Returns false if the i/o could not be taken, in which case the caller must wait for it
+    bool abandon(std::unique_ptr<deadline_aio_state> &state) noexcept
+    {
+      std::lock_guard<std::mutex> g(_lock);
+      try
+      {
+        _abandoned.push_back(state.get());
+      }
+      catch(...)
+      {
+        return false;
+      }
+      if(!_running)
+      {
+        try
+        {
+          std::thread([this] { _run(); }).detach();
+          _running = true;
+        }
+        catch(...)
+        {
+          _abandoned.pop_back();
+          return false;
+        }
+      }
+      state.release();
+      return true;
+    }
+  };
+}  // namespace detail
+#endif
+
+/* Deadline i/o for a blocking fd. Firstly we try the i/o with RWF_NOWAIT, which completes
+immediately if it can be satisfied without blocking e.g. from the page cache. Otherwise
+we issue the remainder as POSIX AIO, a chunk of `utils::file_buffer_default_size()` at a
+time with one aiocb per buffer piece, wait on aio_suspend() until the deadline, and cancel
+whatever has not completed by then. Buffers transferred before the deadline are returned, so
+the caller can see how much of the request completed. Only if nothing at all was transferred
+is `errc::timed_out` returned.
+
+POSIX AIO cannot cancel i/o already in progress e.g. stuck on a slow NFS server or a failing
+disk. So the i/o is bounced through memory owned by the aiocbs, and at the deadline reads
+which refused to cancel are handed to a reaper thread which waits for them, rather than the
+caller. Writes which refused to cancel are waited for, as otherwise they could land after
+the caller was told they did not, and overwrite a retry.
+*/
+template <class BuffersType> inline io_handle::io_result<BuffersType> do_deadline_read_write(const native_handle_type &nativeh, io_handle::io_request<BuffersType> reqs, deadline d, bool is_write) noexcept
+{
+  std::chrono::steady_clock::time_point began_steady;
+  std::chrono::system_clock::time_point end_utc;
+  if(d.steady)
+  {
+    began_steady = std::chrono::steady_clock::now();
+  }
+  else
+  {
+    end_utc = d.to_time_point();
+  }
+  // Trims the buffers to the bytes transferred, dropping any which received nothing
+  auto trim = [&reqs](size_t bytes) -> io_handle::io_result<BuffersType> {
+    for(size_t i = 0; i < reqs.buffers.size(); i++)
+    {
+      auto &buffer = reqs.buffers[i];
+      if(buffer.size() <= bytes)
+      {
+        bytes -= buffer.size();
+      }
+      else
+      {
+        buffer = {buffer.data(), bytes};
+        reqs.buffers = {reqs.buffers.data(), (bytes > 0) ? (i + 1) : i};
+        break;
+      }
+    }
+    return {reqs.buffers};
+  };
+  size_t totalbytes = 0;
+  for(auto &buffer : reqs.buffers)
+  {
+    totalbytes += buffer.size();
+  }
+  size_t already = 0;  // bytes transferred without blocking
+#if defined(__linux__) && defined(RWF_NOWAIT)
+  if(reqs.buffers.size() <= IOV_MAX)
+  {
+    auto *iov = reinterpret_cast<struct iovec *>(const_cast<typename BuffersType::value_type *>(reqs.buffers.data()));
+    ssize_t bytes = is_write ? ::pwritev2(nativeh.fd, iov, reqs.buffers.size(), reqs.offset, RWF_NOWAIT) : ::preadv2(nativeh.fd, iov, reqs.buffers.size(), reqs.offset, RWF_NOWAIT);
+    if(bytes >= 0 && (static_cast<size_t>(bytes) == totalbytes || (d.steady && d.nsecs == 0 && bytes > 0)))
+    {
+      return trim(static_cast<size_t>(bytes));
+    }
+    // ESPIPE is a pipe or socket, which POSIX AIO reads and writes at the current position
+    if(bytes < 0 && EAGAIN != errno && EWOULDBLOCK != errno && EOPNOTSUPP != errno && EINVAL != errno && ENOSYS != errno && ESPIPE != errno)
+    {
+      return posix_error();
+    }
+    // Otherwise the i/o would block, or RWF_NOWAIT is not supported for this fd, so fall
+    // through to the cancellable implementation. If some of the i/o did complete without
+    // blocking, continue from there, as repeating it would write twice to an O_APPEND fd.
+    if(bytes > 0)
+    {
+      already = static_cast<size_t>(bytes);
+    }
+  }
+#endif
+  if(already == totalbytes)
+  {
+    return trim(already);
+  }
+  if(d.steady && d.nsecs == 0)
+  {
+    return errc::timed_out;
+  }
+#if !defined(LLFIO_USE_POSIX_AIO) || LLFIO_USE_POSIX_AIO
+  const size_t chunk = (std::min)(totalbytes - already, utils::file_buffer_default_size());
+  std::unique_ptr<detail::deadline_aio_state> state(new(std::nothrow) detail::deadline_aio_state);
+  if(!state || 0 != ::posix_memalign(&state->bounce, utils::page_size(), chunk))
+  {
+    return errc::not_enough_memory;
+  }
+  auto *bounce = static_cast<byte *>(state->bounce);
+  // Calls f(buffer piece, bytes) for each piece of the buffers within [skip, skip + bytes), until f returns false
+  auto for_each_piece = [&reqs](size_t skip, size_t bytes, auto &&f) {
+    size_t pos = 0;
+    for(auto &buffer : reqs.buffers)
+    {
+      if(pos == bytes)
+      {
+        break;
+      }
+      if(buffer.size() <= skip)
+      {
+        skip -= buffer.size();
+        continue;
+      }
+      const size_t len = (std::min)(buffer.size() - skip, bytes - pos);
+      if(!f(const_cast<byte *>(buffer.data()) + skip, len))
+      {
+        break;
+      }
+      pos += len;
+      skip = 0;
+    }
+  };
+  std::array<const struct aiocb *, 64> pending{};
+  size_t done = already;
+  bool timedout = false;
+  int firsterror = 0;
+  while(done < totalbytes && !timedout && firsterror == 0)
+  {
+    // Submit up to a chunk of what remains, as at most one aiocb per buffer piece
+    state->aiocbs = {};
+    state->returned = {};
+    state->submitted = 0;
+    pending = {};
+    size_t roundbytes = 0;
+    for_each_piece(done, (std::min)(chunk, totalbytes - done), [&](byte *piece, size_t len) {
+      if(state->submitted == state->aiocbs.size())
+      {
+        return false;
+      }
+      if(is_write)
+      {
+        memcpy(bounce + roundbytes, piece, len);
+      }
+      struct aiocb *aiocb = &state->aiocbs[state->submitted];
+      aiocb->aio_fildes = nativeh.fd;
+      aiocb->aio_reqprio = aio_reqprio_from(reqs.priority);
+      aiocb->aio_offset = reqs.offset + done + roundbytes;
+      aiocb->aio_buf = bounce + roundbytes;
+      aiocb->aio_nbytes = len;
+      aiocb->aio_sigevent.sigev_notify = SIGEV_NONE;
+      if(-1 == (is_write ? aio_write(aiocb) : aio_read(aiocb)))
+      {
+        firsterror = errno;
+        return false;
+      }
+      pending[state->submitted++] = aiocb;
+      roundbytes += len;
+      return true;
+    });
+    if(state->submitted == 0)
+    {
+      break;
+    }
+    for(;;)
+    {
+      size_t outstanding = 0;
+      for(size_t n = 0; n < state->submitted; n++)
+      {
+        if(pending[n] != nullptr)
+        {
+          if(EINPROGRESS == aio_error(pending[n]))
+          {
+            outstanding++;
+          }
+          else
+          {
+            pending[n] = nullptr;
+          }
+        }
+      }
+      if(outstanding == 0)
+      {
+        break;
+      }
+      if(timedout)
+      {
+        if(!is_write)
+        {
+          break;
+        }
+        // Writes which would not cancel must land before the caller is told how much did
+        (void) aio_suspend(pending.data(), static_cast<int>(state->submitted), nullptr);
+        continue;
+      }
+      std::chrono::nanoseconds ns{};
+      if(d.steady)
+      {
+        ns = std::chrono::duration_cast<std::chrono::nanoseconds>((began_steady + std::chrono::nanoseconds(d.nsecs)) - std::chrono::steady_clock::now());
+      }
+      else
+      {
+        ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_utc - std::chrono::system_clock::now());
+      }
+      if(ns.count() > 0)
+      {
+        struct timespec ts
+        {
+        };
+        ts.tv_sec = ns.count() / 1000000000ULL;
+        ts.tv_nsec = ns.count() % 1000000000ULL;
+        if(-1 != aio_suspend(pending.data(), static_cast<int>(state->submitted), &ts) || EAGAIN != errno)
+        {
+          continue;
+        }
+      }
+      timedout = true;
+      for(size_t n = 0; n < state->submitted; n++)
+      {
+        if(pending[n] != nullptr)
+        {
+          aio_cancel(nativeh.fd, const_cast<struct aiocb *>(pending[n]));
+        }
+      }
+      // Loop round once more to see what the cancellation left in progress
+    }
+    // Keep only the contiguous run of buffer pieces which completed
+    size_t aiobytes = 0;
+    bool complete = true;
+    for(size_t n = 0; n < state->submitted; n++)
+    {
+      struct aiocb *aiocb = &state->aiocbs[n];
+      int errcode = aio_error(aiocb);
+      if(EINPROGRESS == errcode)
+      {
+        complete = false;
+        break;
+      }
+      ssize_t bytes = aio_return(aiocb);
+      state->returned[n] = true;
+      if(errcode != 0)
+      {
+        if(ECANCELED != errcode)
+        {
+          firsterror = errcode;
+        }
+        complete = false;
+        break;
+      }
+      aiobytes += static_cast<size_t>(bytes);
+      if(static_cast<size_t>(bytes) < aiocb->aio_nbytes)
+      {
+        complete = false;
+        break;
+      }
+    }
+    if(!is_write)
+    {
+      size_t pos = 0;
+      for_each_piece(done, aiobytes, [&](byte *piece, size_t len) {
+        memcpy(piece, bounce + pos, len);
+        pos += len;
+        return true;
+      });
+    }
+    done += aiobytes;
+    if(!complete)
+    {
+      break;
+    }
+  }
+  if(!state->reap())
+  {
+    // Only reads are left in flight. If the reaper cannot take them, there is no choice but
+    // to wait for them here, however long it takes.
+    if(!detail::deadline_aio_reaper::instance().abandon(state))
+    {
+      while(!state->reap())
+      {
+        aio_suspend(pending.data(), static_cast<int>(state->submitted), nullptr);
+      }
+    }
+  }
+  if(done == 0)
+  {
+    if(firsterror != 0)
+    {
+      return posix_error(firsterror);
+    }
+    if(timedout)
+    {
+      return errc::timed_out;
+    }
+  }
+  return trim(done);
+#else
+  (void) nativeh;
+  (void) is_write;
+  return errc::not_supported;
+#endif
+}
+
+// Drops the pages just read from the kernel cache, if the handle was opened with flag::drop_behind
+inline void drop_behind(const native_handle_type &nativeh, handle::flag flags, io_handle::extent_type offset, size_t bytes) noexcept
+{
+#ifdef POSIX_FADV_DONTNEED
+  if((flags & handle::flag::drop_behind) && bytes > 0)
+  {
+    // A sequential reader only partially read the first page last time, so it is dropped now.
+    // The last page is partially read, so it is left for the next read.
+    const io_handle::extent_type pagemask = ~static_cast<io_handle::extent_type>(utils::page_size() - 1);
+    const io_handle::extent_type begin = offset & pagemask, end = (offset + bytes) & pagemask;
+    if(end > begin)
+    {
+      // This is only advice, so failure is not an error
+      (void) ::posix_fadvise(nativeh.fd, begin, end - begin, POSIX_FADV_DONTNEED);
+    }
+  }
+#else
+  (void) nativeh;
+  (void) flags;
+  (void) offset;
+  (void) bytes;
+#endif
+}
+
 io_handle::io_result<io_handle::buffers_type> io_handle::read(io_handle::io_request<io_handle::buffers_type> reqs, deadline d) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(this);
+#ifdef __linux__
+  linux_ioprio_scope ioprio(reqs.priority);
+#endif
   if(d)
   {
-    return errc::not_supported;
+    auto ret = do_deadline_read_write(_v, reqs, d, false);
+    if(ret)
+    {
+      drop_behind(_v, _flags, reqs.offset, ret.bytes_transferred());
+    }
+    return ret;
   }
   if(reqs.buffers.size() > IOV_MAX)
   {
@@ -111,10 +632,11 @@ io_handle::io_result<io_handle::buffers_type> io_handle::read(io_handle::io_requ
   {
     return posix_error();
   }
+  drop_behind(_v, _flags, reqs.offset, static_cast<size_t>(bytesread));
   for(size_t i = 0; i < reqs.buffers.size(); i++)
   {
     auto &buffer = reqs.buffers[i];
-    if(buffer.size() >= static_cast<size_t>(bytesread))
+    if(buffer.size() <= static_cast<size_t>(bytesread))
     {
       bytesread -= buffer.size();
     }
@@ -131,9 +653,12 @@ io_handle::io_result<io_handle::buffers_type> io_handle::read(io_handle::io_requ
 io_handle::io_result<io_handle::const_buffers_type> io_handle::write(io_handle::io_request<io_handle::const_buffers_type> reqs, deadline d) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(this);
+#ifdef __linux__
+  linux_ioprio_scope ioprio(reqs.priority);
+#endif
   if(d)
   {
-    return errc::not_supported;
+    return do_deadline_read_write(_v, reqs, d, true);
   }
   if(reqs.buffers.size() > IOV_MAX)
   {
@@ -178,7 +703,7 @@ io_handle::io_result<io_handle::const_buffers_type> io_handle::write(io_handle::
   for(size_t i = 0; i < reqs.buffers.size(); i++)
   {
     auto &buffer = reqs.buffers[i];
-    if(buffer.size() >= static_cast<size_t>(byteswritten))
+    if(buffer.size() <= static_cast<size_t>(byteswritten))
     {
       byteswritten -= buffer.size();
     }
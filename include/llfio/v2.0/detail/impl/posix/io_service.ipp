@@ -24,6 +24,11 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include "../../../async_file_handle.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <new>
+#include <thread>
+
 #include <pthread.h>
 #if LLFIO_USE_POSIX_AIO
 #include <aio.h>
@@ -34,9 +39,40 @@ Distributed under the Boost Software License, Version 1.0.
 #include <sys/types.h>
 #endif
 #endif
+#if LLFIO_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+#if LLFIO_USE_EVENTFD
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 LLFIO_V2_NAMESPACE_BEGIN
 
+#if LLFIO_USE_IO_URING && LLFIO_USE_EVENTFD
+// Even and non-zero, so it can be neither a timeout, a cancellation nor an aiocb
+static constexpr unsigned long long _io_uring_wakeup_user_data = 2;
+#endif
+
+// Tells the CPU that we are spinning, which saves power and yields to any sibling hyperthread
+static inline void _cpu_relax() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 static int interrupt_signal;
 static struct sigaction interrupt_signal_handler_old_action;
 struct ucontext;
@@ -105,6 +141,13 @@ void io_service::_block_interruption() noexcept
   {
     return;
   }
+#if LLFIO_USE_EVENTFD
+  if(_wakeup_fd != -1)
+  {
+    _need_signal = false;
+    return;
+  }
+#endif
   assert(!_blocked_interrupt_signal);
   sigset_t set{};
   sigemptyset(&set);
@@ -120,6 +163,13 @@ void io_service::_unblock_interruption() noexcept
   {
     return;
   }
+#if LLFIO_USE_EVENTFD
+  if(_wakeup_fd != -1)
+  {
+    _need_signal = true;
+    return;
+  }
+#endif
   assert(_blocked_interrupt_signal);
   if(_blocked_interrupt_signal != 0)
   {
@@ -132,13 +182,144 @@ void io_service::_unblock_interruption() noexcept
   }
 }
 
+struct io_service::_completion_pool_type
+{
+  using io_state_type = async_file_handle::_erased_io_state_type;
+  struct worker_type
+  {
+    std::mutex lock;
+    std::deque<io_state_type *> queue;
+  };
+  io_service *service;
+  std::vector<std::unique_ptr<worker_type>> workers;
+  std::vector<std::thread> threads;
+  size_t next{0};                  // round robin dealing, owning thread only
+  std::atomic<size_t> pending{0};  // queued but not yet taken by any thread
+  std::atomic<bool> done{false};
+  std::mutex sleep_lock;
+  std::condition_variable sleep_cond;
+  std::mutex finished_lock;
+  std::vector<io_state_type *> finished;  // executed, awaiting retirement by the owning thread
+
+  explicit _completion_pool_type(io_service *_service)
+      : service(_service)
+  {
+  }
+  ~_completion_pool_type()
+  {
+    {
+      std::lock_guard<std::mutex> g(sleep_lock);
+      done = true;
+    }
+    sleep_cond.notify_all();
+    for(auto &t : threads)
+    {
+      t.join();
+    }
+  }
+  void dispatch(io_state_type *state)
+  {
+    worker_type &w = *workers[next];
+    if(++next == workers.size())
+    {
+      next = 0;
+    }
+    {
+      std::lock_guard<std::mutex> g(w.lock);
+      w.queue.push_back(state);
+    }
+    ++pending;
+    {
+      std::lock_guard<std::mutex> g(sleep_lock);
+    }
+    sleep_cond.notify_one();
+  }
+  void worker(size_t idx)
+  {
+    for(;;)
+    {
+      io_state_type *state = nullptr;
+      // Newest work from my own deque first as it is most likely hot in cache
+      {
+        worker_type &w = *workers[idx];
+        std::lock_guard<std::mutex> g(w.lock);
+        if(!w.queue.empty())
+        {
+          state = w.queue.back();
+          w.queue.pop_back();
+        }
+      }
+      // Otherwise steal the oldest work from someone else's deque
+      for(size_t n = 1; state == nullptr && n < workers.size(); n++)
+      {
+        worker_type &w = *workers[(idx + n) % workers.size()];
+        std::lock_guard<std::mutex> g(w.lock);
+        if(!w.queue.empty())
+        {
+          state = w.queue.front();
+          w.queue.pop_front();
+        }
+      }
+      if(state == nullptr)
+      {
+        std::unique_lock<std::mutex> g(sleep_lock);
+        sleep_cond.wait(g, [this] { return pending != 0 || done; });
+        if(done)
+        {
+          return;
+        }
+        continue;
+      }
+      --pending;
+      (*state->erased_completion_handler())(state);
+      {
+        std::lock_guard<std::mutex> g(finished_lock);
+        finished.push_back(state);
+      }
+      service->_interrupt_run();
+    }
+  }
+};
+
 io_service::io_service()
+    : io_service(engine::posix_aio)
+{
+}
+
+io_service::io_service(engine e, unsigned queue_depth, io_uring_flag flags)
     : _work_queued(0)
 {
   _threadh = pthread_self();
 #if LLFIO_USE_POSIX_AIO
+  if(e == engine::io_uring)
+  {
+#if LLFIO_USE_IO_URING
+    unsigned setup_flags = 0;
+    if(flags & io_uring_flag::sqpoll)
+    {
+      setup_flags |= IORING_SETUP_SQPOLL;
+    }
+    if(flags & io_uring_flag::iopoll)
+    {
+      setup_flags |= IORING_SETUP_IOPOLL;
+    }
+    _io_uring_setup(queue_depth, setup_flags);
+#else
+    (void) queue_depth;
+    (void) flags;
+    throw std::runtime_error("io_uring support was not compiled in");  // NOLINT
+#endif
+  }
   _use_kqueues = true;
   _blocked_interrupt_signal = 0;
+#if LLFIO_USE_EVENTFD
+  // Only io_uring can wait upon the eventfd. A POSIX AIO read of it would park one of
+  // glibc's few AIO helper threads in read() for the lifetime of this service.
+  if(_use_io_uring)
+  {
+    _wakeup_setup();
+  }
+#endif
 #if LLFIO_COMPILE_KQUEUES
   _kqueueh = 0;
 #error todo
@@ -152,6 +333,18 @@ io_service::io_service()
 
 io_service::~io_service()
 {
+  if(_completion_pool)
+  {
+    // Pooled completions can only be retired by the owning thread
+    while(_work_queued != 0u && pthread_self() == _threadh)
+    {
+      if(!_retire_pooled_completions())
+      {
+        std::this_thread::yield();
+      }
+    }
+    _completion_pool.reset();
+  }
   if(_work_queued != 0u)
   {
 #ifndef NDEBUG
@@ -166,8 +359,14 @@ io_service::~io_service()
 #if LLFIO_COMPILE_KQUEUES
   if(_kqueueh)
     ::close(_kqueueh);
+#endif
+#if LLFIO_USE_EVENTFD
+  _wakeup_teardown();
 #endif
   _aiocbsv.clear();
+#if LLFIO_USE_IO_URING
+  _io_uring_teardown();
+#endif
   if(pthread_self() == _threadh)
   {
     _unblock_interruption();
@@ -191,7 +390,7 @@ void io_service::disable_kqueues()
       throw std::runtime_error("Cannot disable kqueues except from owning thread");  // NOLINT
     }
     // Is the global signal handler set yet?
-    if(interrupt_signal == 0)
+    if(interrupt_signal == 0 && !using_eventfd_wakeup())
     {
       set_interruption_signal();
     }
@@ -206,6 +405,511 @@ void io_service::disable_kqueues()
 #endif
   }
 }
+
+void io_service::disable_eventfd_wakeup()
+{
+#if LLFIO_USE_EVENTFD
+  if(_wakeup_fd != -1)
+  {
+    if(_work_queued != 0u)
+    {
+      throw std::runtime_error("Cannot disable eventfd wakeup if work is pending");  // NOLINT
+    }
+    if(pthread_self() != _threadh)
+    {
+      throw std::runtime_error("Cannot disable eventfd wakeup except from owning thread");  // NOLINT
+    }
+    _wakeup_teardown();
+    if(!_use_kqueues)
+    {
+      // Is the global signal handler set yet?
+      if(interrupt_signal == 0)
+      {
+        set_interruption_signal();
+      }
+      // Block interruption on this thread
+      _block_interruption();
+    }
+  }
+#endif
+}
+#endif
+
+result<void> io_service::set_completion_threads(size_t threads) noexcept
+{
+  if(pthread_self() != _threadh)
+  {
+    return errc::operation_not_supported;
+  }
+  if(_work_queued != 0u)
+  {
+    return errc::operation_in_progress;
+  }
+  try
+  {
+    _completion_pool.reset();
+    if(threads > 0)
+    {
+      auto pool = std::make_unique<_completion_pool_type>(this);
+      pool->workers.reserve(threads);
+      for(size_t n = 0; n < threads; n++)
+      {
+        pool->workers.push_back(std::make_unique<_completion_pool_type::worker_type>());
+      }
+      auto *p = pool.get();
+      _completion_pool = std::move(pool);
+      p->threads.reserve(threads);
+      for(size_t n = 0; n < threads; n++)
+      {
+        p->threads.emplace_back([p, n] { p->worker(n); });
+      }
+    }
+    return success();
+  }
+  catch(...)
+  {
+    _completion_pool.reset();
+    return error_from_exception();
+  }
+}
+
+size_t io_service::completion_threads() const noexcept
+{
+  return _completion_pool ? _completion_pool->threads.size() : 0;
+}
+
+bool io_service::_dispatch_completion(void *io_state) noexcept
+{
+  if(!_completion_pool)
+  {
+    return false;
+  }
+  try
+  {
+    _completion_pool->dispatch(static_cast<_completion_pool_type::io_state_type *>(io_state));
+    return true;
+  }
+  catch(...)
+  {
+    // Failed to enqueue, so complete inline instead
+    return false;
+  }
+}
+
+bool io_service::_retire_pooled_completions() noexcept
+{
+  std::vector<_completion_pool_type::io_state_type *> finished;
+  {
+    std::lock_guard<std::mutex> g(_completion_pool->finished_lock);
+    if(_completion_pool->finished.empty())
+    {
+      return false;
+    }
+    finished.swap(_completion_pool->finished);
+  }
+  for(auto *state : finished)
+  {
+    // Only now can the owning thread's io_state_ptr safely destroy the i/o state
+    --state->items_to_go;
+    _work_done();
+  }
+  return true;
+}
+
+void io_service::_interrupt_run() noexcept
+{
+  if(_use_kqueues)
+  {
+#if LLFIO_COMPILE_KQUEUES
+#error todo
+#endif
+  }
+#if LLFIO_USE_EVENTFD
+  else if(_wakeup_fd != -1)
+  {
+    // Only write if run_until() may be sleeping, and only once per sleep. If run_until() has not yet
+    // looked for posts, it will find ours, and if it has, it will sleep on the already readable eventfd.
+    if(_need_signal.exchange(false))
+    {
+      uint64_t v = 1;
+      while(-1 == ::write(_wakeup_fd, &v, sizeof(v)) && EINTR == errno)
+      {
+      }
+    }
+  }
+#endif
+  else
+  {
+    // If run_until() is exactly between the unblock of the signal and the beginning
+    // of the aio_suspend(), we need to pump this until run_until() notices
+    while(_need_signal)
+    {
+      //#  if LLFIO_HAVE_REALTIME_SIGNALS
+      //    sigval val = { 0 };
+      //    pthread_sigqueue(_threadh, interrupt_signal, val);
+      //#else
+      pthread_kill(_threadh, interrupt_signal);
+      //#  endif
+    }
+  }
+}
+#endif
+
+#if LLFIO_USE_EVENTFD
+void io_service::_wakeup_setup() noexcept
+{
+  _wakeup_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  // If this fails, we fall back to signals
+}
+
+void io_service::_wakeup_teardown() noexcept
+{
+  if(_wakeup_fd == -1)
+  {
+    return;
+  }
+  // Any poll of the eventfd still queued to io_uring is cancelled when the ring is closed
+  _wakeup_armed = false;
+  ::close(_wakeup_fd);
+  _wakeup_fd = -1;
+}
+
+result<void> io_service::_wakeup_arm() noexcept
+{
+  if(_wakeup_armed)
+  {
+    return success();
+  }
+  assert(_use_io_uring);
+  OUTCOME_TRYV(_io_uring_reserve(1));
+  auto *sqe = static_cast<struct io_uring_sqe *>(_io_uring_get_sqe());
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = _wakeup_fd;
+  sqe->poll_events = POLLIN;
+  sqe->user_data = _io_uring_wakeup_user_data;
+  _wakeup_armed = true;
+  return success();
+}
+#endif
+
+#if LLFIO_USE_IO_URING
+void io_service::_io_uring_setup(unsigned entries, unsigned setup_flags)
+{
+  struct io_uring_params p
+  {
+  };
+  memset(&p, 0, sizeof(p));
+  p.flags = setup_flags;
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+  if(fd < 0)
+  {
+    throw std::system_error(errno, std::system_category());  // NOLINT
+  }
+  _uring.fd = fd;
+  _uring.entries = p.sq_entries;
+  _uring.sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  _uring.cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  _uring.sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  const bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if(single_mmap)
+  {
+    _uring.sq_len = _uring.cq_len = std::max(_uring.sq_len, _uring.cq_len);
+  }
+  auto fail = [this] {
+    int errcode = errno;
+    _io_uring_teardown();
+    throw std::system_error(errcode, std::system_category());  // NOLINT
+  };
+  _uring.sq_ptr = ::mmap(nullptr, _uring.sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if(MAP_FAILED == _uring.sq_ptr)
+  {
+    _uring.sq_ptr = nullptr;
+    fail();
+  }
+  if(single_mmap)
+  {
+    _uring.cq_ptr = _uring.sq_ptr;
+  }
+  else
+  {
+    _uring.cq_ptr = ::mmap(nullptr, _uring.cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if(MAP_FAILED == _uring.cq_ptr)
+    {
+      _uring.cq_ptr = nullptr;
+      fail();
+    }
+  }
+  _uring.sqes = ::mmap(nullptr, _uring.sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if(MAP_FAILED == _uring.sqes)
+  {
+    _uring.sqes = nullptr;
+    fail();
+  }
+  auto *sq = static_cast<char *>(_uring.sq_ptr);
+  auto *cq = static_cast<char *>(_uring.cq_ptr);
+  _uring.sq_head = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+  _uring.sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+  _uring.sq_mask = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+  _uring.sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+  _uring.sq_flags = reinterpret_cast<unsigned *>(sq + p.sq_off.flags);
+  _uring.setup_flags = setup_flags;
+  _uring.sqe_tail = *_uring.sq_tail;
+  _uring.cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+  _uring.cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+  _uring.cq_mask = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+  _uring.cqes = cq + p.cq_off.cqes;
+  _use_io_uring = true;
+}
+
+void io_service::_io_uring_teardown() noexcept
+{
+  if(_uring.sqes != nullptr)
+  {
+    ::munmap(_uring.sqes, _uring.sqes_len);
+  }
+  if(_uring.cq_ptr != nullptr && _uring.cq_ptr != _uring.sq_ptr)
+  {
+    ::munmap(_uring.cq_ptr, _uring.cq_len);
+  }
+  if(_uring.sq_ptr != nullptr)
+  {
+    ::munmap(_uring.sq_ptr, _uring.sq_len);
+  }
+  if(_uring.fd >= 0)
+  {
+    ::close(_uring.fd);
+  }
+  _uring = _io_uring_type();
+  _use_io_uring = false;
+}
+
+result<void> io_service::_io_uring_reserve(unsigned n) noexcept
+{
+  if(n > _uring.entries)
+  {
+    return errc::invalid_argument;
+  }
+  // Everything obtained so far is filled in, and the kernel can only consume what it can see
+  _io_uring_commit();
+  auto space = [this] { return _uring.entries - (_uring.sqe_tail - __atomic_load_n(_uring.sq_head, __ATOMIC_ACQUIRE)); };
+  if((_uring.setup_flags & IORING_SETUP_SQPOLL) != 0)
+  {
+    // The kernel's polling thread consumes the submission queue, so wait a bounded time for it
+    for(size_t tries = 0; space() < n; tries++)
+    {
+      if(tries == 1000)
+      {
+        return errc::resource_unavailable_try_again;
+      }
+      OUTCOME_TRYV(_io_uring_submit());
+      std::this_thread::yield();
+    }
+    return success();
+  }
+  while(space() < n)
+  {
+    // Submit what we have so far without waiting for anything to complete
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, _uring.fd, _uring.to_submit, 0, 0, nullptr, 0));
+    if(ret < 0)
+    {
+      if(EINTR == errno)
+      {
+        continue;
+      }
+      if(EAGAIN == errno || EBUSY == errno)
+      {
+        return errc::resource_unavailable_try_again;
+      }
+      return posix_error();
+    }
+    _uring.to_submit -= static_cast<unsigned>(ret);
+    if(0 == ret && space() < n)
+    {
+      return errc::resource_unavailable_try_again;
+    }
+  }
+  return success();
+}
+
+void *io_service::_io_uring_get_sqe() noexcept
+{
+  const unsigned idx = _uring.sqe_tail & *_uring.sq_mask;
+  auto *sqe = static_cast<struct io_uring_sqe *>(_uring.sqes) + idx;
+  memset(sqe, 0, sizeof(*sqe));
+  _uring.sq_array[idx] = idx;
+  // Not published yet, as with IORING_SETUP_SQPOLL the kernel may consume a published entry at any moment
+  ++_uring.sqe_tail;
+  return sqe;
+}
+
+void io_service::_io_uring_commit() noexcept
+{
+  const unsigned tail = *_uring.sq_tail;
+  if(tail != _uring.sqe_tail)
+  {
+    _uring.to_submit += _uring.sqe_tail - tail;
+    // The release orders the filling in of the SQEs before the kernel can see them
+    __atomic_store_n(_uring.sq_tail, _uring.sqe_tail, __ATOMIC_RELEASE);
+  }
+}
+#endif
+
+#if LLFIO_USE_IO_URING
+result<void> io_service::_io_uring_submit() noexcept
+{
+  _io_uring_commit();
+  if((_uring.setup_flags & IORING_SETUP_SQPOLL) != 0)
+  {
+    // The kernel's polling thread will see the SQEs without a syscall, unless it has gone to sleep
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if((__atomic_load_n(_uring.sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) != 0)
+    {
+      if(syscall(__NR_io_uring_enter, _uring.fd, 0, 0, IORING_ENTER_SQ_WAKEUP, nullptr, 0) < 0 && EINTR != errno)
+      {
+        return posix_error();
+      }
+    }
+    _uring.to_submit = 0;
+    return success();
+  }
+  while(_uring.to_submit > 0)
+  {
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, _uring.fd, _uring.to_submit, 0, 0, nullptr, 0));
+    if(ret < 0)
+    {
+      if(EINTR == errno)
+      {
+        continue;
+      }
+      if(EAGAIN == errno || EBUSY == errno)
+      {
+        // run_until() will submit them later
+        break;
+      }
+      return posix_error();
+    }
+    _uring.to_submit -= static_cast<unsigned>(ret);
+    if(0 == ret)
+    {
+      break;
+    }
+  }
+  return success();
+}
+#endif
+
+result<void> io_service::_submit_batched() noexcept
+{
+#if LLFIO_USE_IO_URING
+  if(_use_io_uring)
+  {
+    // The SQEs are already in the ring, so all we need do is tell the kernel about them
+    return _io_uring_submit();
+  }
+#endif
+#if LLFIO_USE_POSIX_AIO
+  if(_batched_aiocbs.empty())
+  {
+    return success();
+  }
+  std::vector<struct aiocb *> batched;
+  batched.swap(_batched_aiocbs);
+  const size_t first = _aiocbsv.size();
+  try
+  {
+    _aiocbsv.insert(_aiocbsv.end(), batched.begin(), batched.end());
+  }
+  catch(...)
+  {
+    batched.swap(_batched_aiocbs);
+    return error_from_exception();
+  }
+#ifdef AIO_LISTIO_MAX
+  const size_t maxlist = AIO_LISTIO_MAX;
+#else
+  const size_t maxlist = batched.size();
+#endif
+  bool holes = false;
+  for(size_t n = 0; n < batched.size(); n += maxlist)
+  {
+    const size_t items = std::min(maxlist, batched.size() - n);
+    if(lio_listio(LIO_NOWAIT, _aiocbsv.data() + first + n, static_cast<int>(items), nullptr) < 0)
+    {
+      int errcode = errno;
+      // For EAGAIN, EINTR and EIO the status of each aiocb says whether it was queued and run_until()
+      // will reap them as usual. Otherwise nothing was queued, so fail every i/o in this list.
+      if(EAGAIN != errcode && EINTR != errcode && EIO != errcode)
+      {
+        for(size_t i = 0; i < items; i++)
+        {
+          // Completions may initiate more i/o and so reallocate _aiocbsv
+          struct aiocb **slot = _aiocbsv.data() + first + n + i;
+          auto io_state = static_cast<async_file_handle::_erased_io_state_type *>((*slot)->aio_sigevent.sigev_value.sival_ptr);
+          assert(io_state);
+          io_state->_system_io_completion(errcode, 0, slot);
+        }
+        holes = true;
+      }
+    }
+  }
+  if(holes)
+  {
+    _aiocbsv.erase(std::remove(_aiocbsv.begin(), _aiocbsv.end(), nullptr), _aiocbsv.end());
+  }
+  return success();
+#else
+#error todo
+#endif
+}
+
+#if LLFIO_USE_POSIX_AIO
+result<void> io_service::_submit_deferred() noexcept
+{
+  while(!_deferred_background.empty() && (_io_in_flight[0] == 0 || _io_in_flight[1] < _background_queue_depth))
+  {
+    const _deferred_io_type i = _deferred_background.front();
+    auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(i.aiocb->aio_sigevent.sigev_value.sival_ptr);
+    assert(io_state);
+#if LLFIO_USE_IO_URING
+    if(_use_io_uring)
+    {
+      // If the submission queue is full, try again on the next run_until()
+      if(!_io_uring_reserve(1))
+      {
+        return success();
+      }
+      _deferred_background.pop_front();
+      auto *sqe = static_cast<struct io_uring_sqe *>(_io_uring_get_sqe());
+      sqe->opcode = (i.aiocb->aio_lio_opcode == LIO_READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+      sqe->fd = i.aiocb->aio_fildes;
+      sqe->ioprio = static_cast<decltype(sqe->ioprio)>(linux_ioprio(io_state->priority));
+      sqe->addr = reinterpret_cast<uintptr_t>(i.iov);
+      sqe->len = 1;
+      sqe->off = i.aiocb->aio_offset;
+      sqe->user_data = reinterpret_cast<uintptr_t>(i.aiocb);
+      _io_issued(io_state->priority, 1);
+      continue;
+    }
+#endif
+    try
+    {
+      _aiocbsv.push_back(i.aiocb);
+    }
+    catch(...)
+    {
+      return error_from_exception();
+    }
+    _deferred_background.pop_front();
+    _io_issued(io_state->priority, 1);
+    if(-1 == ((i.aiocb->aio_lio_opcode == LIO_READ) ? aio_read(i.aiocb) : aio_write(i.aiocb)))
+    {
+      // Completions may initiate more i/o and so reallocate _aiocbsv
+      io_state->_system_io_completion(errno, 0, _aiocbsv.data() + _aiocbsv.size() - 1);
+      _aiocbsv.erase(std::remove(_aiocbsv.begin(), _aiocbsv.end(), nullptr), _aiocbsv.end());
+    }
+  }
+  return success();
+}
 #endif
 
 result<bool> io_service::run_until(deadline d) noexcept
@@ -218,6 +922,16 @@ result<bool> io_service::run_until(deadline d) noexcept
   {
     return errc::operation_not_supported;
   }
+#if LLFIO_USE_POSIX_AIO
+  if(!_batched_aiocbs.empty())
+  {
+    OUTCOME_TRYV(_submit_batched());
+  }
+  if(!_deferred_background.empty())
+  {
+    OUTCOME_TRYV(_submit_deferred());
+  }
+#endif
   std::chrono::steady_clock::time_point began_steady;
   std::chrono::system_clock::time_point end_utc;
   if(d)
@@ -278,76 +992,360 @@ result<bool> io_service::run_until(deadline d) noexcept
       }
     }
 #if LLFIO_USE_POSIX_AIO
-    int errcode = 0;
-    if(_use_kqueues)
+    // Retire any completions the pool has finished executing
+    if(_completion_pool && _retire_pooled_completions())
     {
-#if LLFIO_COMPILE_KQUEUES
-#error todo
-#endif
+      // We did work, so exit
+      // Block the interruption signal
+      _block_interruption();
+      return _work_queued != 0;
     }
-    else
+    int errcode = 0;
+    // If busy polling, spin with a bounded exponential backoff until ready() or a post,
+    // or until the busy poll period or the deadline expires
+    enum class spun_t
     {
-      if(aio_suspend(_aiocbsv.data(), _aiocbsv.size(), ts) < 0)
+      expired,
+      ready,
+      posted
+    };
+    auto spin_until = [&](auto &&ready) {
+      std::chrono::nanoseconds period = _busy_poll_period;
+      if(ts != nullptr)
       {
-        errcode = errno;
+        period = std::min(period, std::chrono::nanoseconds(ts->tv_sec * 1000000000LL + ts->tv_nsec));
+      }
+      if(period.count() <= 0)
+      {
+        return spun_t::expired;
+      }
+      const auto spin_begin = std::chrono::steady_clock::now(), spin_end = spin_begin + period;
+      auto spin_now = spin_begin;
+      spun_t spun = spun_t::expired;
+      unsigned backoff = 1;
+      for(;;)
+      {
+        if(ready())
+        {
+          spun = spun_t::ready;
+          break;
+        }
+        {
+          // If we can't get the lock, someone is posting
+          std::unique_lock<decltype(_posts_lock)> g(_posts_lock, std::try_to_lock);
+          if(!g.owns_lock() || !_posts.empty())
+          {
+            spun = spun_t::posted;
+            break;
+          }
+        }
+        spin_now = std::chrono::steady_clock::now();
+        if(spin_now >= spin_end)
+        {
+          break;
+        }
+        for(unsigned n = 0; n < backoff; n++)
+        {
+          _cpu_relax();
+        }
+        if(backoff < 64)
+        {
+          backoff <<= 1U;
+        }
+      }
+      if(spun != spun_t::expired)
+      {
+        spin_now = std::chrono::steady_clock::now();
+        ++_busy_poll_stats.spin_hits;
+      }
+      const auto spun_for = std::chrono::duration_cast<std::chrono::nanoseconds>(spin_now - spin_begin);
+      ++_busy_poll_stats.spins;
+      _busy_poll_stats.spinning += spun_for;
+      if(ts != nullptr)
+      {
+        // Whatever remains of the deadline is for sleeping
+        long long ns = ts->tv_sec * 1000000000LL + ts->tv_nsec - spun_for.count();
+        if(ns < 0)
+        {
+          ns = 0;
+        }
+        ts->tv_sec = ns / 1000000000LL;
+        ts->tv_nsec = ns % 1000000000LL;
+      }
+      return spun;
+    };
+#if LLFIO_USE_EVENTFD
+    // Make sure a post() can wake us before we sleep. An iopoll io_uring never sleeps.
+    if(_wakeup_fd != -1 && (_uring.setup_flags & IORING_SETUP_IOPOLL) == 0)
+    {
+      auto armed = _wakeup_arm();
+      if(!armed)
+      {
+        _block_interruption();
+        return std::move(armed).error();
       }
     }
-    // Block the interruption signal
-    _block_interruption();
-    if(errcode != 0)
+#endif
+#if LLFIO_USE_IO_URING
+    if(_use_io_uring)
     {
-      switch(errcode)
+      // Submit everything queued since the last call, and wait for at least one completion
+      // unless the deadline has already passed, in which case we simply poll
+      unsigned min_complete = 1;
+      bool cqes_ready = false;
+      if((_uring.setup_flags & IORING_SETUP_IOPOLL) != 0)
+      {
+        // Completions must be polled for, and timeouts are not supported, so poll and loop
+        min_complete = 0;
+      }
+      else if(_busy_poll_period.count() > 0)
       {
-      case EAGAIN:
-        if(d)
+        // Submit first, so there is something to poll for
+        auto submitted = _io_uring_submit();
+        if(!submitted)
         {
-          timedout = true;
+          _block_interruption();
+          return std::move(submitted).error();
         }
-        break;
-      case EINTR:
-        // Let him loop, recalculate any timeout and check for posts to be executed
-        break;
-      default:
-        return posix_error(errcode);
+        auto spun = spin_until([this] { return *_uring.cq_head != __atomic_load_n(_uring.cq_tail, __ATOMIC_ACQUIRE); });
+        if(spun == spun_t::posted)
+        {
+          _block_interruption();
+          continue;
+        }
+        cqes_ready = (spun == spun_t::ready);
+      }
+      if(_uring.timeout_armed != 0 && _io_uring_reserve(1))
+      {
+        // A timeout armed by a previous call which i/o beat is still in the kernel. Remove it, else
+        // a busy loop with long deadlines piles them up, and each takes a CQE slot when it fires.
+        auto *sqe = static_cast<struct io_uring_sqe *>(_io_uring_get_sqe());
+        sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = _uring.timeout_armed;
+        sqe->user_data = 0;
+        _uring.timeout_armed = 0;
+      }
+      if(ts != nullptr && min_complete > 0 && !cqes_ready)
+      {
+        if(ts->tv_sec == 0 && ts->tv_nsec == 0)
+        {
+          min_complete = 0;
+        }
+        else if(_io_uring_reserve(1))
+        {
+          // Each timeout is tagged with an odd user_data carrying its generation, so timeouts
+          // armed by previous calls which completed early can be told apart and ignored
+          _uring.timeout_ts[0] = ts->tv_sec;
+          _uring.timeout_ts[1] = ts->tv_nsec;
+          auto *sqe = static_cast<struct io_uring_sqe *>(_io_uring_get_sqe());
+          sqe->opcode = IORING_OP_TIMEOUT;
+          sqe->fd = -1;
+          sqe->addr = reinterpret_cast<uintptr_t>(_uring.timeout_ts);
+          sqe->len = 1;
+          sqe->user_data = (++_uring.timeout_generation << 1U) | 1U;
+          _uring.timeout_armed = sqe->user_data;
+        }
+      }
+      int ret = 0;
+      if(!cqes_ready)
+      {
+        if((_uring.setup_flags & IORING_SETUP_SQPOLL) != 0)
+        {
+          // The kernel's polling thread submits, we need only wait
+          auto submitted = _io_uring_submit();
+          if(!submitted)
+          {
+            _block_interruption();
+            return std::move(submitted).error();
+          }
+        }
+        _io_uring_commit();
+        const auto sleep_begin = std::chrono::steady_clock::now();
+        ret = static_cast<int>(syscall(__NR_io_uring_enter, _uring.fd, _uring.to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+        if(min_complete > 0)
+        {
+          ++_busy_poll_stats.sleeps;
+          _busy_poll_stats.sleeping += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sleep_begin);
+        }
+      }
+      // Block the interruption signal
+      _block_interruption();
+      if(ret < 0)
+      {
+        errcode = errno;
+        if(EINTR != errcode && EAGAIN != errcode && EBUSY != errcode)
+        {
+          return posix_error(errcode);
+        }
+      }
+      else
+      {
+        _uring.to_submit -= static_cast<unsigned>(ret);
+      }
+      // Reap whatever completions there are
+      bool reaped = false, timer_fired = false;
+      unsigned head = *_uring.cq_head;
+      const unsigned tail = __atomic_load_n(_uring.cq_tail, __ATOMIC_ACQUIRE);
+      for(; head != tail; ++head)
+      {
+        const auto *cqe = static_cast<const struct io_uring_cqe *>(_uring.cqes) + (head & *_uring.cq_mask);
+        const unsigned long long user_data = cqe->user_data;
+        const int res = cqe->res;
+        // Release the CQE before invoking the completion, which may queue more i/o
+        __atomic_store_n(_uring.cq_head, head + 1, __ATOMIC_RELEASE);
+        if((user_data & 1U) != 0)
+        {
+          if(user_data == _uring.timeout_armed)
+          {
+            // Fired or removed, either way no longer in the kernel
+            _uring.timeout_armed = 0;
+          }
+          if((user_data >> 1U) == _uring.timeout_generation && -ECANCELED != res)
+          {
+            timer_fired = true;
+          }
+          continue;
+        }
+        if(0 == user_data)
+        {
+          // Cancellation and timeout removal requests complete with a zero user_data
+          continue;
+        }
+#if LLFIO_USE_EVENTFD
+        if(_io_uring_wakeup_user_data == user_data)
+        {
+          // post() wrote to the eventfd, so reset it and loop round to execute the post
+          while(-1 == ::read(_wakeup_fd, &_wakeup_value, sizeof(_wakeup_value)) && EINTR == errno)
+          {
+          }
+          _wakeup_armed = false;
+          continue;
+        }
+#endif
+        // The user_data points at the aiocb for this buffer within the i/o state, and its
+        // aio_sigevent.sigev_value.sival_ptr field points at the file_handle::_io_state_type
+        auto *aiocb = reinterpret_cast<struct aiocb *>(static_cast<uintptr_t>(user_data));
+        auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(aiocb->aio_sigevent.sigev_value.sival_ptr);
+        assert(io_state);
+        if(res < 0)
+        {
+          io_state->_system_io_completion(-res, 0, &aiocb);
+        }
+        else
+        {
+          io_state->_system_io_completion(0, res, &aiocb);
+        }
+        reaped = true;
+      }
+      if(reaped)
+      {
+        done = true;
+      }
+      else if(d && (timer_fired || 0 == min_complete || EAGAIN == errcode || EBUSY == errcode))
+      {
+        timedout = true;
       }
     }
     else
+#endif
     {
-      // Poll the outstanding aiocbs to see which are ready
-      for(auto &aiocb : _aiocbsv)
+      if(_use_kqueues)
+      {
+#if LLFIO_COMPILE_KQUEUES
+#error todo
+#endif
+      }
+      else
       {
-        int ioerr = aio_error(aiocb);
-        if(EINPROGRESS == ioerr)
+        bool aiocbs_ready = false;
+        if(_busy_poll_period.count() > 0)
         {
-          continue;
+          auto spun = spin_until([this] {
+            for(auto *aiocb : _aiocbsv)
+            {
+              if(EINPROGRESS != aio_error(aiocb))
+              {
+                return true;
+              }
+            }
+            return false;
+          });
+          if(spun == spun_t::posted)
+          {
+            _block_interruption();
+            continue;
+          }
+          aiocbs_ready = (spun == spun_t::ready);
         }
-        if(0 == ioerr)
+        if(!aiocbs_ready)
         {
-          // Scavenge the aio
-          int ioret = aio_return(aiocb);
-          if(ioret < 0)
+          const auto sleep_begin = std::chrono::steady_clock::now();
+          if(aio_suspend(_aiocbsv.data(), _aiocbsv.size(), ts) < 0)
           {
-            return posix_error();
+            errcode = errno;
           }
-          // std::cout << "aiocb " << aiocb << " sees succesful return " << ioret << std::endl;
-          // The aiocb aio_sigevent.sigev_value.sival_ptr field will point to a file_handle::_io_state_type
-          auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(aiocb->aio_sigevent.sigev_value.sival_ptr);
-          assert(io_state);
-          io_state->_system_io_completion(0, ioret, &aiocb);
+          ++_busy_poll_stats.sleeps;
+          _busy_poll_stats.sleeping += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sleep_begin);
         }
-        else
+      }
+      // Block the interruption signal
+      _block_interruption();
+      if(errcode != 0)
+      {
+        switch(errcode)
         {
-          // Either cancelled or errored out
-          // std::cout << "aiocb " << aiocb << " sees failed return " << ioerr << std::endl;
-          // The aiocb aio_sigevent.sigev_value.sival_ptr field will point to a file_handle::_io_state_type
-          auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(aiocb->aio_sigevent.sigev_value.sival_ptr);
-          assert(io_state);
-          io_state->_system_io_completion(ioerr, 0, &aiocb);
+        case EAGAIN:
+          if(d)
+          {
+            timedout = true;
+          }
+          break;
+        case EINTR:
+          // Let him loop, recalculate any timeout and check for posts to be executed
+          break;
+        default:
+          return posix_error(errcode);
         }
       }
-      // Eliminate any empty holes in the quick aiocbs vector
-      _aiocbsv.erase(std::remove(_aiocbsv.begin(), _aiocbsv.end(), nullptr), _aiocbsv.end());
-      done = true;
+      else
+      {
+        // Poll the outstanding aiocbs to see which are ready
+        for(auto &aiocb : _aiocbsv)
+        {
+          int ioerr = aio_error(aiocb);
+          if(EINPROGRESS == ioerr)
+          {
+            continue;
+          }
+          if(0 == ioerr)
+          {
+            // Scavenge the aio
+            int ioret = aio_return(aiocb);
+            if(ioret < 0)
+            {
+              return posix_error();
+            }
+            // std::cout << "aiocb " << aiocb << " sees succesful return " << ioret << std::endl;
+            // The aiocb aio_sigevent.sigev_value.sival_ptr field will point to a file_handle::_io_state_type
+            auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(aiocb->aio_sigevent.sigev_value.sival_ptr);
+            assert(io_state);
+            io_state->_system_io_completion(0, ioret, &aiocb);
+          }
+          else
+          {
+            // Either cancelled or errored out
+            // std::cout << "aiocb " << aiocb << " sees failed return " << ioerr << std::endl;
+            // The aiocb aio_sigevent.sigev_value.sival_ptr field will point to a file_handle::_io_state_type
+            auto io_state = static_cast<async_file_handle::_erased_io_state_type *>(aiocb->aio_sigevent.sigev_value.sival_ptr);
+            assert(io_state);
+            io_state->_system_io_completion(ioerr, 0, &aiocb);
+          }
+        }
+        // Eliminate any empty holes in the quick aiocbs vector
+        _aiocbsv.erase(std::remove(_aiocbsv.begin(), _aiocbsv.end(), nullptr), _aiocbsv.end());
+        done = true;
+      }
     }
 #else
 #error todo
@@ -382,26 +1380,7 @@ void io_service::_post(detail::function_ptr<void(io_service *)> &&f)
   }
   _work_enqueued();
 #if LLFIO_USE_POSIX_AIO
-  if(_use_kqueues)
-  {
-#if LLFIO_COMPILE_KQUEUES
-#error todo
-#endif
-  }
-  else
-  {
-    // If run_until() is exactly between the unblock of the signal and the beginning
-    // of the aio_suspend(), we need to pump this until run_until() notices
-    while(_need_signal)
-    {
-      //#  if LLFIO_HAVE_REALTIME_SIGNALS
-      //    sigval val = { 0 };
-      //    pthread_sigqueue(_threadh, interrupt_signal, val);
-      //#else
-      pthread_kill(_threadh, interrupt_signal);
-      //#  endif
-    }
-  }
+  _interrupt_run();
 #else
 #error todo
 #endif
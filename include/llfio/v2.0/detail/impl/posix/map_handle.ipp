@@ -35,6 +35,11 @@ Distributed under the Boost Software License, Version 1.0.
 #include "quickcpplib/include/signal_guard.hpp"
 #endif
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
 #include <sys/mman.h>
 
 LLFIO_V2_NAMESPACE_BEGIN
@@ -135,6 +140,154 @@ result<section_handle::extent_type> section_handle::truncate(extent_type newsize
 /******************************************* map_handle *********************************************/
 
 
+namespace detail
+{
+  struct map_handle_cache_item_t
+  {
+    byte *addr;
+    size_t bytes;
+    std::chrono::steady_clock::time_point when;
+  };
+  struct map_handle_cache_t
+  {
+    std::mutex lock;
+    // Bin N holds maps of more than 2^(N-1) and up to 2^N pages, least recently freed first
+    std::vector<map_handle_cache_item_t> bins[sizeof(size_t) * __CHAR_BIT__ + 1];
+    size_t capacity{64 * 1024 * 1024};
+    map_handle::cache_statistics stats;
+
+    static size_t bin_for(size_t bytes) noexcept
+    {
+      const size_t pages = bytes / utils::page_size();
+      return (pages <= 1) ? 0 : (sizeof(unsigned long long) * __CHAR_BIT__ - __builtin_clzll(static_cast<unsigned long long>(pages - 1)));
+    }
+    // Must be called with lock held
+    void unmap(std::vector<map_handle_cache_item_t> &bin, size_t idx) noexcept
+    {
+      ::munmap(bin[idx].addr, bin[idx].bytes);
+      stats.items_in_cache--;
+      stats.bytes_in_cache -= bin[idx].bytes;
+      stats.items_just_trimmed++;
+      stats.bytes_just_trimmed += bin[idx].bytes;
+      bin.erase(bin.begin() + idx);
+    }
+    // Must be called with lock held
+    void trim_to_capacity(size_t extra) noexcept
+    {
+      while(stats.items_in_cache > 0 && stats.bytes_in_cache + extra > capacity)
+      {
+        std::vector<map_handle_cache_item_t> *oldest = nullptr;
+        for(auto &bin : bins)
+        {
+          if(!bin.empty() && (oldest == nullptr || bin.front().when < oldest->front().when))
+          {
+            oldest = &bin;
+          }
+        }
+        unmap(*oldest, 0);
+      }
+    }
+    // Returns a recycled map of exactly bytes, or null
+    byte *get(size_t bytes) noexcept
+    {
+      std::lock_guard<std::mutex> g(lock);
+      if(capacity == 0)
+      {
+        return nullptr;
+      }
+      auto &bin = bins[bin_for(bytes)];
+      // Most recently freed first, as its pages are most likely to still be in the CPU caches
+      for(size_t n = bin.size() - 1; n < bin.size(); n--)
+      {
+        if(bin[n].bytes == bytes)
+        {
+          byte *ret = bin[n].addr;
+          bin.erase(bin.begin() + n);
+          stats.items_in_cache--;
+          stats.bytes_in_cache -= bytes;
+          stats.hits++;
+          return ret;
+        }
+      }
+      stats.misses++;
+      return nullptr;
+    }
+    // Returns true if the map was taken into the cache
+    bool add(byte *addr, size_t bytes) noexcept
+    {
+#ifdef MADV_FREE
+      {
+        std::lock_guard<std::mutex> g(lock);
+        if(bytes > capacity)
+        {
+          return false;
+        }
+      }
+      // Let the kernel reclaim the pages whenever it likes, without needing a TLB shootdown now
+      if(-1 == ::madvise(addr, bytes, MADV_FREE))
+      {
+        return false;
+      }
+      std::lock_guard<std::mutex> g(lock);
+      if(bytes > capacity)
+      {
+        return false;
+      }
+      trim_to_capacity(bytes);
+      try
+      {
+        bins[bin_for(bytes)].push_back({addr, bytes, std::chrono::steady_clock::now()});
+      }
+      catch(...)
+      {
+        return false;
+      }
+      stats.items_in_cache++;
+      stats.bytes_in_cache += bytes;
+      return true;
+#else
+      (void) addr;
+      (void) bytes;
+      return false;
+#endif
+    }
+  };
+  inline map_handle_cache_t &map_handle_cache() noexcept
+  {
+    // Never destroyed, as maps may be closed during static deinitialisation
+    static map_handle_cache_t *v = new map_handle_cache_t;
+    return *v;
+  }
+  // Only plain read write anonymous maps of the system page size are recycled
+  inline bool map_handle_is_cacheable(section_handle::flag _flag, size_t pagesize) noexcept { return _flag == section_handle::flag::readwrite && pagesize == utils::page_size(); }
+}  // namespace detail
+
+map_handle::cache_statistics map_handle::trim_cache(std::chrono::steady_clock::time_point older_than) noexcept
+{
+  auto &cache = detail::map_handle_cache();
+  std::lock_guard<std::mutex> g(cache.lock);
+  cache.stats.items_just_trimmed = 0;
+  cache.stats.bytes_just_trimmed = 0;
+  for(auto &bin : cache.bins)
+  {
+    while(!bin.empty() && bin.front().when < older_than)
+    {
+      cache.unmap(bin, 0);
+    }
+  }
+  return cache.stats;
+}
+
+size_t map_handle::set_cache_capacity(size_t bytes) noexcept
+{
+  auto &cache = detail::map_handle_cache();
+  std::lock_guard<std::mutex> g(cache.lock);
+  const size_t ret = cache.capacity;
+  cache.capacity = bytes;
+  cache.trim_to_capacity(0);
+  return ret;
+}
+
 map_handle::~map_handle()
 {
   if(_v)
@@ -159,9 +312,16 @@ result<void> map_handle::close() noexcept
       OUTCOME_TRYV(map_handle::barrier({}, true, false));
     }
     // printf("%d munmap %p-%p\n", getpid(), _addr, _addr+_reservation);
-    if(-1 == ::munmap(_addr, _reservation))
+    if(_section != nullptr || !_recyclable || !detail::map_handle_is_cacheable(_flag, _pagesize) || !detail::map_handle_cache().add(_addr, _reservation))
     {
-      return posix_error();
+      if(-1 == ::munmap(_addr, _reservation))
+      {
+        return posix_error();
+      }
+      if(_section != nullptr)
+      {
+        _section->_on_unmap(_addr, _reservation);
+      }
     }
   }
   // We don't want ~handle() to close our borrowed handle
@@ -224,6 +384,37 @@ map_handle::io_result<map_handle::const_buffers_type> map_handle::barrier(map_ha
 }
 
 
+namespace detail
+{
+  // The size of page the kernel uses for transparent huge pages
+  inline size_t transparent_huge_page_size() noexcept
+  {
+    static const size_t v = [] {
+      size_t ret = 0;
+#ifdef __linux__
+      int fd = ::open("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", O_RDONLY | O_CLOEXEC);
+      if(-1 != fd)
+      {
+        char buffer[32];
+        auto bytes = ::read(fd, buffer, sizeof(buffer) - 1);
+        ::close(fd);
+        if(bytes > 0)
+        {
+          buffer[bytes] = 0;
+          ret = static_cast<size_t>(strtoull(buffer, nullptr, 10));
+        }
+      }
+#endif
+      if(ret == 0)
+      {
+        ret = 2 * 1024 * 1024;
+      }
+      return ret;
+    }();
+    return v;
+  }
+}  // namespace detail
+
 static inline result<void *> do_mmap(native_handle_type &nativeh, void *ataddr, int extra_flags, section_handle *section, map_handle::size_type pagesize, map_handle::size_type &bytes, map_handle::extent_type offset, section_handle::flag _flag) noexcept
 {
   bool have_backing = (section != nullptr);
@@ -304,6 +495,32 @@ static inline result<void *> do_mmap(native_handle_type &nativeh, void *ataddr,
 #error Do not know how to specify large/huge/super pages on this platform
 #endif
   }
+#ifdef __linux__
+  void *thp_reservation = nullptr;
+  size_t thp_reservation_bytes = 0, thpsize = 0;
+  if((_flag & section_handle::flag::transparent_huge_pages) && pagesize == utils::page_size())
+  {
+    thpsize = detail::transparent_huge_page_size();
+    if(ataddr == nullptr)
+    {
+      // Place the view at an address congruent to its offset modulo the huge page size, else the kernel cannot use huge pages
+      thp_reservation_bytes = utils::round_up_to_page_size(bytes, pagesize) + thpsize;
+      thp_reservation = ::mmap(nullptr, thp_reservation_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if(MAP_FAILED == thp_reservation)
+      {
+        return posix_error();
+      }
+      const auto reservation = reinterpret_cast<uintptr_t>(thp_reservation);
+      auto at = ((reservation + thpsize - 1) & ~(thpsize - 1)) + static_cast<uintptr_t>(offset % thpsize);
+      if(at - thpsize >= reservation)
+      {
+        at -= thpsize;
+      }
+      ataddr = reinterpret_cast<void *>(at);
+      flags |= MAP_FIXED;
+    }
+  }
+#endif
 // printf("mmap(%p, %u, %d, %d, %d, %u)\n", ataddr, (unsigned) bytes, prot, flags, have_backing ? section->native_handle().fd : -1, (unsigned) offset);
 #ifdef MAP_SYNC  // Linux kernel 4.15 or later only
   // If backed by a file into persistent shared memory, ask the kernel to use persistent memory safe semantics
@@ -321,8 +538,41 @@ static inline result<void *> do_mmap(native_handle_type &nativeh, void *ataddr,
   // printf("%d mmap %p-%p\n", getpid(), addr, (char *) addr+bytes);
   if(MAP_FAILED == addr)  // NOLINT
   {
+#ifdef __linux__
+    if(thp_reservation != nullptr)
+    {
+      int errcode = errno;
+      ::munmap(thp_reservation, thp_reservation_bytes);
+      return posix_error(errcode);
+    }
+#endif
     return posix_error();
   }
+#ifdef __linux__
+  if(thpsize != 0)
+  {
+    if(thp_reservation != nullptr)
+    {
+      // Release the unused parts of the reservation either side of the view
+      auto *reservation = static_cast<byte *>(thp_reservation), *view = static_cast<byte *>(addr);
+      const size_t viewbytes = utils::round_up_to_page_size(bytes, pagesize);
+      if(view > reservation)
+      {
+        ::munmap(reservation, view - reservation);
+      }
+      if(view + viewbytes < reservation + thp_reservation_bytes)
+      {
+        ::munmap(view + viewbytes, (reservation + thp_reservation_bytes) - (view + viewbytes));
+      }
+    }
+    // These are requests, which fail if transparent huge pages are disabled or not supported by the backing
+    (void) ::madvise(addr, bytes, MADV_HUGEPAGE);
+    if(_flag & section_handle::flag::prefault)
+    {
+      (void) ::madvise(addr, bytes, 25 /*MADV_COLLAPSE*/);
+    }
+  }
+#endif
 #if 0  // not implemented yet, not seen any benefit over setting this at the fd level
   if(have_backing && ((flags & map_handle::flag::disable_prefetching) || (flags & map_handle::flag::maximum_prefetching)))
   {
@@ -334,9 +584,8 @@ static inline result<void *> do_mmap(native_handle_type &nativeh, void *ataddr,
   return addr;
 }
 
-result<map_handle> map_handle::map(size_type bytes, bool /*unused*/, section_handle::flag _flag) noexcept
+result<map_handle> map_handle::map(size_type bytes, bool zeroed, section_handle::flag _flag) noexcept
 {
-  // TODO: Keep a cache of MADV_FREE pages deallocated
   if(bytes == 0u)
   {
     return errc::argument_out_of_domain;
@@ -345,7 +594,27 @@ result<map_handle> map_handle::map(size_type bytes, bool /*unused*/, section_han
   result<map_handle> ret(map_handle(nullptr, _flag));
   native_handle_type &nativeh = ret.value()._v;
   OUTCOME_TRY(pagesize, detail::pagesize_from_flags(ret.value()._flag));
-  OUTCOME_TRY(addr, do_mmap(nativeh, nullptr, 0, nullptr, pagesize, bytes, 0, ret.value()._flag));
+#ifdef __linux__
+  if((_flag & section_handle::flag::transparent_huge_pages) && pagesize == utils::page_size())
+  {
+    bytes = utils::round_up_to_page_size(bytes, detail::transparent_huge_page_size());
+  }
+#endif
+  void *addr = nullptr;
+  if(!zeroed && detail::map_handle_is_cacheable(ret.value()._flag, pagesize))
+  {
+    addr = detail::map_handle_cache().get(bytes);
+    if(addr != nullptr)
+    {
+      // As do_mmap() would have done
+      nativeh.behaviour |= native_handle_type::disposition::seekable | native_handle_type::disposition::readable | native_handle_type::disposition::writable;
+    }
+  }
+  if(addr == nullptr)
+  {
+    OUTCOME_TRY(addr_, do_mmap(nativeh, nullptr, 0, nullptr, pagesize, bytes, 0, ret.value()._flag));
+    addr = addr_;
+  }
   ret.value()._addr = static_cast<byte *>(addr);
   ret.value()._reservation = bytes;
   ret.value()._length = bytes;
@@ -355,16 +624,22 @@ result<map_handle> map_handle::map(size_type bytes, bool /*unused*/, section_han
 }
 
 result<map_handle> map_handle::map(section_handle &section, size_type bytes, extent_type offset, section_handle::flag _flag) noexcept
+{
+  return map(nullptr, section, bytes, offset, _flag);
+}
+
+result<map_handle> map_handle::map(byte *address, section_handle &section, size_type bytes, extent_type offset, section_handle::flag _flag) noexcept
 {
   OUTCOME_TRY(length, section.length());  // length of the backing file
   if(bytes == 0u)
   {
     bytes = length - offset;
   }
+  OUTCOME_TRYV(section._can_map());
   result<map_handle> ret{map_handle(&section, _flag)};
   native_handle_type &nativeh = ret.value()._v;
   OUTCOME_TRY(pagesize, detail::pagesize_from_flags(ret.value()._flag));
-  OUTCOME_TRY(addr, do_mmap(nativeh, nullptr, 0, &section, pagesize, bytes, offset, ret.value()._flag));
+  OUTCOME_TRY(addr, do_mmap(nativeh, address, (address != nullptr) ? MAP_FIXED : 0, &section, pagesize, bytes, offset, ret.value()._flag));
   ret.value()._addr = static_cast<byte *>(addr);
   ret.value()._offset = offset;
   ret.value()._reservation = bytes;
@@ -372,6 +647,8 @@ result<map_handle> map_handle::map(section_handle &section, size_type bytes, ext
   ret.value()._pagesize = pagesize;
   // Make my handle borrow the native handle of my backing storage
   ret.value()._v.fd = section.native_handle().fd;
+  // If this fails, the map is unmapped by ret's destructor
+  OUTCOME_TRYV(section._on_map(ret.value()._addr, bytes, offset));
   LLFIO_LOG_FUNCTION_CALL(&ret);
   return ret;
 }
@@ -398,11 +675,20 @@ result<map_handle::size_type> map_handle::truncate(size_type newsize, bool permi
     {
       return posix_error();
     }
+    if(_section != nullptr)
+    {
+      _section->_on_unmap(_addr, _reservation);
+    }
     _addr = nullptr;
     _reservation = 0;
     _length = 0;
     return 0;
   }
+  // Fail before disturbing the map if the section cannot take it
+  if(_section != nullptr)
+  {
+    OUTCOME_TRYV(_section->_can_map());
+  }
   // If not mapped yet ...
   if(_addr == nullptr)
   {
@@ -410,6 +696,10 @@ result<map_handle::size_type> map_handle::truncate(size_type newsize, bool permi
     _addr = static_cast<byte *>(addr);
     _reservation = newsize;
     _length = (length - _offset < newsize) ? (length - _offset) : newsize;  // length of backing, not reservation
+    if(_section != nullptr)
+    {
+      OUTCOME_TRYV(_section->_on_map(_addr, _reservation, _offset));
+    }
     return newsize;
   }
 #ifdef __linux__
@@ -419,9 +709,17 @@ result<map_handle::size_type> map_handle::truncate(size_type newsize, bool permi
   {
     return posix_error();
   }
+  if(_section != nullptr)
+  {
+    _section->_on_unmap(_addr, _reservation);
+  }
   _addr = static_cast<byte *>(newaddr);
   _reservation = newsize;
   _length = (length - _offset < newsize) ? (length - _offset) : newsize;  // length of backing, not reservation
+  if(_section != nullptr)
+  {
+    OUTCOME_TRYV(_section->_on_map(_addr, _reservation, _offset));
+  }
   return newsize;
 #else
   // Try to expand reservation in place
@@ -461,6 +759,129 @@ result<map_handle::size_type> map_handle::truncate(size_type newsize, bool permi
 #endif
 }
 
+result<map_handle::page_statistics> map_handle::page_usage() const noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+#ifdef __linux__
+  try
+  {
+    std::string smaps;
+    {
+      int fd = ::open("/proc/self/smaps", O_RDONLY | O_CLOEXEC);
+      if(-1 == fd)
+      {
+        return posix_error();
+      }
+      char buffer[65536];
+      for(;;)
+      {
+        auto bytes = ::read(fd, buffer, sizeof(buffer));
+        if(bytes < 0)
+        {
+          int errcode = errno;
+          ::close(fd);
+          return posix_error(errcode);
+        }
+        if(bytes == 0)
+        {
+          break;
+        }
+        smaps.append(buffer, static_cast<size_t>(bytes));
+      }
+      ::close(fd);
+    }
+    page_statistics ret;
+    ret.page_size = _pagesize;
+    const auto begin = reinterpret_cast<uintptr_t>(_addr), end = begin + _reservation;
+    bool inmap = false;
+    size_type kernelpagesize = 0;
+    // The kernel merges adjacent maps with the same properties into one region, so only count
+    // the proportion of each region's large pages which this map covers
+    double proportion = 0;
+    auto scale = [&proportion](size_type value) { return utils::round_down_to_page_size(static_cast<size_type>(static_cast<double>(value) * proportion + 0.5), utils::page_size()); };
+    for(size_t idx = 0; idx < smaps.size();)
+    {
+      size_t eol = smaps.find('\n', idx);
+      if(eol == std::string::npos)
+      {
+        eol = smaps.size();
+      }
+      const char *line = smaps.c_str() + idx;
+      char *e;
+      // Region headers begin with "start-end ", fields with "Name:"
+      const uintptr_t start = strtoull(line, &e, 16);
+      if(*e == '-')
+      {
+        const uintptr_t finish = strtoull(e + 1, &e, 16);
+        inmap = (*e == ' ' && start < end && begin < finish);
+        kernelpagesize = 0;
+        if(inmap)
+        {
+          proportion = static_cast<double>((std::min)(finish, end) - (std::max)(start, begin)) / static_cast<double>(finish - start);
+        }
+      }
+      else if(inmap)
+      {
+        const char *colon = strchr(line, ':');
+        if(colon != nullptr && colon < smaps.c_str() + eol)
+        {
+          const std::string field(line, colon - line);
+          const size_type value = static_cast<size_type>(strtoull(colon + 1, nullptr, 10)) * 1024;
+          if(field == "KernelPageSize")
+          {
+            kernelpagesize = value;
+            if(value > ret.page_size)
+            {
+              ret.page_size = value;
+            }
+          }
+          else if(field == "AnonHugePages" || field == "ShmemPmdMapped" || field == "FilePmdMapped")
+          {
+            ret.large_pages += scale(value);
+            if(value > 0 && detail::transparent_huge_page_size() > ret.page_size)
+            {
+              ret.page_size = detail::transparent_huge_page_size();
+            }
+          }
+          else if((field == "Private_Hugetlb" || field == "Shared_Hugetlb") && kernelpagesize > utils::page_size())
+          {
+            ret.large_pages += scale(value);
+          }
+        }
+      }
+      idx = eol + 1;
+    }
+    // Whereas which pages of exactly this map are resident is known
+    const size_t pagesize = utils::page_size();
+    unsigned char vec[4096];
+    for(size_type done = 0; done < _reservation;)
+    {
+      const size_type bytes = (std::min)(_reservation - done, static_cast<size_type>(sizeof(vec) * pagesize));
+      if(-1 == ::mincore(_addr + done, bytes, vec))
+      {
+        return posix_error();
+      }
+      for(size_t n = 0; n < bytes / pagesize; n++)
+      {
+        if((vec[n] & 1) != 0)
+        {
+          ret.resident += pagesize;
+        }
+      }
+      done += bytes;
+    }
+    ret.large_pages = (std::min)(ret.large_pages, ret.resident);
+    return ret;
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+#else
+  return errc::operation_not_supported;
+#endif
+}
+
 result<map_handle::buffer_type> map_handle::commit(buffer_type region, section_handle::flag flag) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(this);
@@ -473,6 +894,11 @@ result<map_handle::buffer_type> map_handle::commit(buffer_type region, section_h
   extent_type offset = _offset + (region.data() - _addr);
   size_type bytes = region.size();
   OUTCOME_TRYV(do_mmap(_v, region.data(), MAP_FIXED, _section, _pagesize, bytes, offset, flag));
+  if(_section == nullptr && flag != _flag)
+  {
+    // Some of this map now has different permissions, so it can no longer be recycled on close
+    _recyclable = false;
+  }
   // Tell the kernel we will be using these pages soon
   if(-1 == ::madvise(region.data(), region.size(), MADV_WILLNEED))
   {
@@ -498,6 +924,11 @@ result<map_handle::buffer_type> map_handle::decommit(buffer_type region) noexcep
   extent_type offset = _offset + (region.data() - _addr);
   size_type bytes = region.size();
   OUTCOME_TRYV(do_mmap(_v, region.data(), MAP_FIXED, _section, _pagesize, bytes, offset, section_handle::flag::none));
+  if(_section == nullptr)
+  {
+    // Some of this map is now inaccessible, so it can no longer be recycled on close
+    _recyclable = false;
+  }
   return region;
 }
 
@@ -536,6 +967,46 @@ result<span<map_handle::buffer_type>> map_handle::prefetch(span<buffer_type> reg
   return regions;
 }
 
+namespace detail
+{
+  // Faults in every page of region, returning false if the kernel cannot do so for us
+  inline result<bool> map_handle_populate(map_handle::buffer_type region, bool for_write) noexcept
+  {
+#ifdef __linux__
+    // Probe once on a page known to be good, as EINVAL is also returned for regions which
+    // cannot be populated, such as VM_PFNMAP and VM_IO regions, or those lacking permission
+    static const bool supported = [] {
+      const size_t pagesize = utils::page_size();
+      void *p = ::mmap(nullptr, pagesize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(MAP_FAILED == p)
+      {
+        return false;
+      }
+      // Before Linux 5.14
+      const bool ret = (-1 != ::madvise(p, pagesize, 22 /*MADV_POPULATE_READ*/)) || (EINVAL != errno);
+      ::munmap(p, pagesize);
+      return ret;
+    }();
+    if(supported)
+    {
+      if(-1 != ::madvise(region.data(), region.size(), for_write ? 23 /*MADV_POPULATE_WRITE*/ : 22 /*MADV_POPULATE_READ*/))
+      {
+        return true;
+      }
+      if(EFAULT == errno || EINVAL == errno)
+      {
+        return errc::bad_address;
+      }
+      return posix_error();
+    }
+#else
+    (void) region;
+    (void) for_write;
+#endif
+    return false;
+  }
+}  // namespace detail
+
 result<map_handle::buffer_type> map_handle::do_not_store(buffer_type region) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(0);
@@ -26,6 +26,12 @@ Distributed under the Boost Software License, Version 1.0.
 #include "../../../stat.hpp"
 
 #include <sys/stat.h>
+#ifdef __linux__
+#include <atomic>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>  // for makedev
+#include <unistd.h>
+#endif
 
 LLFIO_V2_NAMESPACE_BEGIN
 
@@ -78,9 +84,186 @@ inline struct timespec from_timepoint(std::chrono::system_clock::time_point time
   return {static_cast<time_t>(duration.count() / STL_TICKS_PER_SEC), static_cast<long int>((duration.count() % STL_TICKS_PER_SEC) * divider / multiplier)};
 }
 
+#if defined(__linux__) && defined(SYS_statx)
+namespace detail
+{
+  /* The kernel's struct statx. glibc only gained one in 2.28, and its copy lacks the fields
+  added since, so the kernel ABI is spelled out here.
+  */
+  struct statx_t
+  {
+    struct timestamp_t
+    {
+      int64_t tv_sec;
+      uint32_t tv_nsec;
+      int32_t reserved;
+    };
+    uint32_t stx_mask, stx_blksize;
+    uint64_t stx_attributes;
+    uint32_t stx_nlink, stx_uid, stx_gid;
+    uint16_t stx_mode, spare0;
+    uint64_t stx_ino, stx_size, stx_blocks, stx_attributes_mask;
+    timestamp_t stx_atime, stx_btime, stx_ctime, stx_mtime;
+    uint32_t stx_rdev_major, stx_rdev_minor, stx_dev_major, stx_dev_minor;
+    uint64_t stx_mnt_id;
+    uint32_t stx_dio_mem_align, stx_dio_offset_align;
+    uint64_t spare3[12];
+  };
+  static_assert(sizeof(statx_t) == 256, "statx_t does not match the kernel's struct statx");
+  // The STATX_* mask bits
+  enum statx_mask : unsigned
+  {
+    statx_type = 0x1U,
+    statx_mode = 0x2U,
+    statx_nlink = 0x4U,
+    statx_uid = 0x8U,
+    statx_gid = 0x10U,
+    statx_atime = 0x20U,
+    statx_mtime = 0x40U,
+    statx_ctime = 0x80U,
+    statx_ino = 0x100U,
+    statx_size = 0x200U,
+    statx_blocks = 0x400U,
+    statx_btime = 0x800U,
+    statx_dioalign = 0x2000U
+  };
+  inline std::atomic<bool> &statx_unsupported() noexcept
+  {
+    static std::atomic<bool> v(false);
+    return v;
+  }
+  /* statx() without syncing attributes with the server on network filing systems. Returns -1
+  with errno set to ENOSYS if the kernel does not have statx(), remembering that for next time.
+  */
+  inline int do_statx(int dirfd, const char *path, int flags, unsigned mask, statx_t &stx) noexcept
+  {
+    if(statx_unsupported().load(std::memory_order_relaxed))
+    {
+      errno = ENOSYS;
+      return -1;
+    }
+    int ret = static_cast<int>(syscall(SYS_statx, dirfd, path, flags | 0x4000 /*AT_STATX_DONT_SYNC*/, mask, &stx));
+    if(-1 == ret && ENOSYS == errno)
+    {
+      statx_unsupported().store(true, std::memory_order_relaxed);
+    }
+    return ret;
+  }
+  // The statx() mask which fetches the wanted fields. Device ids and block size are always returned.
+  inline unsigned statx_mask_from(stat_t::want wanted) noexcept
+  {
+    unsigned mask = 0;
+    if(wanted & stat_t::want::type)
+    {
+      mask |= statx_type;
+    }
+    if(wanted & stat_t::want::perms)
+    {
+      mask |= statx_mode;
+    }
+    if(wanted & stat_t::want::nlink)
+    {
+      mask |= statx_nlink;
+    }
+    if(wanted & stat_t::want::uid)
+    {
+      mask |= statx_uid;
+    }
+    if(wanted & stat_t::want::gid)
+    {
+      mask |= statx_gid;
+    }
+    if(wanted & stat_t::want::atim)
+    {
+      mask |= statx_atime;
+    }
+    if(wanted & stat_t::want::mtim)
+    {
+      mask |= statx_mtime;
+    }
+    if(wanted & stat_t::want::ctim)
+    {
+      mask |= statx_ctime;
+    }
+    if(wanted & stat_t::want::ino)
+    {
+      mask |= statx_ino;
+    }
+    if(wanted & (stat_t::want::size | stat_t::want::sparse))
+    {
+      mask |= statx_size;
+    }
+    if(wanted & (stat_t::want::allocated | stat_t::want::blocks | stat_t::want::sparse))
+    {
+      mask |= statx_blocks;
+    }
+    if(wanted & stat_t::want::birthtim)
+    {
+      mask |= statx_btime;
+    }
+    return mask;
+  }
+  inline std::chrono::system_clock::time_point to_timepoint(statx_t::timestamp_t ts)
+  {
+    struct timespec _ts
+    {
+    };
+    _ts.tv_sec = static_cast<time_t>(ts.tv_sec);
+    _ts.tv_nsec = static_cast<long>(ts.tv_nsec);
+    return LLFIO_V2_NAMESPACE::to_timepoint(_ts);
+  }
+  /* Fills the wanted fields of out which statx() returned, setting filled to those fields.
+  Returns the number of fields filled.
+  */
+  inline size_t fill_from_statx(stat_t &out, const statx_t &stx, stat_t::want wanted, stat_t::want &filled) noexcept
+  {
+    filled = stat_t::want::none;
+    size_t ret = 0;
+    auto fill = [&](stat_t::want field, unsigned needed, auto &&f) {
+      if((wanted & field) && (stx.stx_mask & needed) == needed)
+      {
+        f();
+        filled |= field;
+        ++ret;
+      }
+    };
+    fill(stat_t::want::dev, 0, [&] { out.st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor); });
+    fill(stat_t::want::ino, statx_ino, [&] { out.st_ino = stx.stx_ino; });
+    fill(stat_t::want::type, statx_type, [&] { out.st_type = to_st_type(stx.stx_mode); });
+    fill(stat_t::want::perms, statx_mode, [&] { out.st_perms = stx.stx_mode & 0xfff; });
+    fill(stat_t::want::nlink, statx_nlink, [&] { out.st_nlink = static_cast<int16_t>(stx.stx_nlink); });
+    fill(stat_t::want::uid, statx_uid, [&] { out.st_uid = static_cast<int16_t>(stx.stx_uid); });
+    fill(stat_t::want::gid, statx_gid, [&] { out.st_gid = static_cast<int16_t>(stx.stx_gid); });
+    fill(stat_t::want::rdev, 0, [&] { out.st_rdev = makedev(stx.stx_rdev_major, stx.stx_rdev_minor); });
+    fill(stat_t::want::atim, statx_atime, [&] { out.st_atim = to_timepoint(stx.stx_atime); });
+    fill(stat_t::want::mtim, statx_mtime, [&] { out.st_mtim = to_timepoint(stx.stx_mtime); });
+    fill(stat_t::want::ctim, statx_ctime, [&] { out.st_ctim = to_timepoint(stx.stx_ctime); });
+    fill(stat_t::want::size, statx_size, [&] { out.st_size = stx.stx_size; });
+    fill(stat_t::want::allocated, statx_blocks, [&] { out.st_allocated = static_cast<handle::extent_type>(stx.stx_blocks) * 512; });
+    fill(stat_t::want::blocks, statx_blocks, [&] { out.st_blocks = stx.stx_blocks; });
+    fill(stat_t::want::blksize, 0, [&] { out.st_blksize = static_cast<uint16_t>(stx.stx_blksize); });
+    fill(stat_t::want::birthtim, statx_btime, [&] { out.st_birthtim = to_timepoint(stx.stx_btime); });
+    fill(stat_t::want::sparse, statx_size | statx_blocks, [&] { out.st_sparse = static_cast<unsigned int>((static_cast<handle::extent_type>(stx.stx_blocks) * 512) < static_cast<handle::extent_type>(stx.stx_size)); });
+    return ret;
+  }
+}  // namespace detail
+#endif
+
 LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<size_t> stat_t::fill(const handle &h, stat_t::want wanted) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(&h);
+#if defined(__linux__) && defined(SYS_statx)
+  {
+    // Only ask for what is wanted, so network filing systems can skip fetching the rest
+    detail::statx_t stx{};
+    if(-1 != detail::do_statx(h.native_handle().fd, "", 0x1000 /*AT_EMPTY_PATH*/, detail::statx_mask_from(wanted), stx))
+    {
+      stat_t::want filled(stat_t::want::none);
+      return detail::fill_from_statx(*this, stx, wanted, filled);
+    }
+    // Fall back onto fstat(), which handles all the corner cases
+  }
+#endif
   struct stat s
   {
   };
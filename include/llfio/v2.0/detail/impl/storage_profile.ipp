@@ -22,6 +22,7 @@ Distributed under the Boost Software License, Version 1.0.
           http://www.boost.org/LICENSE_1_0.txt)
 */
 
+#include "../../async_file_handle.hpp"
 #include "../../directory_handle.hpp"
 #include "../../file_handle.hpp"
 #include "../../statfs.hpp"
@@ -1141,6 +1142,106 @@ namespace storage_profile
       sp.readwrite_qd4_99999.value = s._99999;
       return success();
     }
+    outcome<void> durable_write_qd1(storage_profile &sp, file_handle &srch) noexcept
+    {
+      if(sp.durable_write_qd1_fused_mean.value != static_cast<unsigned long long>(-1))
+      {
+        return success();
+      }
+      try
+      {
+        using clock = std::chrono::high_resolution_clock;
+        io_service service;
+        OUTCOME_TRY(base, srch.parent_path_handle());
+        OUTCOME_TRY(h, async_file_handle::async_temp_inode(service, base));
+        OUTCOME_TRYV(h.truncate(4096));
+        alignas(4096) byte buffer[4096];
+        memset(buffer, 78, 4096);
+        async_file_handle::const_buffer_type bt{buffer, 4096};
+        std::vector<unsigned long long> twostep, fused;
+        for(auto *results : {&twostep, &fused})
+        {
+          const bool is_fused = (results == &fused);
+          auto begin = clock::now();
+          while(std::chrono::duration_cast<std::chrono::seconds>(clock::now() - begin).count() < 5)
+          {
+            bool done = false;
+            result<void> err = success();
+            async_file_handle::io_state_ptr barrier_state;
+            auto completed = [&](async_file_handle * /*unused*/, async_file_handle::io_result<async_file_handle::const_buffers_type> &&r) {
+              if(!r)
+              {
+                err = r.error();
+              }
+              done = true;
+            };
+            auto opbegin = clock::now();
+            result<async_file_handle::io_state_ptr> write_state(errc::invalid_argument);
+            if(is_fused)
+            {
+              write_state = h.async_write_and_barrier({bt, 0}, completed);
+            }
+            else
+            {
+              // Issue the barrier from the completion of the write, as a durable append would
+              write_state = h.async_write({bt, 0}, [&](async_file_handle *fh, async_file_handle::io_result<async_file_handle::const_buffers_type> &&r) {
+                if(!r)
+                {
+                  err = r.error();
+                  done = true;
+                  return;
+                }
+                auto s = fh->async_barrier({bt, 0}, completed, false, false);
+                if(!s)
+                {
+                  err = s.error();
+                  done = true;
+                  return;
+                }
+                barrier_state = std::move(s).value();
+              });
+            }
+            if(!write_state && write_state.error() == errc::operation_not_supported)
+            {
+              // Asynchronous barriers are not supported on this platform
+              return success();
+            }
+            OUTCOME_TRYV(write_state);
+            while(!done)
+            {
+              OUTCOME_TRYV(service.run());
+            }
+            auto opend = clock::now();
+            OUTCOME_TRYV(err);
+            results->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(opend - opbegin).count());
+          }
+          if(results->empty())
+          {
+            return errc::timed_out;
+          }
+          std::sort(results->begin(), results->end());
+        }
+        auto mean = [](const std::vector<unsigned long long> &results) {
+          unsigned long long sum = 0;
+          for(const auto &i : results)
+          {
+            sum += i;
+          }
+          return static_cast<unsigned long long>(static_cast<double>(sum) / results.size());
+        };
+        sp.durable_write_qd1_twostep_mean.value = mean(twostep);
+        sp.durable_write_qd1_twostep_50.value = twostep[static_cast<size_t>(0.5 * twostep.size())];
+        sp.durable_write_qd1_twostep_99.value = twostep[static_cast<size_t>(0.99 * twostep.size())];
+        sp.durable_write_qd1_fused_mean.value = mean(fused);
+        sp.durable_write_qd1_fused_50.value = fused[static_cast<size_t>(0.5 * fused.size())];
+        sp.durable_write_qd1_fused_99.value = fused[static_cast<size_t>(0.99 * fused.size())];
+        return success();
+      }
+      catch(...)
+      {
+        return std::current_exception();
+      }
+    }
     outcome<void> read_nothing(storage_profile &sp, file_handle &srch) noexcept
     {
       if(sp.read_nothing.value != static_cast<unsigned>(-1))
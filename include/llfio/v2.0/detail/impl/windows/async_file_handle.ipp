@@ -57,7 +57,11 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
       auto &result = this->result.write;
       if(result)
       {
-        if(errcode)
+        if(this->cancel_requested && ERROR_OPERATION_ABORTED == errcode)
+        {
+          result = errc::operation_canceled;
+        }
+        else if(errcode)
         {
           result = win32_error(errcode);
         }
@@ -80,19 +84,32 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
         (*completion)(this);
       }
     }
-    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~state_type() override final
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> cancel() noexcept override final
     {
-      // Do we need to cancel pending i/o?
-      if(this->items_to_go)
+      if(!this->items_to_go)
       {
-        for(size_t n = 0; n < this->items; n++)
+        return success();
+      }
+      this->cancel_requested = true;
+      for(size_t n = 0; n < this->items; n++)
+      {
+        // If this is non-zero, probably this i/o still in flight
+        if(ols[n].hEvent)
         {
-          // If this is non-zero, probably this i/o still in flight
-          if(ols[n].hEvent)
+          if(!CancelIoEx(this->parent->native_handle().h, ols + n) && ERROR_NOT_FOUND != GetLastError())
           {
-            CancelIoEx(this->parent->native_handle().h, ols + n);
+            return win32_error();
           }
         }
+      }
+      return success();
+    }
+    LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~state_type() override final
+    {
+      // Do we need to cancel pending i/o?
+      if(this->items_to_go)
+      {
+        (void) cancel();
         // Pump the i/o service until all pending i/o is completed
         while(this->items_to_go)
         {
@@ -129,18 +146,35 @@ template <class BuffersType, class IORoutine> result<async_file_handle::io_state
   }
 
   bool must_deallocate_self = false;
+  int cache_bucket = -1;
   if(mem.empty())
   {
-    void *_mem = ::calloc(1, statelen);  // NOLINT
+    // Size the allocation for the largest number of buffers in its size class so the i/o service can recycle it
+    size_t allocbytes = statelen;
+    cache_bucket = io_service::_io_state_bucket(items);
+    if(cache_bucket >= 0 && completion.bytes() <= io_service::_io_state_cache_type::completion_bytes)
+    {
+      allocbytes = sizeof(state_type) + ((static_cast<size_t>(1) << cache_bucket) - 1) * sizeof(OVERLAPPED) + io_service::_io_state_cache_type::completion_bytes;
+    }
+    else
+    {
+      cache_bucket = -1;
+    }
+    void *_mem = service()->_allocate_io_state(cache_bucket, allocbytes);
     if(!_mem)
     {
       return errc::not_enough_memory;
     }
-    mem = {static_cast<char *>(_mem), statelen};
+    mem = {static_cast<char *>(_mem), allocbytes};
     must_deallocate_self = true;
   }
   io_state_ptr _state(reinterpret_cast<state_type *>(mem.data()));
   new((state = reinterpret_cast<state_type *>(mem.data()))) state_type(this, operation, must_deallocate_self, items);
+  if(must_deallocate_self)
+  {
+    state->cache_bucket = cache_bucket;
+    state->cache_owner = service();
+  }
   state->completion = reinterpret_cast<_erased_completion_handler *>(reinterpret_cast<uintptr_t>(state) + sizeof(state_type) + (reqs.buffers.size() - 1) * sizeof(OVERLAPPED));
   completion.move(state->completion);
 
@@ -214,6 +248,8 @@ result<async_file_handle::io_state_ptr> async_file_handle::_begin_io(span<char>
   case operation_t::dsync_async:
   case operation_t::fsync_sync:
   case operation_t::dsync_sync:
+  case operation_t::write_and_fsync:
+  case operation_t::write_and_dsync:
     break;
   }
   return errc::operation_not_supported;
@@ -357,6 +357,7 @@ result<file_handle::extent_type> file_handle::maximum_extent() const noexcept
 result<file_handle::extent_type> file_handle::truncate(file_handle::extent_type newsize) noexcept
 {
   LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
   FILE_END_OF_FILE_INFO feofi{};
   feofi.EndOfFile.QuadPart = newsize;
   if(SetFileInformationByHandle(_v.h, FileEndOfFileInfo, &feofi, sizeof(feofi)) == 0)
@@ -377,6 +378,10 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
   LLFIO_LOG_FUNCTION_CALL(this);
   try
   {
+    if(_extents_cache != nullptr && _extents_cache->valid)
+    {
+      return _extents_cache->extents;
+    }
     static_assert(sizeof(std::pair<file_handle::extent_type, file_handle::extent_type>) == sizeof(FILE_ALLOCATED_RANGE_BUFFER), "FILE_ALLOCATED_RANGE_BUFFER is not equivalent to pair<extent_type, extent_type>!");
     std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>> ret;
 #ifdef NDEBUG
@@ -403,6 +408,11 @@ result<std::vector<std::pair<file_handle::extent_type, file_handle::extent_type>
         return win32_error();
       }
     }
+    if(_extents_cache != nullptr)
+    {
+      _extents_cache->extents = ret;
+      _extents_cache->valid = true;
+    }
     return ret;
   }
   catch(...)
@@ -420,6 +430,7 @@ result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offs
   {
     return errc::value_too_large;
   }
+  invalidate_extents_cache();
   FILE_ZERO_DATA_INFORMATION fzdi{};
   fzdi.FileOffset.QuadPart = offset;
   fzdi.BeyondFinalZero.QuadPart = offset + bytes;
@@ -445,4 +456,102 @@ result<file_handle::extent_type> file_handle::zero(file_handle::extent_type offs
   return success();
 }
 
+result<file_handle::extent_type> file_handle::preallocate(file_handle::extent_type offset, file_handle::extent_type bytes, bool keep_size) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  if(offset + bytes < offset)
+  {
+    return errc::value_too_large;
+  }
+  invalidate_extents_cache();
+  FILE_STANDARD_INFO fsi{};
+  if(GetFileInformationByHandleEx(_v.h, FileStandardInfo, &fsi, sizeof(fsi)) == 0)
+  {
+    return win32_error();
+  }
+  // NTFS cannot allocate a range in the middle of a file, only raise the allocation size
+  if(offset + bytes > static_cast<extent_type>(fsi.AllocationSize.QuadPart))
+  {
+    FILE_ALLOCATION_INFO fai{};
+    fai.AllocationSize.QuadPart = offset + bytes;
+    if(SetFileInformationByHandle(_v.h, FileAllocationInfo, &fai, sizeof(fai)) == 0)
+    {
+      return win32_error();
+    }
+  }
+  if(!keep_size && offset + bytes > static_cast<extent_type>(fsi.EndOfFile.QuadPart))
+  {
+    OUTCOME_TRYV(truncate(offset + bytes));
+  }
+  return bytes;
+}
+
+result<file_handle::extent_type> file_handle::zero_range(file_handle::extent_type offset, file_handle::extent_type bytes, deadline d) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  invalidate_extents_cache();
+  // Never write past the end of the file, as that would change its maximum extent
+  OUTCOME_TRY(size, maximum_extent());
+  if(offset >= size)
+  {
+    return bytes;
+  }
+  try
+  {
+    extent_type towrite = (std::min)(bytes, size - offset);
+    auto blocksize = utils::file_buffer_default_size();
+    byte *buffer = utils::page_allocator<byte>().allocate(blocksize);
+    auto unbufferh = undoer([buffer, blocksize] { utils::page_allocator<byte>().deallocate(buffer, blocksize); });
+    (void) unbufferh;
+    while(towrite > 0)
+    {
+      OUTCOME_TRY(written, write(offset, {{buffer, static_cast<size_t>((std::min)(towrite, static_cast<extent_type>(blocksize)))}}, d));
+      offset += written;
+      towrite -= written;
+    }
+    return bytes;
+  }
+  catch(...)
+  {
+    return error_from_exception();
+  }
+}
+
+result<void> file_handle::collapse_range(file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  return errc::operation_not_supported;
+}
+
+result<void> file_handle::insert_range(file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  return errc::operation_not_supported;
+}
+
+result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> file_handle::prefetch(span<std::pair<file_handle::extent_type, file_handle::extent_type>> /*unused*/) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  // Windows has no ranged read ahead advice for files
+  return span<std::pair<extent_type, extent_type>>();
+}
+
+result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> file_handle::evict(span<std::pair<file_handle::extent_type, file_handle::extent_type>> /*unused*/) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  // Windows has no ranged cache eviction for files
+  return span<std::pair<extent_type, extent_type>>();
+}
+
+namespace detail
+{
+  // Windows only offers block cloning on ReFS, which is not implemented here
+  inline bool file_handle_clone_range(file_handle & /*unused*/, file_handle & /*unused*/, file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/) noexcept { return false; }
+  inline result<file_handle::extent_type> file_handle_copy_range(file_handle & /*unused*/, file_handle & /*unused*/, file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/, file_handle::extent_type /*unused*/, bool &supported) noexcept
+  {
+    supported = false;
+    return 0;
+  }
+}  // namespace detail
+
 LLFIO_V2_NAMESPACE_END
@@ -67,6 +67,12 @@ result<bool> io_service::run_until(deadline d) noexcept
   return _work_queued != 0;
 }
 
+result<void> io_service::_submit_batched() noexcept
+{
+  // i/o is always initiated immediately on Windows
+  return success();
+}
+
 void io_service::_post(detail::function_ptr<void(io_service *)> &&f)
 {
   LLFIO_LOG_FUNCTION_CALL(this);
@@ -598,14 +598,35 @@ result<map_handle> map_handle::map(size_type bytes, bool /*unused*/, section_han
   return ret;
 }
 
+map_handle::cache_statistics map_handle::trim_cache(std::chrono::steady_clock::time_point /*unused*/) noexcept
+{
+  // Not implemented yet on Windows, so there is never anything cached
+  return {};
+}
+
+size_t map_handle::set_cache_capacity(size_t /*unused*/) noexcept
+{
+  return 0;
+}
+
+result<map_handle::page_statistics> map_handle::page_usage() const noexcept
+{
+  return errc::operation_not_supported;
+}
+
 result<map_handle> map_handle::map(section_handle &section, size_type bytes, extent_type offset, section_handle::flag _flag) noexcept
+{
+  return map(nullptr, section, bytes, offset, _flag);
+}
+
+result<map_handle> map_handle::map(byte *address, section_handle &section, size_type bytes, extent_type offset, section_handle::flag _flag) noexcept
 {
   windows_nt_kernel::init();
   using namespace windows_nt_kernel;
   result<map_handle> ret{map_handle(&section, _flag)};
   native_handle_type &nativeh = ret.value()._v;
   ULONG allocation = 0, prot;
-  PVOID addr = nullptr;
+  PVOID addr = address;
   size_t commitsize = bytes;
   LARGE_INTEGER _offset{};
   _offset.QuadPart = offset;
@@ -830,6 +851,12 @@ result<void> map_handle::zero_memory(buffer_type region) noexcept
   return success();
 }
 
+namespace detail
+{
+  // Windows has no way of getting the kernel to synchronously populate a region, so the pages must be touched
+  inline result<bool> map_handle_populate(map_handle::buffer_type /*unused*/, bool /*unused*/) noexcept { return false; }
+}  // namespace detail
+
 result<span<map_handle::buffer_type>> map_handle::prefetch(span<buffer_type> regions) noexcept
 {
   windows_nt_kernel::init();
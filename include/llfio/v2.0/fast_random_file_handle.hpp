@@ -96,6 +96,7 @@ public:
   using const_buffer_type = io_handle::const_buffer_type;
   using buffers_type = io_handle::buffers_type;
   using const_buffers_type = io_handle::const_buffers_type;
+  using io_priority = io_handle::io_priority;
   template <class T> using io_request = io_handle::io_request<T>;
   template <class T> using io_result = io_handle::io_result<T>;
 
@@ -68,6 +68,7 @@ public:
   using const_buffer_type = io_handle::const_buffer_type;
   using buffers_type = io_handle::buffers_type;
   using const_buffers_type = io_handle::const_buffers_type;
+  using io_priority = io_handle::io_priority;
   template <class T> using io_request = io_handle::io_request<T>;
   template <class T> using io_result = io_handle::io_result<T>;
   using dev_t = fs_handle::dev_t;
@@ -76,6 +77,12 @@ public:
 
 protected:
   io_service *_service{nullptr};
+  struct _extents_cache_type
+  {
+    bool valid{false};
+    std::vector<std::pair<extent_type, extent_type>> extents;
+  };
+  mutable _extents_cache_type *_extents_cache{nullptr};  // non-null if extents() is cached
 
 public:
   //! Default constructor
@@ -92,7 +99,11 @@ public:
   //! No copy assignment
   file_handle &operator=(const file_handle &) = delete;
   //! Implicit move construction of file_handle permitted
-  constexpr file_handle(file_handle &&o) noexcept : io_handle(std::move(o)), fs_handle(std::move(o)), _service(o._service) { o._service = nullptr; }
+  constexpr file_handle(file_handle &&o) noexcept : io_handle(std::move(o)), fs_handle(std::move(o)), _service(o._service), _extents_cache(o._extents_cache)
+  {
+    o._service = nullptr;
+    o._extents_cache = nullptr;
+  }
   //! Explicit conversion from handle and io_handle permitted
   explicit constexpr file_handle(handle &&o, dev_t devid, ino_t inode) noexcept : io_handle(std::move(o)), fs_handle(devid, inode), _service(nullptr) {}
   //! Move assignment of file_handle permitted
@@ -192,6 +203,7 @@ public:
     {
       (void) file_handle::close();
     }
+    delete _extents_cache;
   }
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> close() noexcept override
   {
@@ -276,10 +288,54 @@ public:
   \return A vector of pairs of extent offset + extent length representing the valid extents
   in this file. Filing systems which do not support extents return a single extent matching
   the length of the file rather than returning an error.
+
+  Extents which are allocated but unwritten, such as those made by `preallocate()` and
+  `zero_range()`, read as zeros and so are not valid extents, except where data has since
+  been written into them. On Linux this is so whether the extents come from `FIEMAP` or from
+  `SEEK_DATA`, so `clone_extents_to()` and `algorithm::copy_file()` recreate them as holes.
   */
   LLFIO_MAKE_FREE_FUNCTION
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<std::vector<std::pair<extent_type, extent_type>>> extents() const noexcept;
 
+  /*! \brief Enables or disables caching of the extents returned by `extents()` within this handle.
+
+  Enumerating the extents of a large, heavily fragmented sparse file is expensive. With the
+  cache enabled, `extents()` returns the extents it last fetched until the cache is invalidated
+  by `truncate()`, `zero()` or `clone_extents_to()` through this handle, or by
+  `invalidate_extents_cache()`. Writes, and any changes made through other handles, are
+  \b not seen, so only enable the cache if the extents are not being changed, or if you
+  invalidate it yourself after writing into holes. The cache is not thread safe.
+
+  \errors `errc::not_enough_memory` if the cache could not be allocated.
+  */
+  result<void> set_extents_cache(bool enable) noexcept
+  {
+    if(!enable)
+    {
+      delete _extents_cache;
+      _extents_cache = nullptr;
+    }
+    else if(_extents_cache == nullptr)
+    {
+      _extents_cache = new(std::nothrow) _extents_cache_type;
+      if(_extents_cache == nullptr)
+      {
+        return errc::not_enough_memory;
+      }
+    }
+    return success();
+  }
+  //! True if `extents()` is cached within this handle.
+  bool extents_cache_enabled() const noexcept { return _extents_cache != nullptr; }
+  //! Causes the next `extents()` to fetch the extents from the system, if they are cached.
+  void invalidate_extents_cache() const noexcept
+  {
+    if(_extents_cache != nullptr)
+    {
+      _extents_cache->valid = false;
+    }
+  }
+
   /*! \brief Efficiently zero, and possibly deallocate, data on storage.
 
   On most major operating systems and with recent filing systems which are "extents based", one can
@@ -301,6 +357,146 @@ public:
   */
   LLFIO_MAKE_FREE_FUNCTION
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> zero(extent_type offset, extent_type bytes, deadline d = deadline()) noexcept;
+
+  /*! \brief Allocates physical storage for a range of the file, so later writes into it
+  do not need to allocate extents.
+
+  On Linux this is `fallocate()`, and the range reads as zeros where it was not already
+  allocated. Elsewhere on POSIX this is `posix_fallocate()`, which cannot keep the size. On
+  Windows the allocation size of the file is raised to cover the range. The range is not
+  reported by `extents()` until it is written.
+
+  \return The bytes allocated.
+  \param offset The offset to start allocating from.
+  \param bytes The number of bytes to allocate.
+  \param keep_size If true, the maximum extent of the file is not increased even if the range
+  extends past it, so the storage allocated past the end is only used by later appends.
+  \errors Any of the values POSIX fallocate() or SetFileInformationByHandle() can return,
+  `errc::operation_not_supported` if `keep_size` is not supported by this platform.
+  \mallocs None.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> preallocate(extent_type offset, extent_type bytes, bool keep_size = false) noexcept;
+
+  /*! \brief Zeroes a range of the file, keeping its storage allocated.
+
+  Unlike `zero()`, which deallocates the storage, later writes into the range do not need to
+  allocate extents. On Linux this is `fallocate(FALLOC_FL_ZERO_RANGE)`, which usually converts
+  the extents to unwritten in constant time. Elsewhere, or if the filing system does not
+  support it, zeros are written. The maximum extent of the file is never changed.
+
+  \return The bytes zeroed.
+  \param offset The offset to start zeroing from.
+  \param bytes The number of bytes to zero.
+  \param d An optional deadline by which the i/o must complete, if zeros are written.
+  \errors Any of the values POSIX fallocate() or write() can return.
+  \mallocs One page allocation of `utils::file_buffer_default_size()` if zeros are written.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> zero_range(extent_type offset, extent_type bytes, deadline d = deadline()) noexcept;
+
+  /*! \brief Removes a range from the file, shifting the data after it down and reducing the
+  maximum extent of the file by the bytes removed.
+
+  This is `fallocate(FALLOC_FL_COLLAPSE_RANGE)` on Linux, where it is performed by remapping
+  extents rather than copying data, so it is a cheap way of trimming the head of a log.
+  `offset` and `bytes` must be multiples of the filing system's block size, and the range must
+  end before the end of the file.
+
+  \param offset The offset of the range to remove.
+  \param bytes The number of bytes to remove.
+  \errors Any of the values POSIX fallocate() can return, `errc::operation_not_supported` on
+  platforms and filing systems without support.
+  \mallocs None.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> collapse_range(extent_type offset, extent_type bytes) noexcept;
+
+  /*! \brief Inserts a hole into the file, shifting the data after it up and increasing the
+  maximum extent of the file by the bytes inserted.
+
+  This is `fallocate(FALLOC_FL_INSERT_RANGE)` on Linux, where it is performed by remapping
+  extents rather than copying data. `offset` and `bytes` must be multiples of the filing
+  system's block size, and `offset` must be before the end of the file.
+
+  \param offset The offset at which to insert.
+  \param bytes The number of bytes to insert.
+  \errors Any of the values POSIX fallocate() can return, `errc::operation_not_supported` on
+  platforms and filing systems without support.
+  \mallocs None.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> insert_range(extent_type offset, extent_type bytes) noexcept;
+
+  /*! \brief Ask the system to begin to asynchronously read the extents of the file given into
+  the kernel cache, returning the extents actually prefetched.
+
+  This is `posix_fadvise(POSIX_FADV_WILLNEED)` on POSIX, and `fcntl(F_RDADVISE)` on Mac OS.
+  Windows has no equivalent for files, so you will see an empty span returned. See also
+  `flag::maximum_prefetching` for advising the whole file at open.
+
+  \param extents The offset and length of each extent to prefetch. Passing `extents()`
+  prefetches the whole of the allocated file.
+  \errors Any of the values POSIX posix_fadvise() can return.
+  \mallocs None.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<span<std::pair<extent_type, extent_type>>> prefetch(span<std::pair<extent_type, extent_type>> extents) noexcept;
+  //! \overload
+  result<std::pair<extent_type, extent_type>> prefetch(extent_type offset, extent_type bytes) noexcept
+  {
+    std::pair<extent_type, extent_type> extent(offset, bytes);
+    OUTCOME_TRY(ret, prefetch(span<std::pair<extent_type, extent_type>>(&extent, 1)));
+    return ret.empty() ? std::pair<extent_type, extent_type>(offset, 0) : *ret.data();
+  }
+
+  /*! \brief Ask the system to drop the extents of the file given from the kernel cache,
+  returning the extents actually evicted.
+
+  This is `posix_fadvise(POSIX_FADV_DONTNEED)` on POSIX. Dirty pages are not evicted,
+  so issue a `barrier()` first if those are wanted gone too. Mac OS and Windows have no
+  equivalent, so you will see an empty span returned. See also `flag::drop_behind` for
+  evicting pages automatically as they are read.
+
+  \param extents The offset and length of each extent to evict.
+  \errors Any of the values POSIX posix_fadvise() can return.
+  \mallocs None.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<span<std::pair<extent_type, extent_type>>> evict(span<std::pair<extent_type, extent_type>> extents) noexcept;
+  //! \overload
+  result<std::pair<extent_type, extent_type>> evict(extent_type offset, extent_type bytes) noexcept
+  {
+    std::pair<extent_type, extent_type> extent(offset, bytes);
+    OUTCOME_TRY(ret, evict(span<std::pair<extent_type, extent_type>>(&extent, 1)));
+    return ret.empty() ? std::pair<extent_type, extent_type>(offset, 0) : *ret.data();
+  }
+
+  /*! \brief Copies a range of this file into another file without passing it through userspace
+  where possible, preserving holes.
+
+  On Linux this firstly tries to reflink the range with `FICLONERANGE`, which shares the
+  source's storage copy on write and so completes in constant time. This requires the offsets
+  to be aligned to the filing system's block size, and both files to be on the same filing
+  system. Failing that, each valid extent of the source (see `extents()`) is copied by the
+  kernel with `copy_file_range()`, and failing that by reads and writes through page aligned
+  buffers. Holes in the source become holes in the destination, and the destination is
+  extended if it is too short. On other platforms only the read and write loop is available.
+
+  \return The bytes of the source range cloned, which is less than requested if the range
+  extends past the end of the source.
+  \param dest The file to copy into. Must not be this file if the ranges overlap.
+  \param offset The offset within this file to copy from.
+  \param bytes The number of bytes to copy.
+  \param dest_offset The offset within the destination to copy to.
+  \errors `errc::value_too_large` if a range wraps, `errc::invalid_argument` if the ranges
+  overlap within the same file, any of the values `read()`, `write()`, `truncate()`, `zero()`
+  and `extents()` can return.
+  \mallocs One page allocation of `utils::file_buffer_default_size()` if the read and write
+  loop is used, plus the vector returned by `extents()`.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> clone_extents_to(file_handle &dest, extent_type offset, extent_type bytes, extent_type dest_offset) noexcept;
 };
 
 //! \brief Constructor for `file_handle`
@@ -438,6 +634,145 @@ inline result<file_handle::extent_type> zero(file_handle &self, file_handle::ext
 {
   return self.zero(std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes), std::forward<decltype(d)>(d));
 }
+/*! \brief Allocates physical storage for a range of the file, so later writes into it
+do not need to allocate extents.
+
+On Linux this is `fallocate()`, and the range reads as zeros where it was not already
+allocated. Elsewhere on POSIX this is `posix_fallocate()`, which cannot keep the size. On
+Windows the allocation size of the file is raised to cover the range.
+
+\return The bytes allocated.
+\param self The object whose member function to call.
+\param offset The offset to start allocating from.
+\param bytes The number of bytes to allocate.
+\param keep_size If true, the maximum extent of the file is not increased even if the range
+extends past it, so the storage allocated past the end is only used by later appends.
+\errors Any of the values POSIX fallocate() or SetFileInformationByHandle() can return,
+`errc::operation_not_supported` if `keep_size` is not supported by this platform.
+\mallocs None.
+*/
+inline result<file_handle::extent_type> preallocate(file_handle &self, file_handle::extent_type offset, file_handle::extent_type bytes, bool keep_size = false) noexcept
+{
+  return self.preallocate(std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes), std::forward<decltype(keep_size)>(keep_size));
+}
+/*! \brief Zeroes a range of the file, keeping its storage allocated.
+
+Unlike `zero()`, which deallocates the storage, later writes into the range do not need to
+allocate extents. On Linux this is `fallocate(FALLOC_FL_ZERO_RANGE)`, which usually converts
+the extents to unwritten in constant time. Elsewhere, or if the filing system does not
+support it, zeros are written. The maximum extent of the file is never changed.
+
+\return The bytes zeroed.
+\param self The object whose member function to call.
+\param offset The offset to start zeroing from.
+\param bytes The number of bytes to zero.
+\param d An optional deadline by which the i/o must complete, if zeros are written.
+\errors Any of the values POSIX fallocate() or write() can return.
+\mallocs One page allocation of `utils::file_buffer_default_size()` if zeros are written.
+*/
+inline result<file_handle::extent_type> zero_range(file_handle &self, file_handle::extent_type offset, file_handle::extent_type bytes, deadline d = deadline()) noexcept
+{
+  return self.zero_range(std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes), std::forward<decltype(d)>(d));
+}
+/*! \brief Removes a range from the file, shifting the data after it down and reducing the
+maximum extent of the file by the bytes removed.
+
+This is `fallocate(FALLOC_FL_COLLAPSE_RANGE)` on Linux, where it is performed by remapping
+extents rather than copying data, so it is a cheap way of trimming the head of a log.
+`offset` and `bytes` must be multiples of the filing system's block size, and the range must
+end before the end of the file.
+
+\param self The object whose member function to call.
+\param offset The offset of the range to remove.
+\param bytes The number of bytes to remove.
+\errors Any of the values POSIX fallocate() can return, `errc::operation_not_supported` on
+platforms and filing systems without support.
+\mallocs None.
+*/
+inline result<void> collapse_range(file_handle &self, file_handle::extent_type offset, file_handle::extent_type bytes) noexcept
+{
+  return self.collapse_range(std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes));
+}
+/*! \brief Inserts a hole into the file, shifting the data after it up and increasing the
+maximum extent of the file by the bytes inserted.
+
+This is `fallocate(FALLOC_FL_INSERT_RANGE)` on Linux, where it is performed by remapping
+extents rather than copying data. `offset` and `bytes` must be multiples of the filing
+system's block size, and `offset` must be before the end of the file.
+
+\param self The object whose member function to call.
+\param offset The offset at which to insert.
+\param bytes The number of bytes to insert.
+\errors Any of the values POSIX fallocate() can return, `errc::operation_not_supported` on
+platforms and filing systems without support.
+\mallocs None.
+*/
+inline result<void> insert_range(file_handle &self, file_handle::extent_type offset, file_handle::extent_type bytes) noexcept
+{
+  return self.insert_range(std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes));
+}
+/*! \brief Ask the system to begin to asynchronously read the extents of the file given into
+the kernel cache, returning the extents actually prefetched.
+
+This is `posix_fadvise(POSIX_FADV_WILLNEED)` on POSIX, and `fcntl(F_RDADVISE)` on Mac OS.
+Windows has no equivalent for files, so you will see an empty span returned. See also
+`flag::maximum_prefetching` for advising the whole file at open.
+
+\param self The object whose member function to call.
+\param extents The offset and length of each extent to prefetch. Passing `extents()`
+prefetches the whole of the allocated file.
+\errors Any of the values POSIX posix_fadvise() can return.
+\mallocs None.
+*/
+inline result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> prefetch(file_handle &self, span<std::pair<file_handle::extent_type, file_handle::extent_type>> extents) noexcept
+{
+  return self.prefetch(std::forward<decltype(extents)>(extents));
+}
+/*! \brief Ask the system to drop the extents of the file given from the kernel cache,
+returning the extents actually evicted.
+
+This is `posix_fadvise(POSIX_FADV_DONTNEED)` on POSIX. Dirty pages are not evicted,
+so issue a `barrier()` first if those are wanted gone too. Mac OS and Windows have no
+equivalent, so you will see an empty span returned. See also `flag::drop_behind` for
+evicting pages automatically as they are read.
+
+\param self The object whose member function to call.
+\param extents The offset and length of each extent to evict.
+\errors Any of the values POSIX posix_fadvise() can return.
+\mallocs None.
+*/
+inline result<span<std::pair<file_handle::extent_type, file_handle::extent_type>>> evict(file_handle &self, span<std::pair<file_handle::extent_type, file_handle::extent_type>> extents) noexcept
+{
+  return self.evict(std::forward<decltype(extents)>(extents));
+}
+/*! \brief Copies a range of this file into another file without passing it through userspace
+where possible, preserving holes.
+
+On Linux this firstly tries to reflink the range with `FICLONERANGE`, which shares the
+source's storage copy on write and so completes in constant time. This requires the offsets
+to be aligned to the filing system's block size, and both files to be on the same filing
+system. Failing that, each valid extent of the source (see `extents()`) is copied by the
+kernel with `copy_file_range()`, and failing that by reads and writes through page aligned
+buffers. Holes in the source become holes in the destination, and the destination is
+extended if it is too short. On other platforms only the read and write loop is available.
+
+\return The bytes of the source range cloned, which is less than requested if the range
+extends past the end of the source.
+\param self The object whose member function to call.
+\param dest The file to copy into. Must not be this file if the ranges overlap.
+\param offset The offset within this file to copy from.
+\param bytes The number of bytes to copy.
+\param dest_offset The offset within the destination to copy to.
+\errors `errc::value_too_large` if a range wraps, `errc::invalid_argument` if the ranges
+overlap within the same file, any of the values `read()`, `write()`, `truncate()`, `zero()`
+and `extents()` can return.
+\mallocs One page allocation of `utils::file_buffer_default_size()` if the read and write
+loop is used, plus the vector returned by `extents()`.
+*/
+inline result<file_handle::extent_type> clone_extents_to(file_handle &self, file_handle &dest, file_handle::extent_type offset, file_handle::extent_type bytes, file_handle::extent_type dest_offset) noexcept
+{
+  return self.clone_extents_to(std::forward<decltype(dest)>(dest), std::forward<decltype(offset)>(offset), std::forward<decltype(bytes)>(bytes), std::forward<decltype(dest_offset)>(dest_offset));
+}
 // END make_free_functions.py
 
 LLFIO_V2_NAMESPACE_END
@@ -449,6 +784,7 @@ LLFIO_V2_NAMESPACE_END
 #else
 #include "detail/impl/posix/file_handle.ipp"
 #endif
+#include "detail/impl/file_handle.ipp"
 #undef LLFIO_INCLUDED_BY_HEADER
 #endif
 
@@ -143,6 +143,12 @@ public:
     into kernel cache. This can improve sequential i/o performance.
     */
     maximum_prefetching = 1U << 5U,
+    /*! Ask the OS to drop the pages of the file from the kernel cache once they have been
+    read through this handle, so a streaming read of a large file does not evict the cached
+    data of everything else. Only clean pages are dropped, and only by `read()`. Currently
+    only implemented on POSIX platforms with `posix_fadvise()`.
+    */
+    drop_behind = 1U << 6U,
 
     win_disable_unlink_emulation = 1U << 24U,  //!< See the documentation for `unlink_on_first_close`
     /*! Microsoft Windows NTFS, having been created in the late 1980s, did not originally
@@ -385,6 +391,10 @@ inline std::ostream &operator<<(std::ostream &s, const handle::flag &v)
   {
     temp.append("maximum_prefetching|");
   }
+  if(!!(v & handle::flag::drop_behind))
+  {
+    temp.append("drop_behind|");
+  }
   if(!!(v & handle::flag::win_disable_unlink_emulation))
   {
     temp.append("win_disable_unlink_emulation|");
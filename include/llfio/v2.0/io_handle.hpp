@@ -174,15 +174,35 @@ public:
   // static_assert(std::is_trivially_move_assignable<buffers_type>::value, "buffers_type is not trivially move assignable!");
   static_assert(std::is_standard_layout<buffers_type>::value, "buffers_type is not a standard layout type!");
 #endif
+  /*! \brief The priority class of an i/o request.
+
+  On Linux this maps onto the i/o scheduling classes of `ioprio_set()`, which the kernel's
+  block layer i/o schedulers may honour. Elsewhere on POSIX only `background` has an effect,
+  which is to lower the `aio_reqprio` of asynchronous i/o. For synchronous i/o on Linux, the
+  calling thread's i/o priority is changed for the duration of the i/o, which costs three
+  extra syscalls per i/o whose priority is not `normal`.
+
+  `io_service` additionally holds back asynchronous `background` reads and writes to a
+  configurable queue depth while any other i/o is in flight, see
+  `io_service::set_background_queue_depth()`.
+  */
+  enum class io_priority : unsigned char
+  {
+    normal = 0,  //!< The priority of the calling thread or process.
+    high,        //!< The best effort class at its highest level.
+    background   //!< The idle class, serviced only when there is no other i/o to the device.
+  };
   //! The i/o request type used by this handle. Guaranteed to be `TrivialType` apart from construction, and `StandardLayoutType`.
   template <class T> struct io_request
   {
     T buffers{};
     extent_type offset{0};
+    io_priority priority{io_priority::normal};
     constexpr io_request() {}  // NOLINT (defaulting this breaks clang and GCC, so don't do it!)
-    constexpr io_request(T _buffers, extent_type _offset)
+    constexpr io_request(T _buffers, extent_type _offset, io_priority _priority = io_priority::normal)
         : buffers(std::move(_buffers))
         , offset(_offset)
+        , priority(_priority)
     {
     }
   };
@@ -304,10 +324,16 @@ public:
   \param reqs A scatter-gather and offset request.
   \param d An optional deadline by which the i/o must complete, else it is cancelled.
   Note function may return significantly after this deadline if the i/o takes long to cancel.
+  If the deadline expires after some of the i/o has completed, the buffers transferred so far
+  are returned rather than an error. On POSIX, deadline i/o is bounced through an internal
+  buffer of at most `utils::file_buffer_default_size()`, a chunk at a time, so that reads which
+  cannot be cancelled, e.g. stuck on a slow NFS server, can be left to finish on a reaper thread.
+  Only if the reaper thread cannot be started does the call wait for the i/o, however long it
+  takes.
   \errors Any of the values POSIX read() can return, `errc::timed_out`, `errc::operation_canceled`. `errc::not_supported` may be
   returned if deadline i/o is not possible with this particular handle configuration (e.g.
-  reading from regular files on POSIX or reading from a non-overlapped HANDLE on Windows).
-  \mallocs The default synchronous implementation in file_handle performs no memory allocation.
+  reading from a non-overlapped HANDLE on Windows).
+  \mallocs The default synchronous implementation in file_handle performs no memory allocation, except deadline i/o on POSIX which allocates its aiocbs and a bounded internal buffer.
   The asynchronous implementation in async_file_handle performs one calloc and one free.
   */
   LLFIO_MAKE_FREE_FUNCTION
@@ -327,10 +353,15 @@ public:
   \param reqs A scatter-gather and offset request.
   \param d An optional deadline by which the i/o must complete, else it is cancelled.
   Note function may return significantly after this deadline if the i/o takes long to cancel.
+  If the deadline expires after some of the i/o has completed, the buffers transferred so far
+  are returned rather than an error. On POSIX, deadline i/o is bounced through an internal
+  buffer of at most `utils::file_buffer_default_size()`, a chunk at a time. Writes which cannot
+  be cancelled, e.g. stuck on a slow NFS server, are waited for however long they take, so
+  no write reaches the file after the call returns.
   \errors Any of the values POSIX write() can return, `errc::timed_out`, `errc::operation_canceled`. `errc::not_supported` may be
   returned if deadline i/o is not possible with this particular handle configuration (e.g.
-  writing to regular files on POSIX or writing to a non-overlapped HANDLE on Windows).
-  \mallocs The default synchronous implementation in file_handle performs no memory allocation.
+  writing to a non-overlapped HANDLE on Windows).
+  \mallocs The default synchronous implementation in file_handle performs no memory allocation, except deadline i/o on POSIX which allocates its aiocbs and a bounded internal buffer.
   The asynchronous implementation in async_file_handle performs one calloc and one free.
   */
   LLFIO_MAKE_FREE_FUNCTION
@@ -350,6 +381,42 @@ public:
     return std::move(ret).error();
   }
 
+  /*! \brief Read data from the open handle, completing the whole request.
+
+  Unlike `read()`, any number of buffers may be supplied. They are issued in batches of at most
+  `max_buffers()`, and short reads are continued from where they stopped, until either every
+  buffer has been filled or the end of the file is reached.
+
+  \return The buffers read, which are the buffers input, except that the buffers after the end
+  of the file are dropped and the buffer containing the end of the file is trimmed. As for
+  `read()`, the pointer to the data may be different to what was submitted.
+  \param reqs A scatter-gather and offset request.
+  \param d An optional deadline by which the whole request must complete, else it is cancelled.
+  If the deadline expires after some of the i/o has completed, the buffers transferred so far
+  are returned rather than an error.
+  \errors As for `read()`.
+  \mallocs As for `read()`, per batch.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  io_result<buffers_type> read_all(io_request<buffers_type> reqs, deadline d = deadline()) noexcept;
+
+  /*! \brief Write data to the open handle, completing the whole request.
+
+  Unlike `write()`, any number of buffers may be supplied. They are issued in batches of at most
+  `max_buffers()`, and short writes are continued from where they stopped, until every buffer
+  has been written.
+
+  \return The buffers written, which are the buffers input unless the deadline expired.
+  \param reqs A scatter-gather and offset request.
+  \param d An optional deadline by which the whole request must complete, else it is cancelled.
+  If the deadline expires after some of the i/o has completed, the buffers transferred so far
+  are returned rather than an error.
+  \errors As for `write()`, and `errc::io_error` if the handle accepts no more bytes.
+  \mallocs As for `write()`, per batch.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  io_result<const_buffers_type> write_all(io_request<const_buffers_type> reqs, deadline d = deadline()) noexcept;
+
   /*! \brief Issue a write reordering barrier such that writes preceding the barrier will reach storage
   before writes after this barrier.
 
@@ -537,6 +604,108 @@ public:
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC void unlock(extent_type offset, extent_type bytes) noexcept;
 };
 
+namespace detail
+{
+  /* Issues reqs in batches of at most maxbuffers through op, continuing short transfers, until
+  every buffer has been transferred, or a read transfers nothing, being the end of the file. A
+  write transferring nothing fails with errc::io_error. The buffers input are only ever
+  modified to redirect them, or to trim the last buffer to what was transferred.
+  */
+  template <class BuffersType, class Op> inline io_handle::io_result<BuffersType> complete_io(io_handle::io_request<BuffersType> reqs, size_t maxbuffers, deadline d, Op &&op) noexcept
+  {
+    using buffer_type = std::decay_t<decltype(*reqs.buffers.data())>;
+    if(d && d.steady && d.nsecs > 0)
+    {
+      // Each batch must not be given the whole of the deadline
+      d = deadline(std::chrono::system_clock::now() + std::chrono::nanoseconds(d.nsecs));
+    }
+    if(maxbuffers == 0)
+    {
+      maxbuffers = 1;
+    }
+    auto *batch = reinterpret_cast<buffer_type *>(alloca(sizeof(buffer_type) * (std::min)(maxbuffers, reqs.buffers.size() + 1)));
+    size_t idx = 0;   // the first buffer not yet completely transferred
+    size_t done = 0;  // the bytes of that buffer already transferred
+    io_handle::extent_type offset = reqs.offset;
+    for(;;)
+    {
+      while(idx < reqs.buffers.size() && reqs.buffers[idx].size() == done)
+      {
+        ++idx;
+        done = 0;
+      }
+      if(idx == reqs.buffers.size())
+      {
+        break;
+      }
+      size_t count = (std::min)(maxbuffers, reqs.buffers.size() - idx);
+      batch[0] = {reqs.buffers[idx].data() + done, reqs.buffers[idx].size() - done};
+      for(size_t n = 1; n < count; n++)
+      {
+        batch[n] = reqs.buffers[idx + n];
+      }
+      auto r = op(io_handle::io_request<BuffersType>({batch, count}, offset, reqs.priority), d);
+      if(!r)
+      {
+        if((idx > 0 || done > 0) && r.error() == errc::timed_out)
+        {
+          break;
+        }
+        return std::move(r).error();
+      }
+      auto transferred = std::move(r).value();
+      size_t bytes = 0;
+      for(size_t n = 0; n < transferred.size(); n++)
+      {
+        auto &b = reqs.buffers[idx];
+        const size_t len = (std::min)(transferred[n].size(), b.size() - done);
+        // Some handles, such as mapped ones, redirect buffers rather than fill them
+        if(len > 0 && transferred[n].data() != b.data() + done)
+        {
+          b = {transferred[n].data() - done, b.size()};
+        }
+        bytes += len;
+        offset += len;
+        done += len;
+        if(done < b.size())
+        {
+          break;
+        }
+        ++idx;
+        done = 0;
+      }
+      if(bytes == 0)
+      {
+        // A write making no progress would otherwise be mistaken for success
+        if(std::is_const<std::remove_pointer_t<decltype(reqs.buffers.data()->data())>>::value)
+        {
+          return errc::io_error;
+        }
+        // End of file
+        break;
+      }
+    }
+    if(done > 0)
+    {
+      reqs.buffers[idx] = {reqs.buffers[idx].data(), done};
+      ++idx;
+    }
+    return {BuffersType(reqs.buffers.data(), idx)};
+  }
+}  // namespace detail
+
+inline io_handle::io_result<io_handle::buffers_type> io_handle::read_all(io_handle::io_request<io_handle::buffers_type> reqs, deadline d) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  return detail::complete_io(reqs, max_buffers(), d, [this](io_request<buffers_type> req, deadline _d) { return read(req, _d); });
+}
+
+inline io_handle::io_result<io_handle::const_buffers_type> io_handle::write_all(io_handle::io_request<io_handle::const_buffers_type> reqs, deadline d) noexcept
+{
+  LLFIO_LOG_FUNCTION_CALL(this);
+  return detail::complete_io(reqs, max_buffers(), d, [this](io_request<const_buffers_type> req, deadline _d) { return write(req, _d); });
+}
+
 
 // BEGIN make_free_functions.py
 /*! \brief Read data from the open handle.
@@ -553,10 +722,16 @@ memory map).
 \param reqs A scatter-gather and offset request.
 \param d An optional deadline by which the i/o must complete, else it is cancelled.
 Note function may return significantly after this deadline if the i/o takes long to cancel.
+If the deadline expires after some of the i/o has completed, the buffers transferred so far
+are returned rather than an error. On POSIX, deadline i/o is bounced through an internal
+buffer of at most `utils::file_buffer_default_size()`, a chunk at a time, so that reads which
+cannot be cancelled, e.g. stuck on a slow NFS server, can be left to finish on a reaper thread.
+Only if the reaper thread cannot be started does the call wait for the i/o, however long it
+takes.
 \errors Any of the values POSIX read() can return, `errc::timed_out`, `errc::operation_canceled`. `errc::not_supported` may be
 returned if deadline i/o is not possible with this particular handle configuration (e.g.
-reading from regular files on POSIX or reading from a non-overlapped HANDLE on Windows).
-\mallocs The default synchronous implementation in file_handle performs no memory allocation.
+reading from a non-overlapped HANDLE on Windows).
+\mallocs The default synchronous implementation in file_handle performs no memory allocation, except deadline i/o on POSIX which allocates its aiocbs and a bounded internal buffer.
 The asynchronous implementation in async_file_handle performs one calloc and one free.
 */
 inline io_handle::io_result<io_handle::buffers_type> read(io_handle &self, io_handle::io_request<io_handle::buffers_type> reqs, deadline d = deadline()) noexcept
@@ -579,10 +754,15 @@ buffer is updated with the number of bytes of that buffer transferred.
 \param reqs A scatter-gather and offset request.
 \param d An optional deadline by which the i/o must complete, else it is cancelled.
 Note function may return significantly after this deadline if the i/o takes long to cancel.
+If the deadline expires after some of the i/o has completed, the buffers transferred so far
+are returned rather than an error. On POSIX, deadline i/o is bounced through an internal
+buffer of at most `utils::file_buffer_default_size()`, a chunk at a time. Writes which cannot
+be cancelled, e.g. stuck on a slow NFS server, are waited for however long they take, so
+no write reaches the file after the call returns.
 \errors Any of the values POSIX write() can return, `errc::timed_out`, `errc::operation_canceled`. `errc::not_supported` may be
 returned if deadline i/o is not possible with this particular handle configuration (e.g.
-writing to regular files on POSIX or writing to a non-overlapped HANDLE on Windows).
-\mallocs The default synchronous implementation in file_handle performs no memory allocation.
+writing to a non-overlapped HANDLE on Windows).
+\mallocs The default synchronous implementation in file_handle performs no memory allocation, except deadline i/o on POSIX which allocates its aiocbs and a bounded internal buffer.
 The asynchronous implementation in async_file_handle performs one calloc and one free.
 */
 inline io_handle::io_result<io_handle::const_buffers_type> write(io_handle &self, io_handle::io_request<io_handle::const_buffers_type> reqs, deadline d = deadline()) noexcept
@@ -594,6 +774,46 @@ inline io_handle::io_result<io_handle::size_type> write(io_handle &self, io_hand
 {
   return self.write(std::forward<decltype(offset)>(offset), std::forward<decltype(lst)>(lst), std::forward<decltype(d)>(d));
 }
+/*! \brief Read data from the open handle, completing the whole request.
+
+Unlike `read()`, any number of buffers may be supplied. They are issued in batches of at most
+`max_buffers()`, and short reads are continued from where they stopped, until either every
+buffer has been filled or the end of the file is reached.
+
+\return The buffers read, which are the buffers input, except that the buffers after the end
+of the file are dropped and the buffer containing the end of the file is trimmed. As for
+`read()`, the pointer to the data may be different to what was submitted.
+\param self The object whose member function to call.
+\param reqs A scatter-gather and offset request.
+\param d An optional deadline by which the whole request must complete, else it is cancelled.
+If the deadline expires after some of the i/o has completed, the buffers transferred so far
+are returned rather than an error.
+\errors As for `read()`.
+\mallocs As for `read()`, per batch.
+*/
+inline io_handle::io_result<io_handle::buffers_type> read_all(io_handle &self, io_handle::io_request<io_handle::buffers_type> reqs, deadline d = deadline()) noexcept
+{
+  return self.read_all(std::forward<decltype(reqs)>(reqs), std::forward<decltype(d)>(d));
+}
+/*! \brief Write data to the open handle, completing the whole request.
+
+Unlike `write()`, any number of buffers may be supplied. They are issued in batches of at most
+`max_buffers()`, and short writes are continued from where they stopped, until every buffer
+has been written.
+
+\return The buffers written, which are the buffers input unless the deadline expired.
+\param self The object whose member function to call.
+\param reqs A scatter-gather and offset request.
+\param d An optional deadline by which the whole request must complete, else it is cancelled.
+If the deadline expires after some of the i/o has completed, the buffers transferred so far
+are returned rather than an error.
+\errors As for `write()`, and `errc::io_error` if the handle accepts no more bytes.
+\mallocs As for `write()`, per batch.
+*/
+inline io_handle::io_result<io_handle::const_buffers_type> write_all(io_handle &self, io_handle::io_request<io_handle::const_buffers_type> reqs, deadline d = deadline()) noexcept
+{
+  return self.write_all(std::forward<decltype(reqs)>(reqs), std::forward<decltype(d)>(d));
+}
 /*! \brief Issue a write reordering barrier such that writes preceding the barrier will reach storage
 before writes after this barrier.
 
@@ -28,8 +28,12 @@ Distributed under the Boost Software License, Version 1.0.
 #include "handle.hpp"
 
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #if defined(__cpp_coroutines) && !defined(LLFIO_HAVE_COROUTINES)
 #define LLFIO_HAVE_COROUTINES 1
@@ -106,6 +110,41 @@ Run as root 'kldload aio' or add 'aio_load=YES' in loader.conf.
 #endif
 struct aiocb;
 #endif
+// Linux io_uring is compiled in if the kernel headers know about it, but only used if asked for
+#if defined(__linux__) && !defined(LLFIO_USE_IO_URING)
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LLFIO_USE_IO_URING 1
+#endif
+#endif
+#endif
+#if !defined(LLFIO_USE_IO_URING)
+/*! \brief Undefined to autodetect, 1 to compile in Linux io_uring support, 0 to leave it out
+
+io_uring is only ever used if `io_service::engine::io_uring` is requested at construction.
+*/
+#define LLFIO_USE_IO_URING 0
+#endif
+#if LLFIO_USE_IO_URING && !LLFIO_USE_POSIX_AIO
+#error Linux io_uring support reuses the POSIX AIO control blocks, so POSIX AIO must be enabled!
+#endif
+// Linux eventfd is used in preference to signals to wake an io_uring run_until() for post()
+#if defined(__linux__) && LLFIO_USE_IO_URING && !defined(LLFIO_USE_EVENTFD)
+#if defined(__has_include)
+#if __has_include(<sys/eventfd.h>)
+#define LLFIO_USE_EVENTFD 1
+#endif
+#endif
+#endif
+#if !defined(LLFIO_USE_EVENTFD)
+/*! \brief Undefined to autodetect, 1 to compile in waking an io_uring `run_until()` for `post()` via a
+Linux eventfd instead of `LLFIO_IO_POST_SIGNAL`, 0 to always use the signal
+*/
+#define LLFIO_USE_EVENTFD 0
+#endif
+#if LLFIO_USE_EVENTFD && !LLFIO_USE_IO_URING
+#error eventfd wakeup is implemented as an io_uring poll, so io_uring must be enabled!
+#endif
 #endif
 
 #ifdef _MSC_VER
@@ -124,26 +163,48 @@ class async_file_handle;
 This service is used in conjunction with `async_file_handle` to multiplex
 initating i/o and completing it onto a single kernel thread.
 Unlike the `io_service` in ASIO or the Networking TS, this `io_service`
-is much simpler, in particular it is single threaded per instance only
-i.e. you must run a separate `io_service` instance one per kernel thread
-if you wish to run i/o processing across multiple threads. LLFIO does not
-do this for you (and for good reason, unlike socket i/o, it is generally
-unwise to distribute file i/o across kernel threads due to the much
-more code executable between user space and physical storage i.e. keeping
-processing per CPU core hot in cache delivers outsize benefits compared
-to socket i/o).
+is much simpler, in particular all i/o is initiated and reaped by the one
+kernel thread which owns each instance i.e. you must run a separate `io_service`
+instance one per kernel thread if you wish to initiate i/o across multiple
+threads. LLFIO does not distribute initiation for you (and for good reason,
+unlike socket i/o, it is generally unwise to distribute file i/o across kernel
+threads due to the much more code executable between user space and physical
+storage i.e. keeping processing per CPU core hot in cache delivers outsize
+benefits compared to socket i/o). Only the execution of completion handlers
+can be distributed, see `set_completion_threads()` below.
 
 Furthermore, you cannot use this i/o service in any way from any
 thread other than where it was created. You cannot call its `run()`
 from any thread other than where it was created. And you cannot
 initiate i/o on an `async_file_handle` from any thread other than where
-its owning i/o service was created.
+its owning i/o service was created, including from completion handlers
+running on the completion pool.
 
 In other words, keep your i/o service and all associated file handles
 on their owning thread. The sole function you can call from another
 thread is `post()` which lets you execute some callback in the `run()`
-of the owning thread. This lets you schedule i/o from other threads
-if you really must do that.
+of the owning thread. This lets you schedule i/o from other threads,
+including from completion pool threads, if you really must do that.
+
+On POSIX, `post()` wakes the owning thread if it is sleeping within `run()`
+by sending it `LLFIO_IO_POST_SIGNAL`. On Linux, if `LLFIO_USE_EVENTFD` is 1,
+an i/o service using `engine::io_uring` instead keeps a poll of an eventfd queued
+alongside its i/o, which `post()` completes by writing to the eventfd. This avoids
+both the cost of signal delivery and masking the signal on every `run()`, and any need
+to install a process wide signal handler. Call `disable_eventfd_wakeup()` to use the
+signal instead. POSIX AIO always uses the signal, as glibc would implement a read of
+the eventfd by parking one of its few AIO helper threads in `read()` until woken.
+
+On Linux, if `LLFIO_USE_IO_URING` is 1, you can construct the i/o service with
+`engine::io_uring` to use io_uring instead of POSIX AIO. Each buffer in a scatter-gather
+request becomes one submission queue entry, all entries queued by `async_read()` etc.
+are submitted to the kernel in a single syscall by the next `run_until()`, which then
+reaps completions directly from the completion queue ring.
+
+On POSIX, if completion handlers do substantial work, you can have them executed by
+a pool of kernel threads using `set_completion_threads()`. The owning thread still
+initiates and reaps all i/o, but instead of invoking completion handlers inline, it
+deals them out to per-thread deques from which idle pool threads steal work.
 
 \snippet coroutines.cpp coroutines_example
 */
@@ -164,6 +225,8 @@ public:
   using buffers_type = io_handle::buffers_type;
   //! The gather buffers type used by this i/o service
   using const_buffers_type = io_handle::const_buffers_type;
+  //! The i/o priority class used by this i/o service
+  using io_priority = io_handle::io_priority;
   //! The i/o request type used by this i/o service
   template <class T> using io_request = io_handle::io_request<T>;
   //! The i/o result type used by this i/o service
@@ -190,6 +253,32 @@ private:
   std::deque<post_info> _posts;
   using shared_size_type = std::atomic<size_type>;
   shared_size_type _work_queued;
+  struct _io_state_cache_type
+  {
+    // Size classes for i/o states of up to 1, 2, 4, 8 and 16 buffers
+    static constexpr size_t buckets = 5;
+    // Completion handlers larger than this are not cached
+    static constexpr size_t completion_bytes = 256;
+    // Freed i/o states beyond this many per size class are returned to the heap
+    static constexpr size_t max_free = 256;
+    std::mutex lock;
+    size_t slot_bytes[buckets]{};
+    std::vector<void *> free[buckets];
+    shared_size_type mallocs{0}, recycles{0};
+    _io_state_cache_type() = default;
+    _io_state_cache_type(const _io_state_cache_type &) = delete;
+    _io_state_cache_type &operator=(const _io_state_cache_type &) = delete;
+    ~_io_state_cache_type()
+    {
+      for(auto &i : free)
+      {
+        for(void *p : i)
+        {
+          ::free(p);  // NOLINT
+        }
+      }
+    }
+  } _io_state_cache;
 #if LLFIO_USE_POSIX_AIO
   bool _use_kqueues;
 #if LLFIO_COMPILE_KQUEUES
@@ -197,6 +286,90 @@ private:
 #endif
   std::vector<struct aiocb *> _aiocbsv;  // for fast aio_suspend()
 #endif
+#if LLFIO_USE_IO_URING
+  bool _use_io_uring{false};
+  struct _io_uring_type
+  {
+    int fd{-1};
+    unsigned entries{0};
+    void *sq_ptr{nullptr}, *cq_ptr{nullptr}, *sqes{nullptr}, *cqes{nullptr};
+    size_t sq_len{0}, cq_len{0}, sqes_len{0};
+    unsigned *sq_head{nullptr}, *sq_tail{nullptr}, *sq_mask{nullptr}, *sq_array{nullptr};
+    unsigned *sq_flags{nullptr};
+    unsigned *cq_head{nullptr}, *cq_tail{nullptr}, *cq_mask{nullptr};
+    unsigned setup_flags{0};                   // IORING_SETUP_* the ring was created with
+    unsigned sqe_tail{0};                      // SQ tail including SQEs obtained but not yet published by _io_uring_commit()
+    unsigned to_submit{0};                     // SQEs published to the ring but not yet passed to io_uring_enter()
+    unsigned long long timeout_generation{0};  // distinguishes the current run_until() timeout from stale ones
+    unsigned long long timeout_armed{0};       // user_data of a run_until() timeout which may still be in the kernel, zero if none
+    long long timeout_ts[2]{0, 0};             // struct __kernel_timespec
+  } _uring;
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _io_uring_setup(unsigned entries, unsigned setup_flags);
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _io_uring_teardown() noexcept;
+  // Passes all SQEs queued so far to the kernel without waiting for any to complete
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> _io_uring_submit() noexcept;
+  // Ensure that n SQEs can be obtained, submitting already queued SQEs to the kernel if necessary
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> _io_uring_reserve(unsigned n) noexcept;
+  // Returns a zeroed struct io_uring_sqe * which the kernel cannot see until _io_uring_commit(). Call _io_uring_reserve() first.
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void *_io_uring_get_sqe() noexcept;
+  // Publishes all SQEs obtained so far to the ring, each of which must be completely filled in
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _io_uring_commit() noexcept;
+  // True if the io_uring polls the device for completions, which only direct reads and writes support
+  bool _io_uring_iopoll() const noexcept { return _use_io_uring && (_uring.setup_flags & 2U /*IORING_SETUP_IOPOLL*/) != 0; }
+#endif
+  size_t _batching{0};  // number of batch objects open
+#if LLFIO_USE_POSIX_AIO
+  std::vector<struct aiocb *> _batched_aiocbs;  // read and write aiocbs awaiting the batch's lio_listio()
+#endif
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> _submit_batched() noexcept;
+#if LLFIO_USE_POSIX_AIO
+  struct _completion_pool_type;  // defined in detail/impl/posix/io_service.ipp
+  std::unique_ptr<_completion_pool_type> _completion_pool;
+  // Wakes the owning thread if it is sleeping within run_until()
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _interrupt_run() noexcept;
+  // Retires completions executed by the pool, returning true if any were retired
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC bool _retire_pooled_completions() noexcept;
+#endif
+#if LLFIO_USE_POSIX_AIO
+  std::chrono::nanoseconds _busy_poll_period{0};
+  struct _busy_poll_stats_type
+  {
+    size_type spins{0}, spin_hits{0}, sleeps{0};
+    std::chrono::nanoseconds spinning{0}, sleeping{0};
+  } _busy_poll_stats;
+  // The two level queue holding back background reads and writes while other i/o is in flight
+  size_t _background_queue_depth{0};  // zero means background i/o is never held back
+  size_t _io_in_flight[2]{0, 0};      // i/o items issued to the system, foreground then background
+  struct _deferred_io_type
+  {
+    struct aiocb *aiocb;
+    const void *iov;  // the struct iovec for an io_uring readv or writev
+  };
+  std::deque<_deferred_io_type> _deferred_background;
+  // True if background i/o of this many items must be held back
+  bool _must_defer(io_priority priority, size_t items) const noexcept
+  {
+    if(priority != io_priority::background || _background_queue_depth == 0)
+    {
+      return false;
+    }
+    // Preserve the order of issue of background i/o
+    return !_deferred_background.empty() || (_io_in_flight[0] > 0 && _io_in_flight[1] + items > _background_queue_depth);
+  }
+  void _io_issued(io_priority priority, size_t items) noexcept { _io_in_flight[priority == io_priority::background] += items; }
+  void _io_retired(io_priority priority) noexcept { --_io_in_flight[priority == io_priority::background]; }
+  // Issues held back background i/o for as long as the queue depth permits
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> _submit_deferred() noexcept;
+#endif
+#if LLFIO_USE_EVENTFD
+  int _wakeup_fd{-1};                     // if not -1, _interrupt_run() writes to this eventfd instead of signalling
+  bool _wakeup_armed{false};              // a poll of _wakeup_fd is queued to io_uring
+  unsigned long long _wakeup_value{0};    // receives the eventfd counter
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _wakeup_setup() noexcept;
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void _wakeup_teardown() noexcept;
+  // Queues the poll of _wakeup_fd if it is not already queued
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> _wakeup_arm() noexcept;
+#endif
 public:
   // LOCK MUST BE HELD ON ENTRY!
   void __post_done(post_info *pi)
@@ -228,13 +401,108 @@ public:
     std::lock_guard<decltype(_posts_lock)> g(_posts_lock);
     return __post_done(pi);
   }
+  // Returns the i/o state cache size class for this many buffers, or -1 if too many to cache
+  static int _io_state_bucket(size_t items) noexcept
+  {
+    for(int bucket = 0; bucket < static_cast<int>(_io_state_cache_type::buckets); bucket++)
+    {
+      if(items <= (static_cast<size_t>(1) << bucket))
+      {
+        return bucket;
+      }
+    }
+    return -1;
+  }
+  // Returns all bits zero storage for an i/o state, recycled from the cache if possible. Sets bucket to -1 if the storage must be free()d.
+  void *_allocate_io_state(int &bucket, size_t bytes) noexcept
+  {
+    if(bucket >= 0)
+    {
+      void *ret = nullptr;
+      {
+        std::lock_guard<decltype(_io_state_cache.lock)> g(_io_state_cache.lock);
+        size_t &slot_bytes = _io_state_cache.slot_bytes[bucket];
+        if(slot_bytes == 0)
+        {
+          slot_bytes = bytes;
+        }
+        if(bytes != slot_bytes)
+        {
+          bucket = -1;
+        }
+        else if(!_io_state_cache.free[bucket].empty())
+        {
+          ret = _io_state_cache.free[bucket].back();
+          _io_state_cache.free[bucket].pop_back();
+        }
+      }
+      if(ret != nullptr)
+      {
+        ++_io_state_cache.recycles;
+        memset(ret, 0, bytes);
+        return ret;
+      }
+    }
+    ++_io_state_cache.mallocs;
+    return ::calloc(1, bytes);  // NOLINT
+  }
+  // Returns storage from _allocate_io_state() to the cache
+  void _deallocate_io_state(void *p, int bucket) noexcept
+  {
+    if(bucket >= 0)
+    {
+      std::lock_guard<decltype(_io_state_cache.lock)> g(_io_state_cache.lock);
+      auto &free = _io_state_cache.free[bucket];
+      if(free.size() < _io_state_cache_type::max_free)
+      {
+        try
+        {
+          free.push_back(p);
+          return;
+        }
+        catch(...)
+        {
+        }
+      }
+    }
+    ::free(p);  // NOLINT
+  }
   void _work_enqueued(size_type i = 1) { _work_queued += i; }
   void _work_done() { --_work_queued; }
   /*! Creates an i/o service for the calling thread, installing a
   global signal handler via set_interruption_signal() if not yet installed
-  if on POSIX and BSD kqueues not in use.
+  if on POSIX and BSD kqueues are not in use.
   */
   LLFIO_HEADERS_ONLY_MEMFUNC_SPEC io_service();
+#if LLFIO_USE_POSIX_AIO
+  //! The kernel facility used by an i/o service to multiplex i/o
+  enum class engine
+  {
+    posix_aio,  //!< POSIX AIO. The default.
+    io_uring    //!< Linux io_uring. Only available if `LLFIO_USE_IO_URING` is 1.
+  };
+  //! Polling modes for an io_uring, which trade CPU for lower i/o latency
+  QUICKCPPLIB_BITFIELD_BEGIN(io_uring_flag){none = 0U,          //!< Submission and completion are interrupt driven
+                                            sqpoll = 1U << 0U,  //!< A kernel thread polls the submission queue, so submitting i/o needs no syscall. Needs CAP_SYS_ADMIN before Linux 5.11.
+                                            iopoll = 1U << 1U   //!< Completions are busy polled from the device. Only works with `caching::only_metadata` (O_DIRECT) handles, and only reads and writes are supported.
+  };
+  QUICKCPPLIB_BITFIELD_END(io_uring_flag);
+  /*! Creates an i/o service for the calling thread using the kernel engine
+  specified. `queue_depth` is the number of submission queue entries to allocate
+  when using io_uring, and is ignored by POSIX AIO, as is `flags`.
+
+  An io_uring created with `io_uring_flag::iopoll` never sleeps in `run_until()`, rather
+  it polls for completions, posts and the deadline until something happens. Such an io_uring
+  only accepts direct reads and writes, so `async_barrier()` and `async_write_and_barrier()`
+  fail with `errc::operation_not_supported`, and `cancel()` on its i/o does nothing, as the
+  kernel refuses fsyncs, cancellations, timeouts and polls on it.
+
+  Throws `std::runtime_error` if io_uring was requested but was not compiled in,
+  and `std::system_error` if the kernel refuses to create an io_uring (e.g. it is too
+  old, io_uring has been disabled by policy, or the polling mode requires privileges).
+  */
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC explicit io_service(engine e, unsigned queue_depth = 256, io_uring_flag flags = io_uring_flag::none);
+#endif
   io_service(io_service &&) = delete;
   io_service(const io_service &) = delete;
   io_service &operator=(io_service &&) = delete;
@@ -271,6 +539,104 @@ public:
   bool using_kqueues() const noexcept { return _use_kqueues; }
   //! Force disable any use of BSD kqueues
   LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void disable_kqueues();
+  //! The kernel engine this i/o service is using
+  engine kernel_engine() const noexcept
+  {
+#if LLFIO_USE_IO_URING
+    return _use_io_uring ? engine::io_uring : engine::posix_aio;
+#else
+    return engine::posix_aio;
+#endif
+  }
+  //! True if this i/o service is using Linux io_uring
+  bool using_io_uring() const noexcept { return kernel_engine() == engine::io_uring; }
+  //! True if this i/o service wakes `run_until()` for `post()` using a Linux eventfd rather than a signal. Only ever true for io_uring.
+  bool using_eventfd_wakeup() const noexcept
+  {
+#if LLFIO_USE_EVENTFD
+    return _wakeup_fd != -1;
+#else
+    return false;
+#endif
+  }
+  //! Force disable any use of a Linux eventfd to wake `run_until()` for `post()`, using `LLFIO_IO_POST_SIGNAL` instead
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void disable_eventfd_wakeup();
+
+  /*! \brief Sets the number of kernel threads used to execute completion handlers, zero
+  meaning completion handlers are executed inline by `run_until()` (the default).
+
+  When non-zero, `run_until()` on the owning thread still initiates and reaps all i/o,
+  but the completion handlers of `async_read()`, `async_write()` and `async_barrier()`
+  are queued to per-thread deques and executed by the pool, with idle pool threads
+  stealing work from busy ones. `run_until()` returns as usual when completions have been
+  handed to the pool or pool threads have finished executing them, so the owning thread
+  can continue to pump i/o in the usual way.
+
+  Completion handlers executed by the pool cannot initiate i/o directly, as only the
+  owning thread may do that, and `async_read()` etc. called from a pool thread fail with
+  `errc::operation_not_supported`. Use `post()` to have the owning thread do so. The synchronous
+  `read()`, `write()` and `barrier()` of `async_file_handle` always complete inline.
+
+  \errors `errc::operation_not_supported` if called from any thread other than the owning
+  thread, `errc::operation_in_progress` if any work is pending, any error from creating threads.
+  */
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<void> set_completion_threads(size_t threads) noexcept;
+  //! The number of kernel threads executing completion handlers, zero if they are executed inline.
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC size_t completion_threads() const noexcept;
+  // Queues the io_state for completion by the pool, returning false if there is no pool
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC bool _dispatch_completion(void *io_state) noexcept;
+
+  /*! \brief Sets for how long `run_until()` spins polling for i/o completions and posts
+  before it sleeps in the kernel, zero meaning never spin (the default).
+
+  Busy polling trades a CPU core for avoiding the latency of being woken by the kernel. With
+  POSIX AIO `aio_error()` is polled for each i/o outstanding, with io_uring the completion
+  queue ring is polled. Between polls the spin backs off exponentially up to a bound, so as
+  to not starve a sibling hyperthread. The spin is always cut short by the deadline passed to
+  `run_until()`. Use `busy_poll_stats()` to tune the period: if few spins end in a hit, the
+  period is too short to be worth it.
+  */
+  void set_busy_poll(std::chrono::nanoseconds period) noexcept { _busy_poll_period = period; }
+  //! The period for which `run_until()` spins before it sleeps, zero if it never spins.
+  std::chrono::nanoseconds busy_poll() const noexcept { return _busy_poll_period; }
+  //! Statistics about the busy polling by `run_until()` versus it sleeping in the kernel
+  struct busy_poll_statistics
+  {
+    size_type spins{0};                   //!< Number of times `run_until()` spun before sleeping
+    size_type spin_hits{0};               //!< Number of spins which found a completion or post, and so did not sleep
+    size_type sleeps{0};                  //!< Number of times `run_until()` slept in the kernel
+    std::chrono::nanoseconds spinning{0};  //!< Total time spent spinning
+    std::chrono::nanoseconds sleeping{0};  //!< Total time spent sleeping in the kernel
+  };
+  //! Returns statistics about busy polling. Must be called from the owning thread.
+  busy_poll_statistics busy_poll_stats() const noexcept
+  {
+    busy_poll_statistics ret;
+    ret.spins = _busy_poll_stats.spins;
+    ret.spin_hits = _busy_poll_stats.spin_hits;
+    ret.sleeps = _busy_poll_stats.sleeps;
+    ret.spinning = _busy_poll_stats.spinning;
+    ret.sleeping = _busy_poll_stats.sleeping;
+    return ret;
+  }
+  //! Resets the busy polling statistics to zero. Must be called from the owning thread.
+  void reset_busy_poll_stats() noexcept { _busy_poll_stats = _busy_poll_stats_type(); }
+
+  /*! \brief Sets how many `io_priority::background` reads and writes may be in flight whilst
+  any other i/o is in flight, zero meaning no limit (the default).
+
+  Background reads and writes beyond this depth are held in a first in first out queue
+  within the i/o service, and are issued by `run_until()` as the other i/o completes. This
+  stops bulk background i/o such as compaction from filling the device's queues ahead of
+  latency sensitive i/o, which kernel i/o priorities alone cannot do for devices with
+  deep internal queues. Barriers are never held back, so issue a background barrier only
+  after the background writes it is to cover have completed.
+  */
+  void set_background_queue_depth(size_t depth) noexcept { _background_queue_depth = depth; }
+  //! The most background i/o which may be in flight whilst other i/o is in flight, zero if unlimited.
+  size_t background_queue_depth() const noexcept { return _background_queue_depth; }
+  //! The number of background reads and writes currently being held back.
+  size_t background_queued() const noexcept { return _deferred_background.size(); }
 #endif
 
   /*! Runs the i/o service for the thread owning this i/o service. Returns true if more
@@ -282,6 +648,90 @@ public:
   //! \overload
   result<bool> run() noexcept { return run_until(deadline()); }
 
+  /*! \class batch
+  \brief Batches the initiation of i/o on any number of `async_file_handle`s using this
+  i/o service into as few syscalls as possible.
+
+  While a batch is open, reads and writes initiated by `async_read()` and `async_write()`
+  are queued rather than submitted to the kernel. `submit()`, or the destructor, then
+  submits them all at once, using as few `lio_listio()` as `AIO_LISTIO_MAX` permits for
+  POSIX AIO, or a single `io_uring_enter()` for io_uring. Each i/o still has its own
+  `io_state_ptr` and completion handler, and errors in submitting an individual i/o are
+  reported to its completion handler. Barriers are never batched. Batches may nest, in which
+  case only the outermost batch submits. Calling `run_until()` submits any batched i/o first.
+
+  On Windows i/o is always initiated immediately, so batches do nothing.
+
+  ~~~cpp
+  {
+    io_service::batch b(service);
+    for(auto &req : reqs)
+    {
+      states.push_back(req.handle->async_read(req.req, handler).value());
+    }
+    b.submit().value();
+  }
+  ~~~
+  */
+  class batch
+  {
+    io_service *_service;
+
+  public:
+    //! Opens a batch on the i/o service
+    explicit batch(io_service &service)
+        : _service(&service)
+    {
+      ++_service->_batching;
+    }
+    batch(batch &&) = delete;
+    batch(const batch &) = delete;
+    batch &operator=(batch &&) = delete;
+    batch &operator=(const batch &) = delete;
+    //! Submits the batch if it has not already been submitted
+    ~batch()
+    {
+      if(_service != nullptr)
+      {
+        (void) submit();
+      }
+    }
+    //! Closes the batch, submitting all i/o queued since it was opened if it is the outermost batch.
+    result<void> submit() noexcept
+    {
+      if(_service == nullptr)
+      {
+        return success();
+      }
+      io_service *service = _service;
+      _service = nullptr;
+      if(--service->_batching == 0)
+      {
+        return service->_submit_batched();
+      }
+      return success();
+    }
+  };
+
+  //! Statistics about the recycling of i/o state storage by this i/o service
+  struct io_state_cache_statistics
+  {
+    size_type mallocs{0};   //!< Number of i/o states allocated from the heap because none could be recycled
+    size_type recycles{0};  //!< Number of i/o states whose storage was recycled from the cache
+  };
+  /*! Returns statistics about the recycling of i/o state storage. When
+  no `mem` is passed to `async_read()`, `async_write()` or `async_barrier()`, i/o states of up
+  to 16 buffers are allocated from per-i/o service free lists of size classes
+  for 1, 2, 4, 8 and 16 buffers, so `mallocs` should cease to increase in steady state.
+  */
+  io_state_cache_statistics io_state_cache_stats() const noexcept
+  {
+    io_state_cache_statistics ret;
+    ret.mallocs = _io_state_cache.mallocs;
+    ret.recycles = _io_state_cache.recycles;
+    return ret;
+  }
+
 private:
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC void _post(detail::function_ptr<void(io_service *)> &&f);
 
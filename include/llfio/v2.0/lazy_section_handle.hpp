@@ -0,0 +1,164 @@
+/* A section whose pages are filled on first touch by a user supplied function
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef LLFIO_LAZY_SECTION_HANDLE_H
+#define LLFIO_LAZY_SECTION_HANDLE_H
+
+#include "map_handle.hpp"
+
+#include <memory>  // for unique_ptr
+
+//! \file lazy_section_handle.hpp Provides `lazy_section_handle`.
+
+LLFIO_V2_NAMESPACE_EXPORT_BEGIN
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251)  // subclass needs to have dll interface
+#endif
+
+namespace detail
+{
+  struct lazy_section_handle_state;
+  struct lazy_section_handle_state_deleter
+  {
+    LLFIO_HEADERS_ONLY_MEMFUNC_SPEC void operator()(lazy_section_handle_state *p) const noexcept;
+  };
+}  // namespace detail
+
+/*! \class lazy_section_handle
+\brief A memory section whose pages are filled on first touch by a user supplied function.
+
+The fill function is called with the offset into the section and a page aligned buffer of
+`fill_granularity()` bytes (less at the end of the section), and returns how many bytes
+at the front of the buffer it filled. Any remainder is zeroed, and returning zero maps in
+zero pages without copying. Typical uses are decompressing a block, fetching from
+some other tier of storage, or synthesising data, with the result being zero copy access to
+that data by any number of `map_handle`s of this section, which behave exactly like any
+other map.
+
+The fill function is called from a handler thread owned by this section, so it must
+not touch any map of this section. It is called at most once per block, and once filled,
+contents are kept in the section like those of any other anonymous section, so writes
+to the maps persist. If the fill function throws, the block is zero filled.
+
+This is implemented on Linux using a `userfaultfd` registered for every map of a section
+whose backing inode is created in `path_discovery::memory_backed_temporary_files_directory()`,
+and which must therefore be on `tmpfs`. Faults are resolved with `UFFDIO_COPY` and
+`UFFDIO_ZEROPAGE`. Where the kernel does not permit unprivileged `userfaultfd` for kernel
+mode faults, only user mode faults are handled, in which case passing unfilled memory
+from a map of this section to a syscall will fail with `EFAULT`.
+
+\warning Maps of this section must be closed before this section is closed, otherwise
+their unfilled pages read as zero. Maps keep pointing at the section they were made from, so
+after this section is moved, `map_handle::truncate()` of an existing map fails with
+`errc::bad_file_descriptor`, leaving the map as it was, as it could not register the
+moved range for filling. Reading this section by means other than a map, such as
+with `read()` on its native handle, does not fill pages.
+
+On other platforms, creating this section fails with `errc::operation_not_supported`.
+*/
+class LLFIO_DECL lazy_section_handle : public section_handle
+{
+public:
+  using extent_type = section_handle::extent_type;
+  using size_type = section_handle::size_type;
+  using buffer_type = map_handle::buffer_type;
+  //! The type of the fill function
+  using fill_function_type = detail::function_ptr<size_t(extent_type offset, buffer_type buffer)>;
+
+protected:
+  std::unique_ptr<detail::lazy_section_handle_state, detail::lazy_section_handle_state_deleter> _state;
+
+  explicit lazy_section_handle(section_handle &&sh) noexcept
+      : section_handle(std::move(sh))
+  {
+  }
+
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> _can_map() const noexcept override;
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> _on_map(byte *addr, size_t bytes, extent_type offset) noexcept override;
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC void _on_unmap(byte *addr, size_t bytes) noexcept override;
+  static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<lazy_section_handle> _lazy(extent_type bytes, fill_function_type &&fill, size_type granularity, flag _flag) noexcept;
+
+public:
+  //! Default constructor
+  lazy_section_handle() = default;
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~lazy_section_handle() override;
+  //! Implicit move construction of lazy_section_handle permitted
+  lazy_section_handle(lazy_section_handle &&o) noexcept = default;
+  //! No copy construction (use `clone()`)
+  lazy_section_handle(const lazy_section_handle &) = delete;
+  //! Move assignment of lazy_section_handle permitted
+  lazy_section_handle &operator=(lazy_section_handle &&o) noexcept
+  {
+    this->~lazy_section_handle();
+    new(this) lazy_section_handle(std::move(o));
+    return *this;
+  }
+  //! No copy assignment
+  lazy_section_handle &operator=(const lazy_section_handle &) = delete;
+
+  /*! \brief Create a memory section whose pages are filled on first touch by `fill`.
+  \param bytes The initial size of this section. Cannot be zero.
+  \param fill A callable with signature `size_t(extent_type offset, buffer_type buffer)`.
+  \param granularity The bytes to fill at a time, which is rounded up to a multiple of the
+  page size. Zero means the page size.
+  \param _flag How to create the section.
+
+  \errors Any of the values POSIX `userfaultfd()`, `open()` or `ioctl()` can return.
+  \mallocs One for the fill function, plus the buffer used to fill.
+  */
+  template <class F> static result<lazy_section_handle> lazy(extent_type bytes, F &&fill, size_type granularity = 0, flag _flag = flag::readwrite) noexcept
+  {
+    try
+    {
+      return _lazy(bytes, detail::make_function_ptr<size_t(extent_type, buffer_type)>(std::forward<F>(fill)), granularity, _flag);
+    }
+    catch(...)
+    {
+      return error_from_exception();
+    }
+  }
+
+  //! Closes the section, stopping its handler thread.
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> close() noexcept override;
+
+  //! The bytes filled at a time.
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC size_type fill_granularity() const noexcept;
+  //! The number of times the fill function has been called.
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC size_t fills() const noexcept;
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+LLFIO_V2_NAMESPACE_END
+
+#if LLFIO_HEADERS_ONLY == 1 && !defined(DOXYGEN_SHOULD_SKIP_THIS)
+#define LLFIO_INCLUDED_BY_HEADER 1
+#include "detail/impl/lazy_section_handle.ipp"
+#undef LLFIO_INCLUDED_BY_HEADER
+#endif
+
+#endif
@@ -69,6 +69,7 @@ import LLFIO_MODULE_NAME;
 #endif
 #include "directory_handle.hpp"
 #include "mapped.hpp"
+#include "lazy_section_handle.hpp"
 #include "statfs.hpp"
 #ifndef LLFIO_LEAN_AND_MEAN
 #include "storage_profile.hpp"
@@ -76,7 +77,11 @@ import LLFIO_MODULE_NAME;
 #include "fast_random_file_handle.hpp"
 #include "symlink_handle.hpp"
 
+#include "algorithm/copy_file.hpp"
+#include "algorithm/handle_adapter/adaptive_read.hpp"
+#include "algorithm/handle_adapter/bounce_buffering.hpp"
 #include "algorithm/handle_adapter/cached_parent.hpp"
+#include "algorithm/handle_adapter/writeback_pacing.hpp"
 #include "algorithm/handle_adapter/xor.hpp"
 #include "algorithm/shared_fs_mutex/atomic_append.hpp"
 #include "algorithm/shared_fs_mutex/byte_ranges.hpp"
@@ -84,5 +89,6 @@ import LLFIO_MODULE_NAME;
 #include "algorithm/shared_fs_mutex/memory_map.hpp"
 #include "algorithm/shared_fs_mutex/safe_byte_ranges.hpp"
 #include "algorithm/trivial_vector.hpp"
+#include "algorithm/virtual_ring_buffer.hpp"
 
 #endif
@@ -50,6 +50,8 @@ aforementioned file descriptor to an unnamed inode.
 */
 class LLFIO_DECL section_handle : public handle
 {
+  friend class map_handle;
+
 public:
   using extent_type = handle::extent_type;
   using size_type = handle::size_type;
@@ -65,6 +67,7 @@ public:
                                    prefault = 1U << 9U,     //!< Prefault, as if by reading every page, any views of memory upon creation.
                                    executable = 1U << 10U,  //!< The backing storage is in fact an executable program binary.
                                    singleton = 1U << 11U,   //!< A single instance of this section is to be shared by all processes using the same backing file.
+                                   transparent_huge_pages = 1U << 12U,  //!< Align views to the large page size, and ask the kernel to use transparent huge pages for them (Linux only).
 
                                    barrier_on_close = 1U << 16U,  //!< Maps of this section, if writable, issue a `barrier()` when destructed blocking until data (not metadata) reaches physical storage.
                                    nvram = 1U << 17U,             //!< This section is of non-volatile RAM
@@ -83,6 +86,13 @@ protected:
   file_handle _anonymous;
   flag _flag{flag::none};
 
+  // Called by map_handle before it maps, or remaps, a view of this section, so a failure leaves the view untouched
+  virtual result<void> _can_map() const noexcept { return success(); }
+  // Called by map_handle whenever it maps, or remaps, a view of this section
+  virtual result<void> _on_map(byte * /*unused*/, size_t /*unused*/, extent_type /*unused*/) noexcept { return success(); }
+  // Called by map_handle whenever it unmaps a view of this section, or remaps it elsewhere
+  virtual void _on_unmap(byte * /*unused*/, size_t /*unused*/) noexcept {}
+
 public:
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC ~section_handle() override;
   LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> close() noexcept override;
@@ -213,6 +223,10 @@ inline std::ostream &operator<<(std::ostream &s, const section_handle::flag &v)
   {
     temp.append("singleton|");
   }
+  if(!!(v & section_handle::flag::transparent_huge_pages))
+  {
+    temp.append("transparent_huge_pages|");
+  }
   if(!!(v & section_handle::flag::barrier_on_close))
   {
     temp.append("barrier_on_close|");
@@ -334,6 +348,12 @@ able to map files using large pages soon, and in theory LLFIO based should "just
 
 Note that many distributions enable transparent huge pages, whereby if you request allocations of large page multiples
 at large page offsets, the kernel uses large pages, without you needing to specify any `section_handle::flag::page_sizes_N`.
+`section_handle::flag::transparent_huge_pages` asks for exactly this for both anonymous and file backed maps, without needing
+any preconfigured pool of huge pages: views are placed at an address congruent with their offset modulo the large page size,
+anonymous memory is allocated in large page multiples, and `MADV_HUGEPAGE` is applied to the view. If
+`section_handle::flag::prefault` is also specified, `MADV_COLLAPSE` (Linux 6.1 onwards) is applied after prefaulting to
+synchronously collapse the view into huge pages. Whether large pages were actually used can be checked with
+`map_handle::page_usage()`.
 
 ### FreeBSD:
 
@@ -364,6 +384,7 @@ public:
   using const_buffer_type = io_handle::const_buffer_type;
   using buffers_type = io_handle::buffers_type;
   using const_buffers_type = io_handle::const_buffers_type;
+  using io_priority = io_handle::io_priority;
   template <class T> using io_request = io_handle::io_request<T>;
   template <class T> using io_result = io_handle::io_result<T>;
 
@@ -373,6 +394,7 @@ protected:
   extent_type _offset{0};
   size_type _reservation{0}, _length{0}, _pagesize{0};
   section_handle::flag _flag{section_handle::flag::none};
+  bool _recyclable{true};  // false once commit() or decommit() has changed the permissions of some of the map
 
   explicit map_handle(section_handle *section, section_handle::flag flags)
       : _section(section)
@@ -399,6 +421,7 @@ public:
       , _length(o._length)
       , _pagesize(o._pagesize)
       , _flag(o._flag)
+      , _recyclable(o._recyclable)
   {
     o._section = nullptr;
     o._addr = nullptr;
@@ -407,6 +430,7 @@ public:
     o._length = 0;
     o._pagesize = 0;
     o._flag = section_handle::flag::none;
+    o._recyclable = true;
   }
   //! No copy construction (use `clone()`)
   map_handle(const map_handle &) = delete;
@@ -467,11 +491,41 @@ public:
   the other constructor. This makes available all those very useful VM tricks Windows can do with section mapped memory which
   VirtualAlloc() memory cannot do.
 
+  \note On POSIX, closed maps of `flag::readwrite` memory are given `MADV_FREE` and kept in a process wide
+  cache of bounded capacity (see `trim_cache()`), from which a later call for the same number of bytes and
+  not `zeroed` is satisfied without any syscall. This avoids the TLB shootdowns of `munmap()`.
+
   \errors Any of the values POSIX mmap() or VirtualAlloc() can return.
   */
   LLFIO_MAKE_FREE_FUNCTION
   static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<map_handle> map(size_type bytes, bool zeroed = false, section_handle::flag _flag = section_handle::flag::readwrite) noexcept;
 
+  //! Statistics about the process wide cache of freed anonymous maps
+  struct cache_statistics
+  {
+    size_t items_in_cache{0};
+    size_t bytes_in_cache{0};
+    size_t items_just_trimmed{0};
+    size_t bytes_just_trimmed{0};
+    size_t hits{0}, misses{0};
+  };
+  /*! \brief Unmap any items in the cache of freed anonymous maps which were freed before `older_than`,
+  returning statistics about the cache.
+
+  The default `older_than` trims nothing, and so merely returns statistics. Pass
+  `std::chrono::steady_clock::now()` to empty the cache.
+
+  \mallocs None.
+  */
+  static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC cache_statistics trim_cache(std::chrono::steady_clock::time_point older_than = {}) noexcept;
+  /*! \brief Sets the maximum bytes of freed anonymous maps which will be cached, trimming the
+  least recently freed items to fit, returning the previous capacity. Zero disables the cache.
+  The default capacity is 64Mb.
+
+  \mallocs None.
+  */
+  static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC size_t set_cache_capacity(size_t bytes) noexcept;
+
   /*! Create a memory mapped view of a backing storage, optionally reserving additional address space for later growth.
   \param section A memory section handle specifying the backing storage to use.
   \param bytes How many bytes to reserve (0 = the size of the section). Rounded up to nearest 64Kb on Windows.
@@ -483,6 +537,20 @@ public:
   */
   LLFIO_MAKE_FREE_FUNCTION
   static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<map_handle> map(section_handle &section, size_type bytes = 0, extent_type offset = 0, section_handle::flag _flag = section_handle::flag::readwrite) noexcept;
+  /*! Create a memory mapped view of a backing storage at a specific address.
+  \param address Where to place the view, which must be a multiple of the page size, or on Windows the kernel memory
+  allocation granularity. Null means wherever the system chooses. On POSIX, any existing map of the address range is
+  replaced, so this is typically used to place views within address space reserved with a `map()` of `flag::none`,
+  which is then `release()`d. On Windows, the address range must be free.
+  \param section A memory section handle specifying the backing storage to use.
+  \param bytes How many bytes to map (0 = the size of the section).
+  \param offset The offset into the backing storage to map from.
+  \param _flag The permissions with which to map the view which are constrained by the permissions of the memory section.
+
+  \errors Any of the values POSIX mmap() or NtMapViewOfSection() can return.
+  */
+  LLFIO_MAKE_FREE_FUNCTION
+  static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<map_handle> map(byte *address, section_handle &section, size_type bytes = 0, extent_type offset = 0, section_handle::flag _flag = section_handle::flag::readwrite) noexcept;
 
   //! The memory section this handle is using
   section_handle *section() const noexcept { return _section; }
@@ -505,6 +573,28 @@ public:
   //! The page size used by the map, in bytes.
   size_type page_size() const noexcept { return _pagesize; }
 
+  //! Statistics about the pages actually backing a map
+  struct page_statistics
+  {
+    size_type resident{0};     //!< Bytes resident in memory.
+    size_type large_pages{0};  //!< Bytes of those resident which are in pages larger than `utils::page_size()`.
+    size_type page_size{0};    //!< The largest page size in use by the kernel for the map.
+  };
+  /*! \brief Returns how much of this map is resident in memory, and how much of that is in large pages,
+  whether those are explicit or transparent.
+
+  On Linux the resident bytes of exactly this map are counted with `mincore()`, which for maps of
+  files counts pages in the page cache. Large pages are read from `/proc/self/smaps`, which reports per
+  kernel memory region, and the kernel merges adjacent maps with the same properties into one region.
+  The large pages of each region intersecting this map are therefore counted in proportion to how much
+  of the region this map covers, which is exact unless the region includes other maps.
+
+  \errors Any of the values POSIX `open()`, `read()` or `mincore()` can return. `errc::operation_not_supported` on
+  platforms other than Linux.
+  \mallocs Sufficient to hold the contents of `/proc/self/smaps`.
+  */
+  LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<page_statistics> page_usage() const noexcept;
+
   //! True if the map is of non-volatile RAM
   bool is_nvram() const noexcept { return !!(_flag & section_handle::flag::nvram); }
 
@@ -592,6 +682,66 @@ public:
     return *ret.data();
   }
 
+  //! Statistics about a call to `populate()`
+  struct populate_statistics
+  {
+    size_type bytes_total{0};                        //!< The bytes to be populated.
+    size_type bytes_populated{0};                    //!< The bytes populated so far.
+    size_t threads{0};                               //!< The number of threads populating.
+    std::chrono::steady_clock::duration elapsed{};  //!< The time elapsed so far.
+    //! The rate of population so far, in gigabytes per second.
+    double gb_per_sec() const noexcept
+    {
+      const double secs = std::chrono::duration<double>(elapsed).count();
+      return (secs > 0) ? (static_cast<double>(bytes_populated) / secs / 1000000000.0) : 0;
+    }
+  };
+  //! The type of the progress callback for `populate()`
+  using populate_progress_type = detail::function_ptr<void(const populate_statistics &)>;
+
+protected:
+  static LLFIO_HEADERS_ONLY_MEMFUNC_SPEC result<populate_statistics> _populate(span<buffer_type> regions, bool for_write, size_t threads, populate_progress_type &&progress) noexcept;
+
+public:
+  /*! \brief Synchronously fault in every page of the span of memory regions given, splitting the work
+  across multiple threads, unlike `prefetch()` which merely asks the kernel to begin reading pages in,
+  or `section_handle::flag::prefault` which faults in pages serially on the calling thread.
+
+  The regions are split into chunks of 64Mb which the calling thread and `threads - 1` additional
+  threads populate until none remain. On Linux 5.14 or later, each chunk is populated with
+  `MADV_POPULATE_READ` or `MADV_POPULATE_WRITE`, otherwise each page of the chunk is touched
+  within a `QUICKCPPLIB_NAMESPACE::signal_guard`. Instantiating a
+  `QUICKCPPLIB_NAMESPACE::signal_guard_install` somewhere much higher up in the call stack
+  will improve performance enormously when pages are touched.
+
+  \return Statistics about the population, including the throughput achieved.
+  \param regions The regions to populate.
+  \param for_write Fault pages in for writing, which saves a second fault when they are first written.
+  Note that this dirties every page of a shared map.
+  \param threads The number of threads to use. Zero means `std::thread::hardware_concurrency()`.
+  \param progress Called with the statistics so far after each chunk is populated. Calls are serialised,
+  but may be from any of the populating threads.
+  \errors Any of the values POSIX `madvise()` can return, and `errc::bad_address` if a region
+  could not be faulted in, because it is not mapped, cannot be populated, or lacks read (or if
+  `for_write`, write) permission. Population stops at the first error.
+  \mallocs One per additional thread, plus the progress callback.
+  */
+  template <class U> static result<populate_statistics> populate(span<buffer_type> regions, bool for_write, size_t threads, U &&progress) noexcept
+  {
+    try
+    {
+      return _populate(regions, for_write, threads, detail::make_function_ptr<void(const populate_statistics &)>(std::forward<U>(progress)));
+    }
+    catch(...)
+    {
+      return error_from_exception();
+    }
+  }
+  //! \overload
+  static result<populate_statistics> populate(span<buffer_type> regions, bool for_write = false, size_t threads = 0) noexcept { return _populate(regions, for_write, threads, {}); }
+  //! \overload
+  static result<populate_statistics> populate(buffer_type region, bool for_write = false, size_t threads = 0) noexcept { return _populate(span<buffer_type>(&region, 1), for_write, threads, {}); }
+
   /*! \brief Read data from the mapped view.
 
   \note Because this implementation never copies memory, you can pass in buffers with a null address. As this
@@ -758,6 +908,10 @@ allocated from a paging file backed section instead, create a page file backed s
 the other constructor. This makes available all those very useful VM tricks Windows can do with section mapped memory which
 VirtualAlloc() memory cannot do.
 
+\note On POSIX, closed maps of `flag::readwrite` memory are given `MADV_FREE` and kept in a process wide
+cache of bounded capacity (see `trim_cache()`), from which a later call for the same number of bytes and
+not `zeroed` is satisfied without any syscall. This avoids the TLB shootdowns of `munmap()`.
+
 \errors Any of the values POSIX mmap() or VirtualAlloc() can return.
 */
 inline result<map_handle> map(map_handle::size_type bytes, bool zeroed = false, section_handle::flag _flag = section_handle::flag::readwrite) noexcept
@@ -776,6 +930,22 @@ inline result<map_handle> map(section_handle &section, map_handle::size_type byt
 {
   return map_handle::map(std::forward<decltype(section)>(section), std::forward<decltype(bytes)>(bytes), std::forward<decltype(offset)>(offset), std::forward<decltype(_flag)>(_flag));
 }
+/*! Create a memory mapped view of a backing storage at a specific address.
+\param address Where to place the view, which must be a multiple of the page size, or on Windows the kernel memory
+allocation granularity. Null means wherever the system chooses. On POSIX, any existing map of the address range is
+replaced, so this is typically used to place views within address space reserved with a `map()` of `flag::none`,
+which is then `release()`d. On Windows, the address range must be free.
+\param section A memory section handle specifying the backing storage to use.
+\param bytes How many bytes to map (0 = the size of the section).
+\param offset The offset into the backing storage to map from.
+\param _flag The permissions with which to map the view which are constrained by the permissions of the memory section.
+
+\errors Any of the values POSIX mmap() or NtMapViewOfSection() can return.
+*/
+inline result<map_handle> map(byte *address, section_handle &section, map_handle::size_type bytes = 0, map_handle::extent_type offset = 0, section_handle::flag _flag = section_handle::flag::readwrite) noexcept
+{
+  return map_handle::map(std::forward<decltype(address)>(address), std::forward<decltype(section)>(section), std::forward<decltype(bytes)>(bytes), std::forward<decltype(offset)>(offset), std::forward<decltype(_flag)>(_flag));
+}
 //! The size of the memory map. This is the accessible size, NOT the reservation size.
 inline map_handle::size_type length(const map_handle &self) noexcept
 {
@@ -892,6 +1062,7 @@ LLFIO_V2_NAMESPACE_END
 #else
 #include "detail/impl/posix/map_handle.ipp"
 #endif
+#include "detail/impl/map_handle.ipp"
 #undef LLFIO_INCLUDED_BY_HEADER
 #endif
 
@@ -121,6 +121,7 @@ public:
   using const_buffer_type = io_handle::const_buffer_type;
   using buffers_type = io_handle::buffers_type;
   using const_buffers_type = io_handle::const_buffers_type;
+  using io_priority = io_handle::io_priority;
   template <class T> using io_request = io_handle::io_request<T>;
   template <class T> using io_result = io_handle::io_result<T>;
 
@@ -373,6 +374,31 @@ public:
     return bytes;
   }
 
+  //! \brief Allocates storage as per `file_handle::preallocate()`, then updates the map to any new length.
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<extent_type> preallocate(extent_type offset, extent_type bytes, bool keep_size = false) noexcept override
+  {
+    OUTCOME_TRY(ret, file_handle::preallocate(offset, bytes, keep_size));
+    if(!keep_size)
+    {
+      OUTCOME_TRYV(update_map());
+    }
+    return ret;
+  }
+  //! \brief Removes a range as per `file_handle::collapse_range()`, then updates the map to the new length.
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> collapse_range(extent_type offset, extent_type bytes) noexcept override
+  {
+    OUTCOME_TRYV(file_handle::collapse_range(offset, bytes));
+    OUTCOME_TRYV(update_map());
+    return success();
+  }
+  //! \brief Inserts a hole as per `file_handle::insert_range()`, then updates the map to the new length.
+  LLFIO_HEADERS_ONLY_VIRTUAL_SPEC result<void> insert_range(extent_type offset, extent_type bytes) noexcept override
+  {
+    OUTCOME_TRYV(file_handle::insert_range(offset, bytes));
+    OUTCOME_TRYV(update_map());
+    return success();
+  }
+
   using file_handle::read;
   using file_handle::write;
 
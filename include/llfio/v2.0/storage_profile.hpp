@@ -217,6 +217,7 @@ namespace storage_profile
     LLFIO_HEADERS_ONLY_FUNC_SPEC outcome<void> read_qd16(storage_profile &sp, file_handle &srch) noexcept;
     LLFIO_HEADERS_ONLY_FUNC_SPEC outcome<void> write_qd16(storage_profile &sp, file_handle &srch) noexcept;
     LLFIO_HEADERS_ONLY_FUNC_SPEC outcome<void> readwrite_qd4(storage_profile &sp, file_handle &srch) noexcept;
+    LLFIO_HEADERS_ONLY_FUNC_SPEC outcome<void> durable_write_qd1(storage_profile &sp, file_handle &srch) noexcept;
   }
   namespace response_time
   {
@@ -369,6 +370,13 @@ namespace storage_profile
     item<unsigned long long> readwrite_qd4_99 = {"latency:readwrite:qd4:99%", latency::readwrite_qd4, "The nanoseconds to 75% read 25% write 4Kb at a total queue depth of 4 (99% of the time)"};
     item<unsigned long long> readwrite_qd4_99999 = {"latency:readwrite:qd4:99.999%", latency::readwrite_qd4, "The nanoseconds to 75% read 25% write 4Kb at a total queue depth of 4 (99.999% of the time)"};
 
+    item<unsigned long long> durable_write_qd1_twostep_mean = {"latency:durable_write:qd1:two_step:mean", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write() then async_barrier() at a queue depth of 1 (arithmetic mean)"};
+    item<unsigned long long> durable_write_qd1_twostep_50 = {"latency:durable_write:qd1:two_step:50%", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write() then async_barrier() at a queue depth of 1 (50% of the time)"};
+    item<unsigned long long> durable_write_qd1_twostep_99 = {"latency:durable_write:qd1:two_step:99%", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write() then async_barrier() at a queue depth of 1 (99% of the time)"};
+    item<unsigned long long> durable_write_qd1_fused_mean = {"latency:durable_write:qd1:fused:mean", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write_and_barrier() at a queue depth of 1 (arithmetic mean)"};
+    item<unsigned long long> durable_write_qd1_fused_50 = {"latency:durable_write:qd1:fused:50%", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write_and_barrier() at a queue depth of 1 (50% of the time)"};
+    item<unsigned long long> durable_write_qd1_fused_99 = {"latency:durable_write:qd1:fused:99%", latency::durable_write_qd1, "The nanoseconds to write 4Kb then fdatasync via async_write_and_barrier() at a queue depth of 1 (99% of the time)"};
+
     item<unsigned long long> create_file_warm_racefree_0b = {"response_time:race_free:warm_cache:create_file:0b", response_time::traversal_warm_racefree_0b, "The average nanoseconds to create a 0 byte file (warm cache, race free)"};
     item<unsigned long long> enumerate_file_warm_racefree_0b = {"response_time:race_free:warm_cache:enumerate_file:0b", response_time::traversal_warm_racefree_0b, "The average nanoseconds to enumerate a 0 byte file (warm cache, race free)"};
     item<unsigned long long> open_file_read_warm_racefree_0b = {"response_time:race_free:warm_cache:open_file_read:0b", response_time::traversal_warm_racefree_0b, "The average nanoseconds to open a 0 byte file for reading (warm cache, race free)"};
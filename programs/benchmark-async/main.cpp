@@ -0,0 +1,159 @@
+/* Test the throughput and latency of the async i/o engines
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#define BLOCKSIZE (4096)
+#define REGIONSIZE (256 * 1024 * 1024)
+#define SECONDS_PER_TEST (5)
+
+#include "../../include/llfio/llfio.hpp"
+#if __has_include("quickcpplib/include/algorithm/small_prng.hpp")
+#include "quickcpplib/include/algorithm/small_prng.hpp"
+#else
+#include "../../include/llfio/v2.0/quickcpplib/include/algorithm/small_prng.hpp"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace llfio = LLFIO_V2_NAMESPACE;
+using QUICKCPPLIB_NAMESPACE::algorithm::small_prng::small_prng;
+
+struct results_t
+{
+  double iops{0};
+  unsigned long long min{0}, mean{0}, _50{0}, _99{0}, max{0};
+};
+
+// Keep exactly qd random reads of BLOCKSIZE in flight for SECONDS_PER_TEST
+inline results_t run_test(llfio::io_service &service, llfio::async_file_handle &h, size_t qd)
+{
+  using clock = std::chrono::high_resolution_clock;
+  struct slot_t
+  {
+    alignas(4096) llfio::byte buffer[BLOCKSIZE];
+    llfio::async_file_handle::buffer_type bt{buffer, BLOCKSIZE};
+    llfio::async_file_handle::io_state_ptr state;
+    clock::time_point began;
+    bool ready{true};
+  };
+  std::vector<slot_t> slots(qd);
+  std::vector<unsigned long long> latencies;
+  latencies.reserve(16 * 1024 * 1024);
+  small_prng rand;
+  auto schedule = [&](slot_t &slot) {
+    slot.ready = false;
+    slot.began = clock::now();
+    slot.state.reset();
+    slot.state = h.async_read({{&slot.bt, 1}, (rand() % REGIONSIZE) & ~(BLOCKSIZE - 1ULL)}, [&slot, &latencies](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::buffers_type> &&result) {
+                   result.value();
+                   latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - slot.began).count());
+                   slot.ready = true;
+                 })
+                 .value();
+  };
+  auto begin = clock::now();
+  while(std::chrono::duration_cast<std::chrono::seconds>(clock::now() - begin).count() < SECONDS_PER_TEST)
+  {
+    for(auto &slot : slots)
+    {
+      if(slot.ready)
+      {
+        schedule(slot);
+      }
+    }
+    service.run().value();
+  }
+  auto end = clock::now();
+  while(service.run().value())
+  {
+  }
+  results_t ret;
+  ret.iops = latencies.size() / std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+  std::sort(latencies.begin(), latencies.end());
+  unsigned long long sum = 0;
+  for(auto i : latencies)
+  {
+    sum += i;
+  }
+  ret.min = latencies.front();
+  ret.mean = sum / latencies.size();
+  ret._50 = latencies[static_cast<size_t>(0.5 * latencies.size())];
+  ret._99 = latencies[static_cast<size_t>(0.99 * latencies.size())];
+  ret.max = latencies.back();
+  return ret;
+}
+
+int main()
+{
+#if LLFIO_USE_POSIX_AIO
+  try
+  {
+    std::cout << "Preparing " << (REGIONSIZE / 1024 / 1024) << "Mb test file ..." << std::endl;
+    {
+      // Write around the page cache, so none of the test file is left cached
+      auto fh = llfio::file_handle::file({}, "testfile", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata).value();
+      std::vector<llfio::byte, llfio::utils::page_allocator<llfio::byte>> buffer(REGIONSIZE);
+      fh.write(0, {{buffer.data(), buffer.size()}}).value();
+    }
+    std::vector<std::pair<const char *, llfio::io_service::engine>> engines{{"POSIX AIO", llfio::io_service::engine::posix_aio}};
+#if LLFIO_USE_IO_URING
+    engines.emplace_back("io_uring", llfio::io_service::engine::io_uring);
+#endif
+    for(auto &engine : engines)
+    {
+      for(bool busy_poll : {false, true})
+      {
+        for(size_t qd : {1, 16, 128})
+        {
+          llfio::io_service service(engine.second);
+          if(busy_poll)
+          {
+            service.set_busy_poll(std::chrono::microseconds(100));
+          }
+          // Read around the page cache, so the device rather than memory is measured
+          auto h = llfio::async_file_handle::async_file(service, {}, "testfile", llfio::file_handle::mode::read, llfio::file_handle::creation::open_existing, llfio::file_handle::caching::only_metadata).value();
+          auto r = run_test(service, h, qd);
+          std::cout << engine.first << (busy_poll ? " busy polling" : "") << " at QD" << qd << ": " << static_cast<unsigned long long>(r.iops) << " IOPS, latency min " << r.min << " mean " << r.mean << " 50% " << r._50 << " 99% " << r._99 << " max " << r.max << " ns" << std::endl;
+          if(busy_poll)
+          {
+            auto stats = service.busy_poll_stats();
+            std::cout << "   " << stats.spin_hits << " of " << stats.spins << " spins found completions, slept " << stats.sleeps << " times" << std::endl;
+          }
+        }
+      }
+    }
+    llfio::file_handle::file({}, "testfile", llfio::file_handle::mode::write).value().unlink().value();
+  }
+  catch(const std::exception &e)
+  {
+    std::cerr << "FATAL: " << e.what() << std::endl;
+    return 1;
+  }
+#else
+  std::cerr << "This benchmark requires POSIX AIO" << std::endl;
+#endif
+  return 0;
+}
@@ -0,0 +1,174 @@
+/* Test the latency and throughput of io_service::post() from another thread
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#define LATENCY_POSTS (100000)
+#define THROUGHPUT_POSTS (1000000)
+
+#include "../../include/llfio/llfio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace llfio = LLFIO_V2_NAMESPACE;
+
+struct results_t
+{
+  double posts_per_sec{0};
+  unsigned long long mean{0}, _50{0}, _99{0}, max{0};
+};
+
+inline results_t run_test(llfio::io_service::engine engine, bool use_eventfd)
+{
+  using clock = std::chrono::high_resolution_clock;
+  // Only io_uring can be woken by an eventfd
+  llfio::io_service service(engine);
+  if(!use_eventfd)
+  {
+    service.disable_eventfd_wakeup();
+  }
+  // Keep a read of an empty pipe in flight, so run() sleeps in the kernel until woken by a post
+  int fds[2];
+  if(-1 == ::pipe(fds))
+  {
+    throw std::system_error(errno, std::system_category());
+  }
+  llfio::async_file_handle ph(&service, llfio::native_handle_type(llfio::native_handle_type::disposition::readable, fds[0]), 0, 0);
+  llfio::byte b;
+  llfio::async_file_handle::buffer_type bt{&b, 1};
+  bool pipe_read = false;
+  auto state = ph.async_read({{&bt, 1}, 0}, [&pipe_read](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::buffers_type> &&result) {
+                   result.value();
+                   pipe_read = true;
+                 })
+               .value();
+
+  std::vector<unsigned long long> latencies;
+  latencies.reserve(LATENCY_POSTS);
+  std::atomic<bool> acked{false};
+  size_t executed = 0;
+  clock::time_point throughput_begin, throughput_end;
+  std::thread poster([&] {
+    // Latency: post to a sleeping run(), and wait for it to be executed
+    for(size_t n = 0; n < LATENCY_POSTS; n++)
+    {
+      acked = false;
+      auto posted = clock::now();
+      service.post([&latencies, &acked, posted](llfio::io_service * /*unused*/) {
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - posted).count());
+        acked = true;
+      });
+      while(!acked)
+      {
+        std::this_thread::yield();
+      }
+      // Give run() time to go back to sleep
+      auto until = clock::now() + std::chrono::microseconds(20);
+      while(clock::now() < until)
+      {
+      }
+    }
+    // Throughput: post as fast as possible
+    throughput_begin = clock::now();
+    for(size_t n = 0; n < THROUGHPUT_POSTS; n++)
+    {
+      service.post([&executed, &throughput_end](llfio::io_service * /*unused*/) {
+        if(++executed == THROUGHPUT_POSTS)
+        {
+          throughput_end = clock::now();
+        }
+      });
+    }
+  });
+  while(executed < THROUGHPUT_POSTS)
+  {
+    service.run().value();
+  }
+  poster.join();
+  // Complete the pipe read
+  if(1 != ::write(fds[1], &b, 1))
+  {
+    throw std::system_error(errno, std::system_category());
+  }
+  while(!pipe_read)
+  {
+    service.run().value();
+  }
+  state.reset();
+  ::close(fds[1]);
+
+  results_t ret;
+  ret.posts_per_sec = THROUGHPUT_POSTS / std::chrono::duration_cast<std::chrono::duration<double>>(throughput_end - throughput_begin).count();
+  std::sort(latencies.begin(), latencies.end());
+  unsigned long long sum = 0;
+  for(auto i : latencies)
+  {
+    sum += i;
+  }
+  ret.mean = sum / latencies.size();
+  ret._50 = latencies[static_cast<size_t>(0.5 * latencies.size())];
+  ret._99 = latencies[static_cast<size_t>(0.99 * latencies.size())];
+  ret.max = latencies.back();
+  return ret;
+}
+
+int main()
+{
+#if LLFIO_USE_POSIX_AIO
+  try
+  {
+    struct wakeup_t
+    {
+      const char *name;
+      llfio::io_service::engine engine;
+      bool use_eventfd;
+    };
+    std::vector<wakeup_t> wakeups{{"signal", llfio::io_service::engine::posix_aio, false}};
+#if LLFIO_USE_IO_URING
+    wakeups.push_back({"io_uring signal", llfio::io_service::engine::io_uring, false});
+#if LLFIO_USE_EVENTFD
+    wakeups.push_back({"io_uring eventfd", llfio::io_service::engine::io_uring, true});
+#endif
+#endif
+    for(auto &wakeup : wakeups)
+    {
+      auto r = run_test(wakeup.engine, wakeup.use_eventfd);
+      std::cout << "post() woken by " << wakeup.name << ": " << static_cast<unsigned long long>(r.posts_per_sec) << " posts/sec, wakeup latency mean " << r.mean << " 50% " << r._50 << " 99% " << r._99 << " max " << r.max << " ns" << std::endl;
+    }
+  }
+  catch(const std::exception &e)
+  {
+    std::cerr << "FATAL: " << e.what() << std::endl;
+    return 1;
+  }
+#else
+  std::cerr << "This benchmark requires POSIX AIO" << std::endl;
+#endif
+  return 0;
+}
@@ -24,12 +24,14 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include "../test_kernel_decl.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <future>
+#include <thread>
 
-static inline void TestAsyncFileHandle()
+static inline void _TestAsyncFileHandle(LLFIO_V2_NAMESPACE::io_service &service)
 {
   namespace llfio = LLFIO_V2_NAMESPACE;
-  llfio::io_service service;
   llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
   std::vector<std::pair<std::future<llfio::async_file_handle::const_buffers_type>, llfio::async_file_handle::io_state_ptr>> futures;
   futures.reserve(1024);
@@ -84,4 +86,493 @@ static inline void TestAsyncFileHandle()
   }
 }
 
+static inline void TestAsyncFileHandle()
+{
+  LLFIO_V2_NAMESPACE::io_service service;
+  _TestAsyncFileHandle(service);
+}
+
+static inline void TestAsyncFileHandleIoStateCache()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+  h.truncate(4096).value();
+  alignas(4096) llfio::byte buffer[4096];
+  memset(buffer, 78, 4096);                                                // NOLINT
+  llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+  for(size_t n = 0; n < 100; n++)
+  {
+    bool done = false;
+    auto state = h.async_write({bt, 0}, [&done](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+                    result.value();
+                    done = true;
+                  })
+                 .value();
+    while(!done)
+    {
+      service.run().value();
+    }
+  }
+  // Only the very first i/o state should have come from the heap
+  auto stats = service.io_state_cache_stats();
+  BOOST_CHECK(stats.mallocs == 1);
+  BOOST_CHECK(stats.recycles == 99);
+}
+
+static inline void TestAsyncFileHandleBatch()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  llfio::async_file_handle h[2] = {
+  llfio::async_file_handle::async_file(service, {}, "temp1", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value(),
+  llfio::async_file_handle::async_file(service, {}, "temp2", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value()  //
+  };
+  h[0].truncate(128 * 4096).value();
+  h[1].truncate(128 * 4096).value();
+  alignas(4096) llfio::byte buffer[4096];
+  memset(buffer, 78, 4096);                                                // NOLINT
+  llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+  std::vector<llfio::async_file_handle::io_state_ptr> states;
+  size_t completed = 0;
+  {
+    llfio::io_service::batch b(service);
+    for(size_t n = 0; n < 256; n++)
+    {
+      states.push_back(h[n & 1].async_write({bt, (n / 2) * 4096}, [&completed](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+                                 BOOST_CHECK(result && result.value().data()->size() == 4096);
+                                 ++completed;
+                               })
+                       .value());
+    }
+    b.submit().value();
+  }
+  while(service.run().value())
+  {
+  }
+  BOOST_CHECK(completed == 256);
+}
+
+static inline void TestAsyncFileHandleCancel()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+  h.truncate(64 * 4096).value();
+  struct buffer_t
+  {
+    alignas(4096) llfio::byte data[4096];
+    llfio::async_file_handle::buffer_type bt{data, sizeof(data)};
+  };
+  for(bool batched : {true, false})
+  {
+    std::vector<std::weak_ptr<buffer_t>> buffers;
+    std::vector<llfio::async_file_handle::io_state_ptr> states;
+    size_t completed = 0, cancelled = 0;
+    {
+      // While a batch is open nothing reaches the kernel, so cancellation always wins
+      llfio::optional<llfio::io_service::batch> b;
+      if(batched)
+      {
+        b.emplace(service);
+      }
+      for(size_t n = 0; n < 64; n++)
+      {
+        auto buffer = std::make_shared<buffer_t>();
+        buffers.push_back(buffer);
+        llfio::async_file_handle::io_request<llfio::async_file_handle::buffers_type> req({&buffer->bt, 1}, n * 4096);
+        states.push_back(h.async_read(req, [buffer, &completed, &cancelled](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::buffers_type> &&result) mutable {
+                            if(!result)
+                            {
+                              BOOST_CHECK(result.error() == llfio::errc::operation_canceled);
+                              ++cancelled;
+                            }
+                            ++completed;
+                            // Release the buffer as soon as the i/o is done with it
+                            buffer.reset();
+                          })
+                         .value());
+      }
+      for(auto &state : states)
+      {
+        state->cancel().value();
+      }
+    }
+    while(service.run().value())
+    {
+    }
+    std::cout << "With batched = " << batched << ", " << cancelled << " of " << completed << " reads were cancelled" << std::endl;
+    BOOST_CHECK(completed == 64);
+#ifndef _WIN32
+    if(batched)
+    {
+      BOOST_CHECK(cancelled == 64);
+    }
+#endif
+    // Every buffer is freed by its completion, before the i/o states are destroyed
+    for(auto &buffer : buffers)
+    {
+      BOOST_CHECK(buffer.expired());
+    }
+    // Cancelling after completion does nothing
+    for(auto &state : states)
+    {
+      BOOST_CHECK(state->cancel());
+    }
+    BOOST_CHECK(completed == 64);
+  }
+}
+
+#if LLFIO_USE_POSIX_AIO
+static inline void _TestAsyncFileHandleWriteAndBarrier(LLFIO_V2_NAMESPACE::io_service &service)
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  alignas(4096) llfio::byte buffer[2][4096];
+  memset(buffer[0], 78, 4096);  // NOLINT
+  memset(buffer[1], 79, 4096);  // NOLINT
+  llfio::async_file_handle::const_buffer_type bts[2] = {{buffer[0], 4096}, {buffer[1], 4096}};
+  {
+    llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp_write_and_barrier", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata).value();
+    for(bool and_metadata : {false, true})
+    {
+      size_t completions = 0;
+      llfio::optional<llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type>> written;
+      auto state = h.async_write_and_barrier({bts, 0},
+                                             [&](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+                                               ++completions;
+                                               written = std::move(result);
+                                             },
+                                             and_metadata)
+                   .value();
+      while(service.run().value())
+      {
+      }
+      // The writes and the barrier complete as one
+      BOOST_CHECK(completions == 1);
+      BOOST_REQUIRE(written && *written);
+      BOOST_CHECK(written->value().size() == 2);
+      BOOST_CHECK(written->value()[0].size() == 4096);
+      BOOST_CHECK(written->value()[1].size() == 4096);
+    }
+    alignas(4096) llfio::byte check[8192];
+    llfio::async_file_handle::buffer_type bt{check, sizeof(check)};
+    auto read = h.read({{&bt, 1}, 0}).value();
+    BOOST_CHECK(read[0].size() == 8192);
+    BOOST_CHECK(0 == memcmp(check, buffer[0], 4096));
+    BOOST_CHECK(0 == memcmp(check + 4096, buffer[1], 4096));
+  }
+  {
+    // Writing to a read only handle fails the writes, and the barrier is not reported separately
+    llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp_write_and_barrier", llfio::file_handle::mode::read, llfio::file_handle::creation::open_existing, llfio::file_handle::caching::only_metadata).value();
+    size_t completions = 0;
+    llfio::optional<llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type>> written;
+    auto state = h.async_write_and_barrier({bts, 0}, [&](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+                    ++completions;
+                    written = std::move(result);
+                  });
+    if(state)
+    {
+      while(service.run().value())
+      {
+      }
+      BOOST_CHECK(completions == 1);
+      BOOST_CHECK(written && !*written);
+    }
+  }
+  llfio::file_handle::file({}, "temp_write_and_barrier", llfio::file_handle::mode::write).value().unlink().value();
+}
+
+static inline void TestAsyncFileHandleWriteAndBarrier()
+{
+  LLFIO_V2_NAMESPACE::io_service service;
+  _TestAsyncFileHandleWriteAndBarrier(service);
+#if LLFIO_USE_IO_URING
+  try
+  {
+    LLFIO_V2_NAMESPACE::io_service uring(LLFIO_V2_NAMESPACE::io_service::engine::io_uring);
+    _TestAsyncFileHandleWriteAndBarrier(uring);
+  }
+  catch(const std::system_error &e)
+  {
+    std::cout << "NOTE: io_uring unavailable on this system (" << e.what() << "), skipping io_uring part of test" << std::endl;
+  }
+#endif
+}
+
+static inline void _TestIoServicePostWakeup(LLFIO_V2_NAMESPACE::io_service &service)
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  // Keep a write in flight so run() has i/o to sleep upon
+  llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+  alignas(4096) llfio::byte buffer[4096];
+  memset(buffer, 78, 4096);                                                // NOLINT
+  llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+  auto state = h.async_write({bt, 0}, [](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) { BOOST_CHECK(result); }).value();
+  size_t executed = 0;
+  std::thread poster([&service, &executed] {
+    for(size_t n = 0; n < 10000; n++)
+    {
+      service.post([&executed](llfio::io_service * /*unused*/) { ++executed; });
+      if((n % 100) == 0)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  });
+  while(executed < 10000)
+  {
+    service.run().value();
+  }
+  poster.join();
+  while(service.run().value())
+  {
+  }
+  BOOST_CHECK(executed == 10000);
+}
+
+static inline void TestIoServicePostWakeup()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  {
+    // POSIX AIO is always woken by the signal
+    llfio::io_service service;
+    BOOST_CHECK(!service.using_eventfd_wakeup());
+    _TestIoServicePostWakeup(service);
+  }
+#if LLFIO_USE_IO_URING
+  for(bool use_eventfd : {true, false})
+  {
+    try
+    {
+      llfio::io_service service(llfio::io_service::engine::io_uring);
+      if(!use_eventfd)
+      {
+        service.disable_eventfd_wakeup();
+      }
+      BOOST_CHECK(!service.using_eventfd_wakeup() || use_eventfd);
+      _TestIoServicePostWakeup(service);
+    }
+    catch(const std::system_error &e)
+    {
+      std::cout << "NOTE: io_uring unavailable on this system (" << e.what() << "), skipping io_uring part of test" << std::endl;
+      break;
+    }
+  }
+#endif
+}
+
+#endif
+
+#if LLFIO_USE_POSIX_AIO
+static inline void TestAsyncFileHandleBackgroundPriority()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  service.set_background_queue_depth(1);
+  BOOST_CHECK(service.background_queue_depth() == 1);
+  llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+  h.truncate(64 * 4096).value();
+  alignas(4096) llfio::byte buffer[4096];
+  llfio::async_file_handle::buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+  std::vector<llfio::async_file_handle::io_state_ptr> states;
+  std::vector<int> order;
+  size_t cancelled = 0;
+  auto read = [&](size_t idx, llfio::async_file_handle::io_priority priority) {
+    llfio::async_file_handle::io_request<llfio::async_file_handle::buffers_type> req({&bt, 1}, idx * 4096, priority);
+    states.push_back(h.async_read(req, [idx, &order, &cancelled](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::buffers_type> &&result) {
+                        if(!result)
+                        {
+                          BOOST_CHECK(result.error() == llfio::errc::operation_canceled);
+                          ++cancelled;
+                          return;
+                        }
+                        order.push_back(static_cast<int>(idx));
+                      })
+                     .value());
+  };
+  // Completions are only reaped by run(), so the foreground read remains in flight until then
+  read(0, llfio::async_file_handle::io_priority::normal);
+  for(size_t n = 1; n <= 4; n++)
+  {
+    read(n, llfio::async_file_handle::io_priority::background);
+  }
+  // One background read fits within the queue depth, the other three are held back
+  BOOST_CHECK(service.background_queued() == 3);
+  // Cancelling held back i/o completes it immediately
+  states.back()->cancel().value();
+  BOOST_CHECK(cancelled == 1);
+  BOOST_CHECK(service.background_queued() == 2);
+  while(service.run().value())
+  {
+  }
+  BOOST_CHECK(service.background_queued() == 0);
+  BOOST_CHECK(order.size() == 4);
+  // Held back background i/o is issued in order
+  auto it2 = std::find(order.begin(), order.end(), 2), it3 = std::find(order.begin(), order.end(), 3);
+  BOOST_CHECK(it2 != order.end() && it3 != order.end() && it2 < it3);
+  // Synchronous i/o accepts a priority too
+  llfio::async_file_handle::io_request<llfio::async_file_handle::buffers_type> req({&bt, 1}, 0, llfio::async_file_handle::io_priority::background);
+  BOOST_CHECK(h.read(req));
+}
+
+static inline void TestAsyncFileHandleCompletionPool()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  service.set_completion_threads(4).value();
+  BOOST_CHECK(service.completion_threads() == 4);
+  _TestAsyncFileHandle(service);
+
+  // Initiating i/o from a pool thread is refused, posting it to the owning thread works
+  llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+  h.truncate(2 * 4096).value();
+  alignas(4096) llfio::byte buffer[4096];
+  memset(buffer, 78, 4096);                                                // NOLINT
+  llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+  std::atomic<bool> refused{false}, posted_done{false};
+  llfio::async_file_handle::io_state_ptr posted_state;
+  auto completion = [&](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+    result.value();
+    auto r = h.async_write({bt, 4096}, [](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> && /*unused*/) {});
+    refused = (!r && r.error() == llfio::errc::operation_not_supported);
+    service.post([&](llfio::io_service * /*unused*/) {
+      posted_state = h.async_write({bt, 4096}, [&](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result2) {
+                        BOOST_CHECK(result2);
+                        posted_done = true;
+                      })
+                     .value();
+    });
+  };
+  auto state = h.async_write({bt, 0}, completion).value();
+  while(!posted_done)
+  {
+    service.run().value();
+  }
+  while(service.run().value())
+  {
+  }
+  BOOST_CHECK(refused);
+}
+
+static inline void TestAsyncFileHandleBusyPoll()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::io_service service;
+  service.set_busy_poll(std::chrono::microseconds(50));
+  BOOST_CHECK(service.busy_poll() == std::chrono::microseconds(50));
+  _TestAsyncFileHandle(service);
+  auto stats = service.busy_poll_stats();
+  BOOST_CHECK(stats.spins > 0);
+  BOOST_CHECK(stats.spin_hits <= stats.spins);
+  service.reset_busy_poll_stats();
+  BOOST_CHECK(service.busy_poll_stats().spins == 0);
+}
+#endif
+
+#if LLFIO_USE_IO_URING
+static inline void TestAsyncFileHandleIoUring()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  try
+  {
+    llfio::io_service service(llfio::io_service::engine::io_uring);
+    BOOST_CHECK(service.using_io_uring());
+    _TestAsyncFileHandle(service);
+  }
+  catch(const std::system_error &e)
+  {
+    // Kernel too old, or io_uring disabled by policy
+    std::cout << "NOTE: io_uring unavailable on this system (" << e.what() << "), skipping test" << std::endl;
+  }
+}
+#endif
+
+#if LLFIO_USE_IO_URING
+static inline void TestAsyncFileHandleIoUringPolling()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  try
+  {
+    // The kernel's polling thread may consume SQEs the moment they are published
+    llfio::io_service service(llfio::io_service::engine::io_uring, 256, llfio::io_service::io_uring_flag::sqpoll);
+    _TestAsyncFileHandle(service);
+  }
+  catch(const std::system_error &e)
+  {
+    std::cout << "NOTE: io_uring with sqpoll unavailable on this system (" << e.what() << "), skipping sqpoll part of test" << std::endl;
+  }
+  try
+  {
+    llfio::io_service service(llfio::io_service::engine::io_uring, 256, llfio::io_service::io_uring_flag::iopoll);
+    llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+    alignas(4096) llfio::byte buffer[4096];
+    memset(buffer, 78, 4096);                                                // NOLINT
+    llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+    auto handler = [](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> && /*unused*/) { BOOST_CHECK(false); };
+    // Only direct reads and writes are accepted by an iopoll io_uring, so barriers are refused up front
+    auto barrier = h.async_barrier({}, handler);
+    BOOST_REQUIRE(!barrier);
+    BOOST_CHECK(barrier.error() == llfio::errc::operation_not_supported);
+    auto write_and_barrier = h.async_write_and_barrier({bt, 0}, handler);
+    BOOST_REQUIRE(!write_and_barrier);
+    BOOST_CHECK(write_and_barrier.error() == llfio::errc::operation_not_supported);
+    BOOST_CHECK(!h.barrier());
+    // Nothing was queued, so there is no work
+    BOOST_CHECK(!service.run().value());
+  }
+  catch(const std::system_error &e)
+  {
+    std::cout << "NOTE: io_uring with iopoll unavailable on this system (" << e.what() << "), skipping iopoll part of test" << std::endl;
+  }
+}
+
+static inline void TestAsyncFileHandleIoUringDeadlines()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  try
+  {
+    llfio::io_service service(llfio::io_service::engine::io_uring, 8);
+    llfio::async_file_handle h = llfio::async_file_handle::async_file(service, {}, "temp", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed, llfio::file_handle::caching::only_metadata, llfio::file_handle::flag::unlink_on_first_close).value();
+    h.truncate(4096).value();
+    alignas(4096) llfio::byte buffer[4096];
+    memset(buffer, 78, 4096);                                                // NOLINT
+    llfio::async_file_handle::const_buffer_type bt{buffer, sizeof(buffer)};  // NOLINT
+    // Every run_until() arms a timeout which the write beats. Far more than the ring can hold
+    // must be removed again, else their completions would eventually overflow the ring.
+    for(size_t n = 0; n < 1000; n++)
+    {
+      bool done = false;
+      auto state = h.async_write({bt, 0}, [&done](llfio::async_file_handle *, llfio::async_file_handle::io_result<llfio::async_file_handle::const_buffers_type> &&result) {
+                      result.value();
+                      done = true;
+                    })
+                   .value();
+      while(!done)
+      {
+        service.run_until(std::chrono::seconds(60)).value();
+      }
+    }
+  }
+  catch(const std::system_error &e)
+  {
+    std::cout << "NOTE: io_uring unavailable on this system (" << e.what() << "), skipping test" << std::endl;
+  }
+}
+#endif
+
 KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle, "Tests that llfio::async_file_handle works as expected", TestAsyncFileHandle())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_io_state_cache, "Tests that llfio::io_service recycles i/o states", TestAsyncFileHandleIoStateCache())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_batch, "Tests that llfio::io_service::batch works as expected", TestAsyncFileHandleBatch())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_cancel, "Tests that cancelling llfio::async_file_handle i/o completes exactly once and frees its buffers", TestAsyncFileHandleCancel())
+#if LLFIO_USE_POSIX_AIO
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_write_and_barrier, "Tests that llfio::async_file_handle::async_write_and_barrier() completes once for the writes and the barrier", TestAsyncFileHandleWriteAndBarrier())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, io_service_post_wakeup, "Tests that llfio::io_service::post() from another thread wakes run()", TestIoServicePostWakeup())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_background_priority, "Tests that llfio::io_service holds back background i/o while other i/o is in flight", TestAsyncFileHandleBackgroundPriority())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_completion_pool, "Tests that llfio::async_file_handle works as expected with a completion pool", TestAsyncFileHandleCompletionPool())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_busy_poll, "Tests that llfio::async_file_handle works as expected when busy polling", TestAsyncFileHandleBusyPoll())
+#endif
+#if LLFIO_USE_IO_URING
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_io_uring, "Tests that llfio::async_file_handle works as expected using io_uring", TestAsyncFileHandleIoUring())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_io_uring_polling, "Tests that llfio::io_service works with sqpoll, and refuses what iopoll cannot do", TestAsyncFileHandleIoUringPolling())
+KERNELTEST_TEST_KERNEL(integration, llfio, works, async_file_handle_io_uring_deadlines, "Tests that llfio::io_service does not leak io_uring timeouts when i/o beats the deadline", TestAsyncFileHandleIoUringDeadlines())
+#endif
@@ -0,0 +1,88 @@
+/* Integration test kernel for algorithm::copy_file()
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestCopyFile()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  // An 8Mb file with three islands of data, the last ending partway through the final page
+  llfio::file_handle src = llfio::file_handle::temp_inode().value();
+  const llfio::file_handle::extent_type size = 8 * 1024 * 1024 + 100;
+  std::vector<llfio::byte> data(300 * 1024);
+  for(size_t n = 0; n < data.size(); n++)
+  {
+    data[n] = static_cast<llfio::byte>(n % 251);
+  }
+  src.truncate(size).value();
+  src.write(0, {{data.data(), data.size()}}).value();
+  src.write(3 * 1024 * 1024 + 17, {{data.data(), data.size()}}).value();
+  src.write(size - 5000, {{data.data(), 5000}}).value();
+  auto check = [&](llfio::file_handle &dest) {
+    BOOST_REQUIRE(dest.maximum_extent().value() == size);
+    std::vector<llfio::byte> expected(static_cast<size_t>(size)), in(static_cast<size_t>(size));
+    memcpy(expected.data(), data.data(), data.size());
+    memcpy(expected.data() + 3 * 1024 * 1024 + 17, data.data(), data.size());
+    memcpy(expected.data() + size - 5000, data.data(), 5000);
+    BOOST_REQUIRE(dest.read(0, {{in.data(), in.size()}}).value() == in.size());
+    BOOST_CHECK(0 == memcmp(in.data(), expected.data(), in.size()));
+  };
+  {
+    // Copying a file onto itself, even through another handle, is refused without touching it
+    auto same = src.clone().value();
+    auto copied = llfio::algorithm::copy_file(same, src);
+    BOOST_REQUIRE(!copied);
+    BOOST_CHECK(copied.error() == llfio::errc::invalid_argument);
+    check(src);
+  }
+  for(size_t threads : {1, 4})
+  {
+    // Cached i/o, with a small chunk size so the threads share the extents
+    {
+      llfio::file_handle dest = llfio::file_handle::temp_inode().value();
+      // Existing content is replaced
+      dest.truncate(16 * 1024 * 1024).value();
+      dest.write(4096, {{data.data(), data.size()}}).value();
+      auto copied = llfio::algorithm::copy_file(dest, src, threads, 64 * 1024);
+      BOOST_REQUIRE(copied);
+      std::cout << threads << " threads copied " << copied.value() << " bytes" << std::endl;
+      BOOST_CHECK(copied.value() <= size);
+      check(dest);
+    }
+    // Direct i/o
+    {
+      auto dest = llfio::file_handle::temp_inode(llfio::path_discovery::storage_backed_temporary_files_directory(), llfio::file_handle::mode::write).value();
+      auto destdirect = dest.clone(llfio::file_handle::mode::unchanged, llfio::file_handle::caching::only_metadata);
+      if(!destdirect)
+      {
+        std::cout << "Direct i/o is not supported here, skipping" << std::endl;
+        continue;
+      }
+      BOOST_REQUIRE(llfio::algorithm::copy_file(destdirect.value(), src, threads, 64 * 1024));
+      check(dest);
+    }
+  }
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, algorithm, copy_file, "Tests that llfio::algorithm::copy_file() works as expected", TestCopyFile())
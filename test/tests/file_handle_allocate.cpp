@@ -0,0 +1,98 @@
+/* Integration test kernel for file_handle space preallocation and range manipulation
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestFileHandleAllocate()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::temp_inode().value();
+  auto not_supported = [](const auto &r) { return r.has_error() && r.error() == llfio::errc::operation_not_supported; };
+  // Preallocation extends the file unless asked to keep its size
+  auto r = h.preallocate(0, 65536);
+  if(not_supported(r))
+  {
+    std::cout << "NOTE: preallocate() is not supported on this platform" << std::endl;
+    h.truncate(65536).value();
+  }
+  else
+  {
+    BOOST_CHECK(r.value() == 65536);
+    BOOST_CHECK(h.maximum_extent().value() == 65536);
+    r = h.preallocate(65536, 65536, true);
+    if(!not_supported(r))
+    {
+      BOOST_CHECK(r.value() == 65536);
+      BOOST_CHECK(h.maximum_extent().value() == 65536);
+    }
+  }
+
+  // Zero a range of data, which keeps the maximum extent
+  std::vector<llfio::byte> data(65536, llfio::to_byte(78));
+  for(size_t n = 0; n < 16; n++)
+  {
+    data[n * 4096] = llfio::to_byte(static_cast<unsigned char>(n));
+  }
+  h.write(0, {{data.data(), data.size()}}).value();
+  BOOST_CHECK(h.zero_range(8192, 8192).value() == 8192);
+  BOOST_CHECK(h.zero_range(60000, 65536).value() == 65536);
+  BOOST_CHECK(h.maximum_extent().value() == 65536);
+  std::vector<llfio::byte> readback(65536);
+  h.read(0, {{readback.data(), readback.size()}}).value();
+  for(size_t n = 0; n < readback.size(); n++)
+  {
+    bool zeroed = (n >= 8192 && n < 16384) || n >= 60000;
+    if(readback[n] != (zeroed ? llfio::to_byte(0) : data[n]))
+    {
+      BOOST_CHECK(readback[n] == (zeroed ? llfio::to_byte(0) : data[n]));
+      break;
+    }
+  }
+  h.write(0, {{data.data(), data.size()}}).value();
+
+  // Remove the second and third blocks, shifting everything after down
+  auto c = h.collapse_range(4096, 8192);
+  if(not_supported(c) || (c.has_error() && c.error() == llfio::errc::invalid_argument))
+  {
+    std::cout << "NOTE: collapse_range() is not supported by this platform or filing system" << std::endl;
+    return;
+  }
+  c.value();
+  BOOST_CHECK(h.maximum_extent().value() == 65536 - 8192);
+  h.read(0, {{readback.data(), 65536 - 8192}}).value();
+  BOOST_CHECK(readback[0] == llfio::to_byte(0));
+  BOOST_CHECK(readback[4096] == llfio::to_byte(3));
+  BOOST_CHECK(readback[8192] == llfio::to_byte(4));
+
+  // Put them back as a hole
+  h.insert_range(4096, 8192).value();
+  BOOST_CHECK(h.maximum_extent().value() == 65536);
+  h.read(0, {{readback.data(), readback.size()}}).value();
+  BOOST_CHECK(readback[4096] == llfio::to_byte(0));
+  BOOST_CHECK(readback[8192] == llfio::to_byte(0));
+  BOOST_CHECK(readback[12288] == llfio::to_byte(3));
+  BOOST_CHECK(readback[65535] == data[65535]);
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_allocate, file_handle, "Tests that llfio::file_handle::preallocate(), zero_range(), collapse_range() and insert_range() work as expected", TestFileHandleAllocate())
@@ -0,0 +1,95 @@
+/* Integration test kernel for file_handle::clone_extents_to()
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestFileHandleCloneExtents()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  // A 1Mb file with 64Kb of data at its start and at 512Kb, the rest being holes
+  llfio::file_handle src = llfio::file_handle::temp_inode().value();
+  std::vector<llfio::byte> data(65536);
+  for(size_t n = 0; n < data.size(); n++)
+  {
+    data[n] = static_cast<llfio::byte>(n % 251);
+  }
+  src.truncate(1024 * 1024).value();
+  src.write(0, {{data.data(), data.size()}}).value();
+  src.write(512 * 1024, {{data.data(), data.size()}}).value();
+  auto srcextents = src.extents().value();
+  const bool have_holes = srcextents.size() > 1;
+  auto check = [&](llfio::file_handle &h, llfio::file_handle::extent_type offset) {
+    std::vector<llfio::byte> in(1024 * 1024);
+    auto read = h.read(offset, {{in.data(), in.size()}}).value();
+    BOOST_REQUIRE(read == in.size());
+    BOOST_CHECK(0 == memcmp(in.data(), data.data(), data.size()));
+    BOOST_CHECK(0 == memcmp(in.data() + 512 * 1024, data.data(), data.size()));
+    for(size_t n = data.size(); n < 512 * 1024; n++)
+    {
+      if(in[n] != llfio::to_byte(0))
+      {
+        BOOST_CHECK(in[n] == llfio::to_byte(0));
+        break;
+      }
+    }
+  };
+  // Clone the whole file
+  {
+    llfio::file_handle dest = llfio::file_handle::temp_inode().value();
+    BOOST_CHECK(src.clone_extents_to(dest, 0, (llfio::file_handle::extent_type) -1 / 2, 0).value() == 1024 * 1024);
+    BOOST_CHECK(dest.maximum_extent().value() == 1024 * 1024);
+    check(dest, 0);
+    if(have_holes)
+    {
+      // The holes are preserved
+      llfio::file_handle::extent_type allocated = 0;
+      for(auto &i : dest.extents().value())
+      {
+        allocated += i.second;
+      }
+      std::cout << "Cloned file has " << allocated << " bytes of valid extents" << std::endl;
+      BOOST_CHECK(allocated < 1024 * 1024);
+    }
+  }
+  // Clone into the middle of a file already containing data, which must be overwritten
+  {
+    llfio::file_handle dest = llfio::file_handle::temp_inode().value();
+    std::vector<llfio::byte> junk(2 * 1024 * 1024, llfio::to_byte(78));
+    dest.write(0, {{junk.data(), junk.size()}}).value();
+    BOOST_CHECK(src.clone_extents_to(dest, 0, 1024 * 1024, 64 * 1024).value() == 1024 * 1024);
+    BOOST_CHECK(dest.maximum_extent().value() == 2 * 1024 * 1024);
+    check(dest, 64 * 1024);
+    llfio::byte c{};
+    dest.read(0, {{&c, 1}}).value();
+    BOOST_CHECK(c == llfio::to_byte(78));
+  }
+  // Cloning past the end of the source copies nothing, and overlapping ranges within a file are refused
+  {
+    llfio::file_handle dest = llfio::file_handle::temp_inode().value();
+    BOOST_CHECK(src.clone_extents_to(dest, 2 * 1024 * 1024, 4096, 0).value() == 0);
+    BOOST_CHECK(src.clone_extents_to(src, 0, 65536, 4096).error() == llfio::errc::invalid_argument);
+  }
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_clone_extents, file_handle, "Tests that llfio::file_handle::clone_extents_to() works as expected", TestFileHandleCloneExtents())
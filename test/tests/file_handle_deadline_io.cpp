@@ -0,0 +1,139 @@
+/* Integration test kernel for file_handle read and write with deadlines
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>  // for pipe
+#endif
+
+static inline void TestFileHandleDeadlineIo()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::temp_inode().value();
+  std::vector<llfio::byte> out(4 * 4096), in(4 * 4096);
+  for(size_t n = 0; n < out.size(); n++)
+  {
+    out[n] = static_cast<llfio::byte>(n % 251);
+  }
+  {
+    llfio::file_handle::const_buffer_type bufs[4] = {{out.data(), 4096}, {out.data() + 4096, 4096}, {out.data() + 8192, 4096}, {out.data() + 12288, 4096}};
+    auto written = h.write({bufs, 0}, std::chrono::seconds(10));
+    BOOST_REQUIRE(!written.has_error());
+    BOOST_CHECK(written.bytes_transferred() == out.size());
+  }
+  {
+    llfio::file_handle::buffer_type bufs[4] = {{in.data(), 4096}, {in.data() + 4096, 4096}, {in.data() + 8192, 4096}, {in.data() + 12288, 4096}};
+    auto read = h.read({bufs, 0}, std::chrono::seconds(10));
+    BOOST_REQUIRE(!read.has_error());
+    BOOST_CHECK(read.bytes_transferred() == in.size());
+    BOOST_CHECK(0 == memcmp(in.data(), out.data(), in.size()));
+  }
+  // Reading past the end with a deadline is a short read, not a timeout
+  {
+    llfio::file_handle::buffer_type bufs[2] = {{in.data(), 4096}, {in.data() + 4096, 4096}};
+    auto read = h.read({bufs, 3 * 4096}, std::chrono::seconds(10));
+    BOOST_REQUIRE(!read.has_error());
+    BOOST_CHECK(read.bytes_transferred() == 4096);
+  }
+  // More buffers than IOV_MAX, and more bytes than one bounce chunk, are done in batches
+  {
+    std::vector<llfio::byte> bigout(1500 * 2048), bigin(bigout.size());
+    for(size_t n = 0; n < bigout.size(); n++)
+    {
+      bigout[n] = static_cast<llfio::byte>((n / 2048 + n) % 253);
+    }
+    std::vector<llfio::file_handle::const_buffer_type> outbufs;
+    std::vector<llfio::file_handle::buffer_type> inbufs;
+    for(size_t n = 0; n < bigout.size(); n += 2048)
+    {
+      outbufs.emplace_back(bigout.data() + n, 2048);
+      inbufs.emplace_back(bigin.data() + n, 2048);
+    }
+    auto written = h.write({{outbufs.data(), outbufs.size()}, 65536}, std::chrono::seconds(10));
+    BOOST_REQUIRE(!written.has_error());
+    BOOST_CHECK(written.bytes_transferred() == bigout.size());
+    auto read = h.read({{inbufs.data(), inbufs.size()}, 65536}, std::chrono::seconds(10));
+    BOOST_REQUIRE(!read.has_error());
+    BOOST_CHECK(read.bytes_transferred() == bigin.size());
+    BOOST_CHECK(0 == memcmp(bigin.data(), bigout.data(), bigin.size()));
+  }
+  // A zero deadline either completes immediately from cache, or times out having done nothing
+  {
+    memset(in.data(), 0, in.size());
+    llfio::file_handle::buffer_type bufs[1] = {{in.data(), in.size()}};
+    auto read = h.read({bufs, 0}, std::chrono::seconds(0));
+    if(read)
+    {
+      BOOST_CHECK(0 == memcmp(in.data(), out.data(), read.bytes_transferred()));
+    }
+    else
+    {
+      BOOST_CHECK(read.error() == llfio::errc::timed_out);
+    }
+  }
+}
+
+#ifndef _WIN32
+static inline void TestPipeDeadlineIo()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  int fds[2];
+  BOOST_REQUIRE(-1 != ::pipe(fds));
+  // Only the read end is wrapped, the write end is closed by hand below
+  llfio::io_handle h(llfio::native_handle_type(llfio::native_handle_type::disposition::readable, fds[0]));
+  std::vector<llfio::byte> out(4096), in(2 * 4096);
+  memset(out.data(), 78, out.size());
+  BOOST_REQUIRE(4096 == ::write(fds[1], out.data(), out.size()));
+  // Only the first buffer can be filled, so the deadline returns it alone
+  {
+    llfio::io_handle::buffer_type bufs[2] = {{in.data(), 4096}, {in.data() + 4096, 4096}};
+    auto begin = std::chrono::steady_clock::now();
+    auto read = h.read({bufs, 0}, std::chrono::milliseconds(200));
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    BOOST_REQUIRE(!read.has_error());
+    BOOST_CHECK(read.bytes_transferred() == 4096);
+    BOOST_CHECK(0 == memcmp(in.data(), out.data(), 4096));
+    BOOST_CHECK(elapsed < std::chrono::seconds(5));
+  }
+  // Nothing can be read, and the read in progress cannot be cancelled, yet the deadline is honoured
+  {
+    llfio::io_handle::buffer_type bufs[1] = {{in.data(), 4096}};
+    auto begin = std::chrono::steady_clock::now();
+    auto read = h.read({bufs, 0}, std::chrono::milliseconds(100));
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    BOOST_REQUIRE(read.has_error());
+    BOOST_CHECK(read.error() == llfio::errc::timed_out);
+    BOOST_CHECK(elapsed >= std::chrono::milliseconds(100));
+    BOOST_CHECK(elapsed < std::chrono::seconds(5));
+  }
+  // Let the abandoned reads see end of file
+  ::close(fds[1]);
+}
+#endif
+
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_deadline_io, file_handle, "Tests that llfio::file_handle's read and write with deadlines work as expected", TestFileHandleDeadlineIo())
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_deadline_io, pipe, "Tests that read with a deadline from a pipe returns partial results or times out on time", TestPipeDeadlineIo())
+#endif
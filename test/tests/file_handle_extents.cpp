@@ -0,0 +1,143 @@
+/* Integration test kernel for file_handle::extents() and its cache
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestFileHandleExtents()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::temp_inode().value();
+  std::vector<llfio::byte> data(65536, llfio::to_byte(78));
+  // Many islands of data separated by holes
+  const size_t islands = 1000;
+  h.truncate(islands * 1024 * 1024).value();
+  for(size_t n = 0; n < islands; n++)
+  {
+    h.write(n * 1024 * 1024, {{data.data(), data.size()}}).value();
+  }
+  auto exts = h.extents().value();
+  std::cout << "The file has " << exts.size() << " extents" << std::endl;
+  llfio::file_handle::extent_type total = 0;
+  for(size_t n = 0; n < exts.size(); n++)
+  {
+    total += exts[n].second;
+    // Extents are sorted, do not overlap, and are never empty
+    BOOST_CHECK(exts[n].second > 0);
+    if(n > 0)
+    {
+      BOOST_CHECK(exts[n - 1].first + exts[n - 1].second <= exts[n].first);
+    }
+    BOOST_CHECK(exts[n].first + exts[n].second <= islands * 1024 * 1024);
+  }
+  if(exts.size() > 1)
+  {
+    // The filing system supports holes, so every island must be found
+    BOOST_CHECK(exts.size() == islands);
+    BOOST_CHECK(total >= islands * data.size());
+  }
+
+  // The cache returns the same extents, until invalidated by truncation
+  h.set_extents_cache(true).value();
+  BOOST_CHECK(h.extents_cache_enabled());
+  BOOST_CHECK(h.extents().value() == exts);
+  BOOST_CHECK(h.extents().value() == exts);
+  h.truncate(512 * 1024 * 1024).value();
+  auto truncated = h.extents().value();
+  BOOST_CHECK(truncated != exts);
+  BOOST_CHECK(truncated.back().first + truncated.back().second <= 512 * 1024 * 1024);
+  // Writes are not seen until the cache is invalidated
+  h.write(1024 * 1024 + 65536, {{data.data(), data.size()}}).value();
+  BOOST_CHECK(h.extents().value() == truncated);
+  h.invalidate_extents_cache();
+  if(truncated.size() > 1)
+  {
+    BOOST_CHECK(h.extents().value() != truncated);
+  }
+  // The cache moves with the handle
+  llfio::file_handle h2(std::move(h));
+  BOOST_CHECK(h2.extents_cache_enabled());
+  BOOST_CHECK(!h.extents_cache_enabled());
+  h2.set_extents_cache(false).value();
+  BOOST_CHECK(!h2.extents_cache_enabled());
+}
+
+static inline void TestFileHandleExtentsUnwritten()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::temp_inode().value();
+  if(!h.preallocate(0, 1024 * 1024))
+  {
+    std::cout << "NOTE: preallocate() is not supported here, skipping" << std::endl;
+    return;
+  }
+  auto exts = h.extents().value();
+  if(exts.size() == 1 && exts[0].first == 0 && exts[0].second == 1024 * 1024)
+  {
+    std::cout << "NOTE: The filing system reports preallocated extents as data, skipping" << std::endl;
+    return;
+  }
+  // Preallocated extents read as zeros, so they are holes
+  BOOST_CHECK(exts.empty());
+  // Until written into, even before writeback converts them
+  std::vector<llfio::byte> data(4096, llfio::to_byte(78));
+  h.write(65536, {{data.data(), data.size()}}).value();
+  exts = h.extents().value();
+  BOOST_REQUIRE(exts.size() == 1);
+  BOOST_CHECK(exts[0].first <= 65536);
+  BOOST_CHECK(exts[0].first + exts[0].second >= 65536 + data.size());
+  BOOST_CHECK(exts[0].second < 1024 * 1024);
+  // And the same once written back
+  h.barrier().value();
+  BOOST_CHECK(h.extents().value() == exts);
+  // Zeroed ranges are holes likewise
+  if(h.zero_range(0, 1024 * 1024))
+  {
+    exts = h.extents().value();
+    for(auto &ext : exts)
+    {
+      std::cout << "NOTE: zero_range() left extent " << ext.first << " +" << ext.second << " behind" << std::endl;
+    }
+  }
+  // Which are cloned as holes
+  llfio::file_handle h2 = llfio::file_handle::temp_inode().value();
+  h.write(65536, {{data.data(), data.size()}}).value();
+  h.clone_extents_to(h2, 0, 1024 * 1024, 0).value();
+  BOOST_CHECK(h2.maximum_extent().value() == 1024 * 1024);
+  auto exts2 = h2.extents().value();
+  if(exts2.size() != 1 || exts2[0].second != 1024 * 1024)
+  {
+    llfio::file_handle::extent_type total = 0;
+    for(auto &ext : exts2)
+    {
+      total += ext.second;
+    }
+    BOOST_CHECK(total < 1024 * 1024);
+  }
+  std::vector<llfio::byte> check(data.size());
+  h2.read(65536, {{check.data(), check.size()}}).value();
+  BOOST_CHECK(check == data);
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_extents, file_handle, "Tests that llfio::file_handle::extents() and its cache work as expected", TestFileHandleExtents())
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_extents, unwritten, "Tests that llfio::file_handle::extents() reports unwritten extents as holes", TestFileHandleExtentsUnwritten())
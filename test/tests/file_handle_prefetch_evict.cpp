@@ -0,0 +1,75 @@
+/* Integration test kernel for file_handle::prefetch(), evict() and flag::drop_behind
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestFileHandlePrefetchEvict()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::random_file(llfio::path_discovery::storage_backed_temporary_files_directory(), llfio::file_handle::mode::write, llfio::file_handle::caching::all, llfio::file_handle::flag::unlink_on_first_close).value();
+  std::vector<llfio::byte> data(1024 * 1024);
+  for(size_t n = 0; n < data.size(); n++)
+  {
+    data[n] = llfio::to_byte(static_cast<unsigned char>(n * 7));
+  }
+  h.write(0, {{data.data(), data.size()}}).value();
+  h.barrier({}, true).value();
+
+  // The whole file, then a single range
+  auto exts = h.extents().value();
+  auto prefetched = h.prefetch(exts).value();
+  BOOST_CHECK(prefetched.empty() || prefetched.size() == exts.size());
+  auto p = h.prefetch(65536, 65536).value();
+  BOOST_CHECK(p.first == 65536);
+  BOOST_CHECK(p.second == 0 || p.second == 65536);
+  auto e = h.evict(0, data.size()).value();
+  BOOST_CHECK(e.first == 0);
+  BOOST_CHECK(e.second == 0 || e.second == data.size());
+
+  // Evicted data still reads back correctly
+  std::vector<llfio::byte> readback(data.size());
+  BOOST_CHECK(h.read(0, {{readback.data(), readback.size()}}).value() == data.size());
+  BOOST_CHECK(readback == data);
+
+  // Streaming reads with drop behind return the same data, including when unaligned
+  auto path = h.current_path().value();
+  if(!path.empty())
+  {
+    llfio::file_handle h2 = llfio::file_handle::file({}, path, llfio::file_handle::mode::read, llfio::file_handle::creation::open_existing, llfio::file_handle::caching::all, llfio::file_handle::flag::drop_behind).value();
+    BOOST_CHECK(!!(h2.flags() & llfio::file_handle::flag::drop_behind));
+    std::fill(readback.begin(), readback.end(), llfio::to_byte(0));
+    for(size_t offset = 0; offset < readback.size();)
+    {
+      auto bytesread = h2.read(offset, {{readback.data() + offset, (std::min)(readback.size() - offset, static_cast<size_t>(10000))}}).value();
+      if(bytesread == 0)
+      {
+        break;
+      }
+      offset += bytesread;
+    }
+    BOOST_CHECK(readback == data);
+  }
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, file_handle_prefetch_evict, file_handle, "Tests that llfio::file_handle::prefetch(), evict() and flag::drop_behind work as expected", TestFileHandlePrefetchEvict())
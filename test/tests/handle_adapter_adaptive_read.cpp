@@ -0,0 +1,99 @@
+/* Integration test kernel for the adaptive read handle adapter
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../test_kernel_decl.hpp"
+
+static inline void TestAdaptiveReadHandleAdapter()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::algorithm::adaptive_read_handle_adapter<llfio::file_handle> h(llfio::file_handle::temp_inode().value(), 65536);
+  BOOST_CHECK(h.map_threshold() == 65536);
+  std::vector<llfio::byte> data(1024 * 1024);
+  for(size_t n = 0; n < data.size(); n++)
+  {
+    data[n] = llfio::to_byte(static_cast<unsigned char>(n * 7));
+  }
+  h.write(0, {{data.data(), data.size()}}).value();
+  BOOST_CHECK(!h.map().is_valid());
+
+  // A small read of cold data is done by syscall into the buffer supplied
+  llfio::byte buffer[4096];
+  auto r = h.read(4 * 65536 + 100, {{buffer, sizeof(buffer)}}).value();
+  BOOST_CHECK(r.size() == 1 && r[0].data() == buffer && r[0].size() == sizeof(buffer));
+  BOOST_CHECK(0 == memcmp(r[0].data(), data.data() + 4 * 65536 + 100, sizeof(buffer)));
+  BOOST_CHECK(h.syscall_reads() == 1 && h.mapped_reads() == 0);
+  BOOST_CHECK(!h.map().is_valid());
+
+  // Reading the same block again is served from the map
+  r = h.read(4 * 65536 + 200, {{buffer, sizeof(buffer)}}).value();
+  BOOST_CHECK(h.syscall_reads() == 1 && h.mapped_reads() == 1);
+  BOOST_CHECK(h.map().is_valid());
+  BOOST_CHECK(r[0].data() != buffer && r[0].size() == sizeof(buffer));
+  BOOST_CHECK(0 == memcmp(r[0].data(), data.data() + 4 * 65536 + 200, sizeof(buffer)));
+
+  // A large read is served from the map
+  std::vector<llfio::byte> large(256 * 1024);
+  r = h.read(65536, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(h.syscall_reads() == 1 && h.mapped_reads() == 2);
+  BOOST_CHECK(r[0].size() == large.size());
+  BOOST_CHECK(0 == memcmp(r[0].data(), data.data() + 65536, large.size()));
+  const auto before = r[0];
+
+  // Growing the file remaps it on the next large read beyond the old end
+  h.write(data.size(), {{data.data(), data.size()}}).value();
+  r = h.read(data.size() + 65536, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(h.mapped_reads() == 3);
+  BOOST_CHECK(h.map().length() >= 2 * data.size());
+  BOOST_CHECK(0 == memcmp(r[0].data(), data.data() + 65536, large.size()));
+  // Buffers returned from the old map remain valid
+  BOOST_CHECK(before.data() < h.map().address() || before.data() >= h.map().address() + h.map().length());
+  BOOST_CHECK(0 == memcmp(before.data(), data.data() + 65536, before.size()));
+
+  // Writes are seen by reads from the map
+  h.write(65536, {{buffer, sizeof(buffer)}}).value();
+  r = h.read(65536, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(0 == memcmp(r[0].data(), buffer, sizeof(buffer)));
+
+  // Shrinking the file drops the map, and reads beyond the end read nothing
+  h.truncate(2 * 65536).value();
+  BOOST_CHECK(!h.map().is_valid());
+  r = h.read(2 * 65536, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(r.size() == 0 || r[0].size() == 0);
+  // Buffers returned still read what remains of the file
+  BOOST_CHECK(0 == memcmp(before.data(), buffer, sizeof(buffer)));
+  BOOST_CHECK(0 == memcmp(before.data() + sizeof(buffer), data.data() + 65536 + sizeof(buffer), 65536 - sizeof(buffer)));
+  h.truncate(65536).value();
+
+  // The map moves with the handle
+  r = h.read(0, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(r[0].size() == 65536);
+  auto h2(std::move(h));
+  BOOST_CHECK(h2.map().is_valid());
+  r = h2.read(0, {{large.data(), large.size()}}).value();
+  BOOST_CHECK(r[0].size() == 65536);
+  BOOST_CHECK(!h.is_valid());
+  h2.close().value();
+  BOOST_CHECK(!h2.map().is_valid());
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, handle_adapter_adaptive_read, file_handle, "Tests that llfio::algorithm::adaptive_read_handle_adapter works as expected", TestAdaptiveReadHandleAdapter())
@@ -0,0 +1,78 @@
+/* Integration test kernel for the bounce buffering handle adapter
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestBounceBufferingHandleAdapter()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  auto _h = llfio::file_handle::random_file(llfio::path_discovery::storage_backed_temporary_files_directory(), llfio::file_handle::mode::write, llfio::file_handle::caching::none, llfio::file_handle::flag::unlink_on_first_close);
+  if(!_h)
+  {
+    std::cout << "NOTE: Uncached i/o is not supported by the temporary files directory, skipping test" << std::endl;
+    return;
+  }
+  // A small chunk size so requests are split
+  llfio::algorithm::bounce_buffering_handle_adapter<llfio::file_handle> h(std::move(_h).value(), 8192);
+  BOOST_REQUIRE(h.requires_aligned_io());
+  BOOST_CHECK(h.offset_alignment() > 1);
+  std::cout << "Memory alignment is " << h.memory_alignment() << ", offset alignment is " << h.offset_alignment() << std::endl;
+
+  // Mirror every write into a shadow copy, and check reads against it
+  std::vector<llfio::byte> shadow;
+  auto do_write = [&](size_t offset, size_t length, unsigned char value) {
+    std::vector<llfio::byte> data(length + 1, llfio::to_byte(value));
+    // Deliberately misalign the memory as well
+    BOOST_CHECK(h.write(offset, {{data.data() + 1, length}}).value() == length);
+    if(shadow.size() < offset + length)
+    {
+      shadow.resize(offset + length);
+    }
+    memset(shadow.data() + offset, value, length);
+    BOOST_CHECK(h.maximum_extent().value() == shadow.size());
+  };
+  do_write(0, 100, 1);
+  do_write(50, 20000, 2);
+  do_write(10000, 5, 3);
+  do_write(19990, 300, 4);
+  do_write(30000, 1, 5);
+  BOOST_CHECK(h.maximum_extent().value() == 30001);
+
+  std::vector<llfio::byte> readback(shadow.size() + 4097);
+  const std::pair<size_t, size_t> reads[] = {{0, 30001}, {1, 100}, {4095, 8194}, {29000, 5000}};
+  for(const auto &offset_length : reads)
+  {
+    auto bytesread = h.read(offset_length.first, {{readback.data() + 1, offset_length.second}}).value();
+    size_t expected = (std::min)(offset_length.second, shadow.size() - offset_length.first);
+    BOOST_CHECK(bytesread == expected);
+    BOOST_CHECK(0 == memcmp(readback.data() + 1, shadow.data() + offset_length.first, expected));
+  }
+
+  // Aligned i/o passes straight through
+  auto *aligned = reinterpret_cast<llfio::byte *>(llfio::utils::round_up_to_page_size(reinterpret_cast<uintptr_t>(readback.data()), 4096));
+  BOOST_CHECK(h.read(0, {{aligned, 4096}}).value() == 4096);
+  BOOST_CHECK(0 == memcmp(aligned, shadow.data(), 4096));
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, handle_adapter_bounce_buffering, file_handle, "Tests that llfio::algorithm::bounce_buffering_handle_adapter makes unaligned uncached i/o work", TestBounceBufferingHandleAdapter())
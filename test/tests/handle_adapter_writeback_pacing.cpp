@@ -0,0 +1,68 @@
+/* Integration test kernel for the writeback pacing handle adapter
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestWritebackPacingHandleAdapter()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  static constexpr size_t window = 1024 * 1024;
+  llfio::algorithm::writeback_pacing_handle_adapter<llfio::file_handle> h(llfio::file_handle::temp_inode().value(), window, true);
+  BOOST_CHECK(h.writeback_window() == window);
+  BOOST_CHECK(h.writeback_throttled());
+  std::vector<llfio::byte> data(65536, llfio::to_byte(78));
+  // Sixteen windows sequentially, then a window's worth of random writes
+  for(size_t n = 0; n < 16 * window / data.size(); n++)
+  {
+    BOOST_CHECK(h.write(n * data.size(), {{data.data(), data.size()}}).value() == data.size());
+  }
+  BOOST_CHECK(h.writebacks() == 16);
+  for(size_t n = 0; n < window / data.size(); n++)
+  {
+    h.write(((n * 7) % 16) * window, {{data.data(), data.size()}}).value();
+  }
+  BOOST_CHECK(h.writebacks() == 17);
+  BOOST_CHECK(h.maximum_extent().value() == 16 * window);
+  h.barrier().value();
+
+  // What was written is what is read back
+  std::vector<llfio::byte> readback(data.size());
+  h.read(15 * window, {{readback.data(), readback.size()}}).value();
+  BOOST_CHECK(readback == data);
+
+  // Disabling pacing passes writes straight through
+  h.set_writeback_pacing(0);
+  h.write(0, {{data.data(), data.size()}}).value();
+  BOOST_CHECK(h.writebacks() == 17);
+
+  // The pacing moves with the handle
+  h.set_writeback_pacing(window);
+  auto h2(std::move(h));
+  BOOST_CHECK(h2.writeback_window() == window);
+  BOOST_CHECK(!h2.writeback_throttled());
+  BOOST_CHECK(h2.is_valid());
+  BOOST_CHECK(!h.is_valid());
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, handle_adapter_writeback_pacing, file_handle, "Tests that llfio::algorithm::writeback_pacing_handle_adapter works as expected", TestWritebackPacingHandleAdapter())
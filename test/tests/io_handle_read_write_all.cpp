@@ -0,0 +1,80 @@
+/* Integration test kernel for io_handle::read_all() and write_all()
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestIoHandleReadWriteAll()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  llfio::file_handle h = llfio::file_handle::temp_inode().value();
+  // Far more buffers than IOV_MAX, of varying sizes
+  static constexpr size_t records = 5000;
+  std::vector<std::vector<llfio::byte>> data(records);
+  std::vector<llfio::file_handle::const_buffer_type> wbuffers(records);
+  size_t total = 0;
+  for(size_t n = 0; n < records; n++)
+  {
+    data[n].resize(1 + (n % 37), llfio::to_byte(static_cast<unsigned char>(n)));
+    wbuffers[n] = {data[n].data(), data[n].size()};
+    total += data[n].size();
+  }
+  BOOST_CHECK(h.write({{wbuffers.data(), wbuffers.size()}, 0}).has_error());
+  auto written = h.write_all({{wbuffers.data(), wbuffers.size()}, 0});
+  BOOST_REQUIRE(written);
+  BOOST_CHECK(written.value().size() == records);
+  BOOST_CHECK(written.bytes_transferred() == total);
+  BOOST_CHECK(h.maximum_extent().value() == total);
+
+  // Read it all back, plus a buffer past the end of the file
+  std::vector<llfio::byte> readback(total + 100);
+  std::vector<llfio::file_handle::buffer_type> rbuffers(records + 1);
+  for(size_t n = 0, offset = 0; n < records; n++)
+  {
+    rbuffers[n] = {readback.data() + offset, data[n].size()};
+    offset += data[n].size();
+  }
+  rbuffers[records] = {readback.data() + total, 100};
+  auto r = h.read_all({{rbuffers.data(), rbuffers.size()}, 0});
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(r.bytes_transferred() == total);
+  for(size_t n = 0; n < records; n++)
+  {
+    if(0 != memcmp(r.value()[n].data(), data[n].data(), data[n].size()))
+    {
+      BOOST_CHECK(0 == memcmp(r.value()[n].data(), data[n].data(), data[n].size()));
+      break;
+    }
+  }
+
+  // A read straddling the end of the file is trimmed
+  rbuffers[0] = {readback.data(), 64};
+  rbuffers[1] = {readback.data() + 64, 64};
+  r = h.read_all({{rbuffers.data(), 2}, total - 100});
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(r.value().size() == 2);
+  BOOST_CHECK(r.value()[1].size() == 36);
+  BOOST_CHECK(r.bytes_transferred() == 100);
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, io_handle_read_write_all, io_handle, "Tests that llfio::io_handle::read_all() and write_all() complete arbitrarily large requests", TestIoHandleReadWriteAll())
@@ -100,6 +100,55 @@ static inline void TestLargeFileMappedPages()
   mh.write(0, {{(const byte *) "hello world", 11}}).value();
 }
 
+static inline void TestTransparentHugePages()
+{
+  using namespace LLFIO_V2_NAMESPACE;
+  using LLFIO_V2_NAMESPACE::file_handle;
+  using LLFIO_V2_NAMESPACE::byte;
+#ifndef __linux__
+  BOOST_TEST_MESSAGE("Transparent huge pages are only supported on Linux. So skipping this test.");
+#else
+  static constexpr size_t thpsize = 2 * 1024 * 1024;
+  if(utils::page_size() != 4096)
+  {
+    BOOST_TEST_MESSAGE("Transparent huge pages are not 2Mb on this hardware. So skipping this test.");
+    return;
+  }
+  // Anonymous memory is allocated in huge page multiples at huge page aligned addresses
+  map_handle mh(map_handle::map(3 * 1024 * 1024, false, section_handle::flag::readwrite | section_handle::flag::transparent_huge_pages).value());
+  BOOST_CHECK(mh.page_size() == utils::page_size());
+  BOOST_CHECK(mh.length() % thpsize == 0);
+  BOOST_CHECK(((uintptr_t) mh.address() % thpsize) == 0);
+  memset(mh.address(), 78, mh.length());
+  auto stats = mh.page_usage().value();
+  BOOST_CHECK(stats.resident >= mh.length());
+  if(stats.large_pages == 0)
+  {
+    BOOST_TEST_MESSAGE("Transparent huge pages appear to be disabled on this system.");
+  }
+  else
+  {
+    BOOST_CHECK(stats.page_size >= thpsize);
+  }
+
+  // File maps are placed at addresses congruent to their offset
+  file_handle fh = file_handle::file({}, "testfile", file_handle::mode::write, file_handle::creation::if_needed, file_handle::caching::all, file_handle::flag::unlink_on_first_close).value();
+  fh.truncate(4 * thpsize).value();
+  section_handle sh(section_handle::section(fh, 0, section_handle::flag::readwrite).value());
+  map_handle fmh(map_handle::map(sh, 2 * thpsize, thpsize / 2, section_handle::flag::readwrite | section_handle::flag::transparent_huge_pages).value());
+  BOOST_CHECK(((uintptr_t) fmh.address() % thpsize) == thpsize / 2);
+  fmh.write(0, {{(const byte *) "hello world", 11}}).value();
+  BOOST_CHECK(fmh.page_usage().value().resident > 0);
+
+  // Maps without the flag are also observable
+  map_handle smh(map_handle::map(65536).value());
+  smh.address()[0] = to_byte(78);
+  stats = smh.page_usage().value();
+  BOOST_CHECK(stats.resident >= utils::page_size());
+#endif
+}
+
 KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, large_mem_mapped_pages, "Tests that large page support for allocating memory works as expected", TestLargeMemMappedPages())
 KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, large_kernel_mapped_pages, "Tests that large page support for mapping kernel memory works as expected", TestLargeKernelMappedPages())
 KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, large_file_mapped_pages, "Tests that large page support for mapping files works as expected", TestLargeFileMappedPages())
+KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, transparent_huge_pages, "Tests that transparent huge page support for maps works as expected", TestTransparentHugePages())
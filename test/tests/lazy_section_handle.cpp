@@ -0,0 +1,118 @@
+/* Integration test kernel for lazy_section_handle
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../test_kernel_decl.hpp"
+
+static inline void TestLazySectionHandle()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  using llfio::byte;
+  static constexpr size_t bytes = 1024 * 1024, granularity = 65536;
+  // Fill every eight bytes with their offset, except for the last block which is left zero
+  auto sh_ = llfio::lazy_section_handle::lazy(
+  bytes,
+  [](llfio::lazy_section_handle::extent_type offset, llfio::lazy_section_handle::buffer_type buffer) -> size_t {
+    if(offset >= bytes - granularity)
+    {
+      return 0;
+    }
+    auto *p = reinterpret_cast<uint64_t *>(buffer.data());
+    for(size_t n = 0; n < buffer.size() / 8; n++)
+    {
+      p[n] = offset + n * 8;
+    }
+    return buffer.size();
+  },
+  granularity);
+  if(!sh_)
+  {
+    std::cout << "NOTE: lazy_section_handle is not available on this system, failed with " << sh_.error().message() << std::endl;
+    return;
+  }
+  auto &sh = sh_.value();
+  BOOST_CHECK(sh.fill_granularity() == granularity);
+  BOOST_CHECK(sh.fills() == 0);
+  auto mh1 = llfio::map_handle::map(sh).value();
+  auto mh2 = llfio::map_handle::map(sh, 0, 0).value();
+  auto *p1 = reinterpret_cast<volatile uint64_t *>(mh1.address());
+  auto *p2 = reinterpret_cast<volatile uint64_t *>(mh2.address());
+
+  // First touch fills the whole block
+  BOOST_CHECK(p1[100] == 800);
+  BOOST_CHECK(sh.fills() == 1);
+  BOOST_CHECK(p1[granularity / 8 - 1] == granularity - 8);
+  BOOST_CHECK(sh.fills() == 1);
+  // Other maps see the same filled pages without filling again
+  BOOST_CHECK(p2[100] == 800);
+  BOOST_CHECK(sh.fills() == 1);
+  BOOST_CHECK(p2[(5 * granularity) / 8 + 3] == 5 * granularity + 24);
+  BOOST_CHECK(sh.fills() == 2);
+  // Writes persist, and are seen by other maps
+  p1[(7 * granularity) / 8] = 78;
+  BOOST_CHECK(sh.fills() == 3);
+  BOOST_CHECK(p2[(7 * granularity) / 8] == 78);
+  BOOST_CHECK(p2[(7 * granularity) / 8 + 1] == 7 * granularity + 8);
+  // A fill of nothing reads as zero
+  BOOST_CHECK(p1[(bytes - 8) / 8] == 0);
+  BOOST_CHECK(sh.fills() == 4);
+
+  // A map at an offset fills relative to the section, not the map
+  auto mh3 = llfio::map_handle::map(sh, granularity, 9 * granularity).value();
+  auto *p3 = reinterpret_cast<volatile uint64_t *>(mh3.address());
+  BOOST_CHECK(p3[1] == 9 * granularity + 8);
+  BOOST_CHECK(sh.fills() == 5);
+  // A map not starting on a block boundary still fills the whole block, and only once
+  {
+    auto mh5 = llfio::map_handle::map(sh, 4096, 13 * granularity + 4096).value();
+    BOOST_CHECK(reinterpret_cast<volatile uint64_t *>(mh5.address())[1] == 13 * granularity + 4096 + 8);
+    BOOST_CHECK(sh.fills() == 6);
+    BOOST_CHECK(p2[(13 * granularity) / 8] == 13 * granularity);
+    BOOST_CHECK(sh.fills() == 6);
+  }
+
+  // The section can be moved while maps of it are live
+  auto sh2(std::move(sh));
+  BOOST_CHECK(p2[(11 * granularity) / 8] == 11 * granularity);
+  BOOST_CHECK(sh2.fills() == 7);
+  // But existing maps cannot be moved, as they still refer to the moved from section
+  auto moved = mh3.truncate(2 * granularity, true);
+  BOOST_CHECK(!moved);
+  if(!moved)
+  {
+    BOOST_CHECK(moved.error() == llfio::errc::bad_file_descriptor);
+  }
+  // The failed move leaves the map as it was
+  BOOST_CHECK(mh3.address() == reinterpret_cast<byte *>(const_cast<uint64_t *>(p3)));
+  BOOST_CHECK(mh3.capacity() == granularity);
+  // Whereas new maps of the moved to section are filled
+  auto mh4 = llfio::map_handle::map(sh2, granularity, 12 * granularity).value();
+  BOOST_CHECK(reinterpret_cast<volatile uint64_t *>(mh4.address())[1] == 12 * granularity + 8);
+  BOOST_CHECK(sh2.fills() == 8);
+  mh4.close().value();
+  mh1.close().value();
+  mh2.close().value();
+  mh3.close().value();
+  sh2.close().value();
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, lazy_section_handle, fill, "Tests that llfio::lazy_section_handle works as expected", TestLazySectionHandle())
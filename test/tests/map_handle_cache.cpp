@@ -0,0 +1,92 @@
+/* Integration test kernel for the cache of freed anonymous maps
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../test_kernel_decl.hpp"
+
+static inline void TestMapHandleCache()
+{
+  using namespace LLFIO_V2_NAMESPACE;
+  using LLFIO_V2_NAMESPACE::byte;
+  const size_t capacity = map_handle::set_cache_capacity(64 * 1024 * 1024);
+  auto stats = map_handle::trim_cache(std::chrono::steady_clock::now());
+  BOOST_CHECK(stats.items_in_cache == 0);
+  BOOST_CHECK(stats.bytes_in_cache == 0);
+  const size_t hits = stats.hits, misses = stats.misses;
+  byte *addr;
+  {
+    auto mh = map_handle::map(1024 * 1024).value();
+    addr = mh.address();
+    memset(addr, 78, mh.length());
+  }
+  stats = map_handle::trim_cache();
+#if defined(_WIN32) || !defined(MADV_FREE)
+  BOOST_CHECK(stats.items_in_cache == 0);
+  (void) hits;
+  (void) misses;
+#else
+  BOOST_CHECK(stats.items_in_cache == 1);
+  BOOST_CHECK(stats.bytes_in_cache == 1024 * 1024);
+  BOOST_CHECK(stats.misses == misses + 1);
+  {
+    // A map of a different size, or which must be zeroed, is not recycled
+    auto mh1 = map_handle::map(512 * 1024).value();
+    auto mh2 = map_handle::map(1024 * 1024, true).value();
+    BOOST_CHECK(mh1.address() != addr);
+    BOOST_CHECK(mh2.address() != addr);
+    BOOST_CHECK(mh2.address()[0] == to_byte(0));
+    // A map of the same size is recycled, and is fully usable
+    auto mh3 = map_handle::map(1024 * 1024).value();
+    BOOST_CHECK(mh3.address() == addr);
+    BOOST_CHECK(mh3.length() == 1024 * 1024);
+    mh3.address()[mh3.length() - 1] = to_byte(5);
+    BOOST_CHECK(mh3.address()[mh3.length() - 1] == to_byte(5));
+    stats = map_handle::trim_cache();
+    BOOST_CHECK(stats.items_in_cache == 0);
+    BOOST_CHECK(stats.hits == hits + 1);
+    BOOST_CHECK(stats.misses == misses + 2);
+  }
+  stats = map_handle::trim_cache();
+  BOOST_CHECK(stats.items_in_cache == 3);
+  BOOST_CHECK(stats.bytes_in_cache == 2560 * 1024);
+
+  // Reducing the capacity trims least recently freed first
+  map_handle::set_cache_capacity(1024 * 1024);
+  stats = map_handle::trim_cache();
+  BOOST_CHECK(stats.bytes_in_cache <= 1024 * 1024);
+  // Maps larger than the capacity are not cached
+  map_handle::map(2 * 1024 * 1024).value().close().value();
+  BOOST_CHECK(map_handle::trim_cache().bytes_in_cache <= 1024 * 1024);
+
+  // Maps which have been decommitted are not cached
+  map_handle::set_cache_capacity(64 * 1024 * 1024);
+  map_handle::trim_cache(std::chrono::steady_clock::now());
+  {
+    auto mh = map_handle::map(1024 * 1024).value();
+    mh.decommit({mh.address(), mh.page_size()}).value();
+  }
+  BOOST_CHECK(map_handle::trim_cache().items_in_cache == 0);
+#endif
+  map_handle::set_cache_capacity(capacity);
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, cache, "Tests that the cache of freed anonymous maps works as expected", TestMapHandleCache())
@@ -0,0 +1,83 @@
+/* Integration test kernel for map_handle::populate()
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include "../test_kernel_decl.hpp"
+
+static inline void TestMapHandlePopulate()
+{
+  using namespace LLFIO_V2_NAMESPACE;
+  using LLFIO_V2_NAMESPACE::byte;
+  static constexpr size_t bytes = 160 * 1024 * 1024;
+  map_handle mh(map_handle::map(bytes).value());
+  size_t calls = 0;
+  map_handle::size_type last = 0;
+  auto stats = map_handle::populate({mh.address(), mh.length()}, true, 4, [&](const map_handle::populate_statistics &s) {
+                 ++calls;
+                 BOOST_CHECK(s.bytes_populated > last);
+                 BOOST_CHECK(s.bytes_total == bytes);
+                 last = s.bytes_populated;
+               }).value();
+  BOOST_CHECK(stats.bytes_total == bytes);
+  BOOST_CHECK(stats.bytes_populated == bytes);
+  BOOST_CHECK(stats.threads == 3);  // only three chunks to populate
+  BOOST_CHECK(calls == 3);
+  BOOST_CHECK(last == bytes);
+  BOOST_CHECK(stats.gb_per_sec() > 0);
+  std::cout << "Populated " << (bytes / 1024 / 1024) << "Mb with " << stats.threads << " threads at " << stats.gb_per_sec() << " Gb/sec" << std::endl;
+#ifdef __linux__
+  {
+    // Exactly this map is counted, not the neighbours the kernel merged it with
+    auto usage = mh.page_usage().value();
+    BOOST_CHECK(usage.resident >= bytes);
+    BOOST_CHECK(usage.resident <= mh.capacity());
+    BOOST_CHECK(usage.large_pages <= usage.resident);
+  }
+#endif
+  // Contents are unchanged by populating for write
+  BOOST_CHECK(mh.address()[0] == to_byte(0));
+  BOOST_CHECK(mh.address()[bytes - 1] == to_byte(0));
+
+  // Unaligned regions of a file map are populated from the page containing their start to the page containing their end
+  file_handle fh = file_handle::temp_inode().value();
+  fh.truncate(1024 * 1024).value();
+  section_handle sh(section_handle::section(fh).value());
+  map_handle fmh(map_handle::map(sh).value());
+  map_handle::buffer_type regions[] = {{fmh.address() + 100, 5000}, {fmh.address() + 512 * 1024, 1}};
+  stats = map_handle::populate(regions).value();
+  BOOST_CHECK(stats.bytes_total == 3 * utils::page_size() || (utils::page_size() > 4096 && stats.bytes_total == 2 * utils::page_size()));
+  BOOST_CHECK(stats.bytes_populated == stats.bytes_total);
+  BOOST_CHECK(stats.threads >= 1 && stats.threads <= 2);
+
+  // Regions which cannot be faulted in fail, rather than raising a signal
+  map_handle nmh(map_handle::map(utils::page_size() * 4, false, section_handle::flag::none).value());
+  auto failed = map_handle::populate({nmh.address(), nmh.length()});
+  BOOST_REQUIRE(!failed);
+  BOOST_CHECK(failed.error() == errc::bad_address);
+  map_handle rmh(map_handle::map(utils::page_size() * 4, false, section_handle::flag::read).value());
+  BOOST_CHECK(map_handle::populate({rmh.address(), rmh.length()}, false));
+  failed = map_handle::populate({rmh.address(), rmh.length()}, true);
+  BOOST_REQUIRE(!failed);
+  BOOST_CHECK(failed.error() == errc::bad_address);
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, map_handle, populate, "Tests that map_handle::populate() works as expected", TestMapHandlePopulate())
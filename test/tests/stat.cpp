@@ -0,0 +1,70 @@
+/* Integration test kernel for stat_t::fill() filling only what is wanted
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+static inline void TestStatFillWanted()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  auto dh = llfio::directory_handle::random_directory(llfio::path_discovery::storage_backed_temporary_files_directory()).value();
+  auto h = llfio::file_handle::file(dh, "testfile", llfio::file_handle::mode::write, llfio::file_handle::creation::if_needed).value();
+  std::vector<llfio::byte> data(12345, llfio::to_byte(78));
+  h.write(0, {{data.data(), data.size()}}).value();
+
+  // Asking for only some fields fills only those fields
+  llfio::stat_t s(nullptr);
+  BOOST_CHECK(s.fill(h, llfio::stat_t::want::size | llfio::stat_t::want::mtim).value() == 2);
+  BOOST_CHECK(s.st_size == data.size());
+  BOOST_CHECK(s.st_mtim != std::chrono::system_clock::time_point());
+  BOOST_CHECK(s.st_ino == 0);
+  BOOST_CHECK(s.st_type == llfio::filesystem::file_type::unknown);
+
+  // Asking for everything fills at least the fields every platform has
+  llfio::stat_t all(nullptr);
+  BOOST_CHECK(all.fill(h).value() >= 12);
+  BOOST_CHECK(all.st_size == data.size());
+  BOOST_CHECK(all.st_type == llfio::filesystem::file_type::regular);
+  BOOST_CHECK(all.st_ino == h.unique_id().as_longlongs[1]);
+  if(all.st_birthtim != std::chrono::system_clock::time_point())
+  {
+    BOOST_CHECK(all.st_birthtim <= all.st_mtim);
+  }
+  else
+  {
+    std::cout << "NOTE: This platform or filing system does not provide birth times" << std::endl;
+  }
+
+  // A single entry directory read is a stat, and reports the fields it filled
+  llfio::directory_entry entry;
+  auto filled = dh.read({{&entry, 1}, "testfile"}).value();
+  BOOST_REQUIRE(filled.size() == 1);
+  BOOST_CHECK(!!(filled.metadata() & llfio::stat_t::want::size));
+  BOOST_CHECK(filled[0].stat.st_size == data.size());
+  BOOST_CHECK(filled[0].stat.st_ino == all.st_ino);
+
+  h.unlink().value();
+  dh.unlink().value();
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, stat, stat_t, "Tests that llfio::stat_t::fill() fills only the fields wanted", TestStatFillWanted())
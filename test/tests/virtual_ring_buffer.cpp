@@ -0,0 +1,141 @@
+/* Integration test kernel for algorithm::basic_virtual_ring_buffer
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../test_kernel_decl.hpp"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static inline void TestVirtualRingBufferWrap()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  using llfio::byte;
+  auto rb = llfio::algorithm::spsc_virtual_ring_buffer::ring_buffer(1).value();
+  const size_t capacity = rb.capacity();
+  BOOST_CHECK(capacity >= 65536);
+  const size_t chunk = capacity * 5 / 8;
+  std::vector<byte> pattern(chunk);
+  for(size_t n = 0; n < chunk; n++)
+  {
+    pattern[n] = static_cast<byte>(n % 251);
+  }
+  for(size_t round = 0; round < 4; round++)
+  {
+    auto w = rb.reserve(chunk).value();
+    BOOST_CHECK(w.size() == chunk);
+    memcpy(w.data(), pattern.data(), chunk);
+    rb.commit(w);
+    // A second chunk cannot fit until the first is consumed
+    auto full = rb.reserve(chunk);
+    BOOST_CHECK(!full);
+    BOOST_CHECK(full.error() == llfio::errc::resource_unavailable_try_again);
+    auto r = rb.readable();
+    BOOST_CHECK(r.size() == chunk);
+    // From round 1 onwards the chunk straddles the end of the storage, yet reads back contiguously
+    BOOST_CHECK(0 == memcmp(r.data(), pattern.data(), chunk));
+    rb.consume(chunk);
+    BOOST_CHECK(rb.size() == 0);
+  }
+  BOOST_CHECK(rb.reserve(capacity + 1).error() == llfio::errc::argument_out_of_domain);
+}
+
+static inline void TestVirtualRingBufferMPSC()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  static constexpr size_t producers = 4, items = 100000;
+  auto rb = llfio::algorithm::mpsc_virtual_ring_buffer::ring_buffer(65536).value();
+  std::vector<std::thread> threads;
+  for(uint64_t t = 0; t < producers; t++)
+  {
+    threads.emplace_back([&rb, t] {
+      for(uint64_t n = 0; n < items; n++)
+      {
+        for(;;)
+        {
+          auto w = rb.reserve(sizeof(uint64_t));
+          if(w)
+          {
+            const uint64_t v = (t << 32U) | n;
+            memcpy(w.value().data(), &v, sizeof(v));
+            rb.commit(w.value());
+            break;
+          }
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::vector<uint64_t> next(producers, 0);
+  size_t received = 0;
+  bool ordered = true;
+  while(received < producers * items)
+  {
+    auto r = rb.readable();
+    const size_t count = r.size() / sizeof(uint64_t);
+    for(size_t n = 0; n < count; n++)
+    {
+      uint64_t v;
+      memcpy(&v, r.data() + n * sizeof(uint64_t), sizeof(v));
+      auto &expected = next[v >> 32U];
+      ordered = ordered && ((v & 0xffffffffU) == expected);
+      expected++;
+    }
+    rb.consume(count * sizeof(uint64_t));
+    received += count;
+  }
+  for(auto &t : threads)
+  {
+    t.join();
+  }
+  BOOST_CHECK(ordered);
+  BOOST_CHECK(rb.size() == 0);
+}
+
+static inline void TestVirtualRingBufferShared()
+{
+  namespace llfio = LLFIO_V2_NAMESPACE;
+  auto fh = llfio::file_handle::temp_file().value();
+  // Two attachments to the same file stand in for two processes
+  auto producer = llfio::algorithm::spsc_virtual_ring_buffer::ring_buffer(fh, 65536).value();
+  auto consumer = llfio::algorithm::spsc_virtual_ring_buffer::ring_buffer(fh).value();
+  BOOST_CHECK(consumer.capacity() == producer.capacity());
+  auto w = producer.reserve(6).value();
+  memcpy(w.data(), "niall", 6);
+  producer.commit(w);
+  auto r = consumer.readable();
+  BOOST_REQUIRE(r.size() == 6);
+  BOOST_CHECK(0 == strcmp(reinterpret_cast<const char *>(r.data()), "niall"));
+  consumer.consume(6);
+  BOOST_CHECK(producer.size() == 0);
+
+  // Attaching to something which is not a ring buffer fails
+  auto fh2 = llfio::file_handle::temp_file().value();
+  fh2.truncate(256 * 1024).value();
+  BOOST_CHECK(!llfio::algorithm::spsc_virtual_ring_buffer::ring_buffer(fh2));
+}
+
+KERNELTEST_TEST_KERNEL(integration, llfio, algorithm, virtual_ring_buffer_wrap, "Tests that the virtual ring buffer presents data across the wrap point contiguously", TestVirtualRingBufferWrap())
+KERNELTEST_TEST_KERNEL(integration, llfio, algorithm, virtual_ring_buffer_mpsc, "Tests that the virtual ring buffer preserves ordering with multiple producers", TestVirtualRingBufferMPSC())
+KERNELTEST_TEST_KERNEL(integration, llfio, algorithm, virtual_ring_buffer_shared, "Tests that the virtual ring buffer can be shared through a file", TestVirtualRingBufferShared())